@@ -2,27 +2,110 @@
 
 #include "../data/exchange.h"
 #include "./order.h"
+#include "./bookhistory.h"
+#include "./depthtree.h"
+#include "./orderqueue.h"
+#include "./priceladder.h"
 
-#include <map>
-#include <queue>
 #include <utility>
 
 using namespace std;
 
+/**
+ * Depth policy of a book keeping every level it sees.
+ */
+struct FullDepth {
+    static constexpr size_t max_levels = 0;                         /*< Levels kept per side; 0 for no bound */
+    static constexpr size_t window_ticks = PRICE_LADDER_MAX_TICKS;  /*< Maximum ticks of the ladder windows */
+};
+
+/**
+ * Depth policy of a book keeping the best N levels of each side. Levels holding our orders are kept whatever their
+ * rank. The ladder windows are sized for the levels kept, so a small book stays small.
+ */
+template <size_t N>
+struct TopLevels {
+    static_assert(N > 0, "A book keeps at least one level per side");
+    static constexpr size_t max_levels = N;
+    static constexpr size_t window_ticks = N * 64 < PRICE_LADDER_MAX_TICKS ? N * 64 : PRICE_LADDER_MAX_TICKS;
+};
+
+/**
+ * Depth policy of a book keeping the best bid and ask only (L1).
+ */
+using TopOfBook = TopLevels<1>;
+
+/**
+ * Number of best levels of each side that the depth features of a book cover.
+ */
+constexpr size_t BOOK_FEATURE_LEVELS = 5;
+
+/**
+ * Microstructure features of a book, kept up to date by the book as it changes. Sizes count our orders.
+ */
+struct BookFeatures {
+    double bid_price = -1.0;        /*< Best bid price, or -1 if there are no bids */
+    double bid_size = 0.0;          /*< Total size at the best bid */
+    double ask_price = -1.0;        /*< Best ask price, or -1 if there are no asks */
+    double ask_size = 0.0;          /*< Total size at the best ask */
+    double spread = -1.0;           /*< Best ask minus best bid, or -1 unless both sides have levels */
+    double mid = -1.0;              /*< Average of the best bid and ask, or -1 unless both sides have levels */
+    double microprice = -1.0;       /*< Best bid and ask weighted by the size on the other side, or -1 likewise */
+    double imbalance = 0.0;         /*< (bid_size - ask_size) / (bid_size + ask_size), or 0 unless both sides have levels */
+    double bid_depth = 0.0;         /*< Total size of the best BOOK_FEATURE_LEVELS bids */
+    double ask_depth = 0.0;         /*< Total size of the best BOOK_FEATURE_LEVELS asks */
+    double depth_imbalance = 0.0;   /*< (bid_depth - ask_depth) / (bid_depth + ask_depth), or 0 likewise */
+    double weighted_mid = -1.0;     /*< Average of the size-weighted prices of bid_depth and ask_depth, or -1 likewise */
+};
+
+
 /**
  * Class for orderbook.
+ * Bid and ask levels are kept in two PriceLadders indexed by tick, using the tick size (trading rule 0) of the
+ * security on the exchange; prices are snapped to that tick grid. A tick is a level of at most one side.
+ * Each level keeps the size of other market participants as an aggregate; our orders rest in an overlay queue per
+ * level, taking their nodes from one pool per book, so resting, reducing and removing them does not allocate once the
+ * pool has grown, and depth updates at levels without our orders never walk a queue. The size of other market
+ * participants at each level is also kept in a DepthTree per side, for cumulative depth queries.
+ * A level is erased as soon as nothing rests there, so the ladders hold live depth only and their slots and overflow
+ * nodes are reused by later levels. The ladder and depth tree windows follow the best bid and ask, so the levels near the touch stay
+ * in the window however far the price drifts, while far levels wait in the overflow maps.
+ * The book keeps its BookFeatures up to date as it changes: each change only revisits the side whose best
+ * BOOK_FEATURE_LEVELS levels it touched, so reading them costs O(1) however many strategies do.
+ * The best bid and ask and the last trade price are recorded in a BookHistory ring at the times the owner passes to
+ * recordHistory, for as-of queries.
+ * @tparam DepthPolicy levels kept per side (FullDepth, TopLevels<N> or TopOfBook); levels past them are dropped.
  */
-class OrderBook {
+template <typename DepthPolicy>
+class BasicOrderBook {
     public:
+        /**
+         * Price level: the queue of orders resting at a tick of one side of the book.
+         */
+        using Level = OrderQueue;
+
+        /**
+         * Fills of our resting orders: pointer to our order, filled price and size.
+         */
+        using RestingFills = vector<tuple<std::shared_ptr<Order>, double, double>>;
+
+        /**
+         * Fills of one order taking liquidity: filled price and size.
+         */
+        using OrderFills = vector<pair<double, double>>;
+
         /**
          * Constructor for OrderBook class.
+         * @param history_capacity number of entries of the top of book history.
          */
-        OrderBook(std::shared_ptr<Exchange> exchange_,  MarketType market_type_, std::shared_ptr<Security> security_): exchange(exchange_), market_type(market_type_), security(security_) {}
+        BasicOrderBook(std::shared_ptr<Exchange> exchange_,  MarketType market_type_, std::shared_ptr<Security> security_, size_t history_capacity = BOOK_HISTORY_CAPACITY): exchange(exchange_), market_type(market_type_), security(security_),
+                bids(exchange_->getTradingRules(market_type_, *security_)[0], DepthPolicy::window_ticks), asks(bids.getTickSize(), DepthPolicy::window_ticks),
+                bid_depth(DepthPolicy::window_ticks), ask_depth(DepthPolicy::window_ticks), history(history_capacity) {}
 
         /**
          * Destructor for OrderBook class.
          */
-        ~OrderBook() {}
+        ~BasicOrderBook() {}
 
         /**
          * Handles when data parser reads trade update.
@@ -31,39 +114,60 @@ class OrderBook {
          * @return vector of pointer to our order, price, and size if any of our order got filled.
          */
         vector<tuple<std::shared_ptr<Order>, double, double>> tradeOccurred(double price, double qty) {
+            RestingFills fills;
+            tradeOccurred(price, qty, fills);
+            return fills;
+        }
+
+        /**
+         * Handles when data parser reads trade update, without allocating unless our orders fill.
+         * @param price price the trade occurred.
+         * @param qty quantity of trade.
+         * @param fills our orders that got filled are appended to it; reusing it across events avoids allocating.
+         */
+        void tradeOccurred(double price, double qty, RestingFills& fills) {
             if (price <= 0) {
                 throw invalid_argument("Price should be positive");
-                return vector<tuple<std::shared_ptr<Order>, double, double>>();
+                return;
             }
             if (qty <= 0) {
                 throw invalid_argument("Quantity should be positive");
-                return vector<tuple<std::shared_ptr<Order>, double, double>>();
+                return;
             }
 
-            vector<tuple<std::shared_ptr<Order>, double, double>> fills;
-
-            if (book[price].second.empty()) {
-                return fills;
+            last_trade_price = price;
+            Level* level = findLevel(price);
+            if (level == nullptr || level->empty()) {
+                return;
             }
 
-            queue<pair<double, std::shared_ptr<Order>>>& level_queue = book[price].second;
-
+            // The trade takes the market size ahead of each of our orders, then the order itself, then the size behind
             double quantity_to_fill = qty;
-            while (quantity_to_fill != 0 && !level_queue.empty()) {
-                double subtracting = min(quantity_to_fill, level_queue.front().first);
-                level_queue.front().first -= subtracting;
+            double market_filled = 0.0;
+            uint32_t node = level->head;
+            while (quantity_to_fill != 0 && node != NO_BOOK_NODE) {
+                double subtracting = min(quantity_to_fill, max(pool[node].ahead - market_filled, 0.0));
                 quantity_to_fill -= subtracting;
-
-                if (level_queue.front().second != nullptr && level_queue.front().second->isLiveOrder()) {
-                    fills.emplace_back(make_tuple(level_queue.front().second, price, subtracting));
+                market_filled += subtracting;
+                if (quantity_to_fill == 0) {
+                    break;
                 }
 
-                if (level_queue.front().first == 0.0) {
-                    level_queue.pop();
+                uint32_t next = pool[node].next;
+                subtracting = min(quantity_to_fill, pool[node].size);
+                quantity_to_fill -= subtracting;
+                if (pool[node].order->isLiveOrder()) {
+                    fills.emplace_back(make_tuple(pool[node].order, price, subtracting));
                 }
+                level->reduce(pool, node, subtracting);
+                node = next;
             }
+            market_filled += min(quantity_to_fill, max(level->market_size - market_filled, 0.0));
 
-            return fills;
+            level->fillMarket(pool, market_filled);
+            syncDepth(toTick(price));
+            reclaimLevel(toTick(price));
+            updateFeatures(toTick(price));
         }
 
         /**
@@ -73,28 +177,105 @@ class OrderBook {
          * @param my_order boolean whether the new order is my order
          */
         pair<std::shared_ptr<Order>, vector<pair<double, double>>> addOrder(double price_level, int order_side, double order_size, std::shared_ptr<Order> order_ptr) {
+            OrderFills fills;
+            if (addOrder(price_level, order_side, order_size, order_ptr, fills)) {
+                return {order_ptr, fills};
+            }
+            return  pair<std::shared_ptr<Order>, vector<pair<double, double>>>();
+        }
+
+        /**
+         * Add order to the book, without allocating unless the order fills or a node is added to the pool.
+         * @param price_level price level of the new order
+         * @param order_side order side of the new order
+         * @param order_size size of the new order
+         * @param order_ptr pointer to our order, nullptr for other market participants
+         * @param fills fills of our order are appended to it if the price level is on the other side of the book
+         * @return whether our order was filled as a market order instead of resting.
+         */
+        bool addOrder(double price_level, int order_side, double order_size, const std::shared_ptr<Order>& order_ptr, OrderFills& fills) {
             if (price_level <= 0) {
                 throw invalid_argument("Price level should be positive");
-                return  pair<std::shared_ptr<Order>, vector<pair<double, double>>>();
+                return false;
             }
 
-            addLevel(price_level, order_side);  // Handling case where price level does not exist
-
-            if (book[price_level].first != order_side) {
+            long long tick = toTick(price_level);
+            if ((order_side == 1 ? asks : bids).find(tick) != nullptr) {
                 if(order_ptr != nullptr && order_ptr->isLiveOrder()) {
-                    return fillMarketOrder(order_ptr);
+                    fillMarketOrder(order_ptr, fills);
+                    return true;
                 }
             } else {
-                if (book[price_level].second.empty()) {
-                    book[price_level].second.push(make_pair(order_size, order_ptr));
-                } else if (book[price_level].second.back().second == order_ptr) {
-                    book[price_level].second.back().first += order_size;
+                Level& level = addLevel(tick, order_side);  // Handling case where price level does not exist
+
+                if (order_ptr == nullptr) {
+                    level.addMarket(order_size);
+                    syncDepth(tick);
                 } else {
-                    book[price_level].second.push(make_pair(order_size, order_ptr));
+                    // Our order rests at most once; adding it again replaces its entry, in place if it is already last
+                    if (!level.endsWith(pool, order_ptr)) {
+                        removeOrder(order_ptr);
+                    }
+                    level.push(pool, order_size, order_ptr, tick);
                 }
+                reclaimLevel(tick);
+                trimLevels(order_side);
+                updateFeatures(tick);
             }
 
-            return  pair<std::shared_ptr<Order>, vector<pair<double, double>>>();
+            return false;
+        }
+
+        /**
+         * Removes one of our orders resting in the book, e.g. once it is cancelled. Its level is reclaimed if nothing is
+         * left there.
+         * @param order_ptr pointer to our order.
+         * @return whether the order was resting in the book.
+         */
+        bool removeOrder(const std::shared_ptr<Order>& order_ptr) {
+            Level* level = findRestingLevel(order_ptr);
+            if (level == nullptr) {
+                return false;
+            }
+
+            long long tick = pool[order_ptr->getBookNode()].tick;
+            level->erase(pool, order_ptr->getBookNode());
+            reclaimLevel(tick);
+            updateFeatures(tick);
+            return true;
+        }
+
+        /**
+         * Cancels one of our orders and removes it from the book.
+         * @param order_ptr pointer to our order.
+         */
+        void cancelOrder(const std::shared_ptr<Order>& order_ptr) {
+            order_ptr->cancelOrder();
+            removeOrder(order_ptr);
+        }
+
+        /**
+         * Changes the size of one of our orders resting in the book in place, keeping its queue position.
+         * @param order_ptr pointer to our order.
+         * @param order_size new resting size; 0 removes the order.
+         * @return whether the order was resting in the book.
+         */
+        bool modifyOrder(const std::shared_ptr<Order>& order_ptr, double order_size) {
+            if (order_size < 0) {
+                throw invalid_argument("Order size should be non-negative");
+                return false;
+            }
+
+            Level* level = findRestingLevel(order_ptr);
+            if (level == nullptr) {
+                return false;
+            }
+
+            long long tick = pool[order_ptr->getBookNode()].tick;
+            level->resize(pool, order_ptr->getBookNode(), order_size);
+            reclaimLevel(tick);
+            updateFeatures(tick);
+            return true;
         }
 
         /**
@@ -107,44 +288,30 @@ class OrderBook {
                 return pair<std::shared_ptr<Order>, vector<pair<double, double>>>();
             }
 
-            double quantity_to_fill = qty;
-            int side = order_ptr->getSide();
-
-            double best_price = (side == 1) ? getBestAsk() : getBestBid();
-            double not_our_order_total_size = getLevelNotOurOrderTotalSize(best_price);
+            OrderFills fills;
+            instantFillLimit(order_ptr, qty, fills);
+            return {order_ptr, fills};
+        }
 
-            std::vector<std::pair<double, double>> fills;
+        /**
+         * Fills limit/stop limit order instantly, without allocating once fills has grown.
+         * @param order_ptr pointer to order.
+         * @param qty quantity that could get filled instantly, at most the quantity up to the limit price
+         * @param fills filled prices and sizes are appended to it
+        */
+        void instantFillLimit(const std::shared_ptr<Order>& order_ptr, double qty, OrderFills& fills) {
+            if (!order_ptr->isLiveOrder()) {
+                return;
+            }
 
-            if (quantity_to_fill <= not_our_order_total_size) {
-                // Can fill entirely at the best price level
-                reduceOrder(best_price, quantity_to_fill);
-                fills.emplace_back(best_price, quantity_to_fill);
+            // Never past the limit price; the remainder of qty fills at the last level within it
+            long long limit_tick = toTick(order_ptr->getPrice());
+            if (order_ptr->getSide() == 1) {
+                sweep<1, true>(qty, limit_tick, fills);
             } else {
-                // Partial fill at the best price level
-                reduceOrder(best_price, not_our_order_total_size);
-                if (not_our_order_total_size != 0) {
-                    fills.emplace_back(best_price, not_our_order_total_size);
-                }
-                quantity_to_fill -= not_our_order_total_size;
-
-                double next_level = side == 1 ? getNextSellSideLevel(best_price) : getNextBuySideLevel(best_price);
-
-                while (next_level != -1 && quantity_to_fill > 0) {
-                    not_our_order_total_size = getLevelNotOurOrderTotalSize(next_level);
-                    double subtracting = min(quantity_to_fill, not_our_order_total_size);
-                    reduceOrder(next_level, subtracting);
-                    if (not_our_order_total_size != 0) {
-                        fills.emplace_back(next_level, subtracting);
-                    }
-                    quantity_to_fill -= subtracting;
-
-                    next_level = side == 1 ? getNextSellSideLevel(next_level) : getNextBuySideLevel(next_level);
-                }
-
-                fills.back().second += quantity_to_fill;
+                sweep<-1, true>(qty, limit_tick, fills);
             }
-
-            return {order_ptr, fills};
+            updateFeatures();
         }
 
         /**
@@ -156,43 +323,27 @@ class OrderBook {
                 return pair<std::shared_ptr<Order>, vector<pair<double, double>>>();
             }
 
-            double quantity_to_fill = order_ptr->getLeverageAdjustedBaseCurrencySize();
-            int side = order_ptr->getSide();
-
-            double best_price = (side == 1) ? getBestAsk() : getBestBid();
-            double not_our_order_total_size = getLevelNotOurOrderTotalSize(best_price);
+            OrderFills fills;
+            fillMarketOrder(order_ptr, fills);
+            return {order_ptr, fills};
+        }
 
-            std::vector<std::pair<double, double>> fills;
+        /**
+         * Fills market/stop order, without allocating once fills has grown.
+         * @param order_ptr pointer to order.
+         * @param fills filled prices and sizes are appended to it
+        */
+        void fillMarketOrder(const std::shared_ptr<Order>& order_ptr, OrderFills& fills) {
+            if (!order_ptr->isLiveOrder()) {
+                return;
+            }
 
-            if (quantity_to_fill <= not_our_order_total_size) {
-                // Can fill entirely at the best price level
-                reduceOrder(best_price, quantity_to_fill);
-                fills.emplace_back(best_price, quantity_to_fill);
+            if (order_ptr->getSide() == 1) {
+                sweep<1, false>(order_ptr->getLeverageAdjustedBaseCurrencySize(), 0, fills);
             } else {
-                // Partial fill at the best price level
-                reduceOrder(best_price, not_our_order_total_size);
-                if (not_our_order_total_size != 0) {
-                    fills.emplace_back(best_price, not_our_order_total_size);
-                }
-                quantity_to_fill -= not_our_order_total_size;
-                double next_level = side == 1 ? getNextSellSideLevel(best_price) : getNextBuySideLevel(best_price);
-
-                while (next_level != -1 && quantity_to_fill > 0) {
-                    not_our_order_total_size = getLevelNotOurOrderTotalSize(next_level);
-                    double subtracting = min(quantity_to_fill, not_our_order_total_size);
-                    reduceOrder(next_level, subtracting);
-                    if (not_our_order_total_size != 0) {
-                        fills.emplace_back(next_level, subtracting);
-                    }
-                    quantity_to_fill -= subtracting;
-
-                    next_level = side == 1 ? getNextSellSideLevel(next_level) : getNextBuySideLevel(next_level);
-                }
-
-                fills.back().second += quantity_to_fill;
+                sweep<-1, false>(order_ptr->getLeverageAdjustedBaseCurrencySize(), 0, fills);
             }
-
-            return {order_ptr, fills};
+            updateFeatures();
         }
 
         /**
@@ -205,54 +356,61 @@ class OrderBook {
          * @return vector of pointer to our order, filled price and size if any of our resting orders got filled.
         */
         vector<tuple<std::shared_ptr<Order>, double, double>> buySideUpdated(double price_level, double order_size) {
-            vector<tuple<std::shared_ptr<Order>, double, double>> filled_orders;
-            addLevel(price_level, 1);  // Handling case where price level does not exist
-
-            // First update the price level
-            if (book[price_level].first == 1) {
-                double not_our_order_size = getLevelNotOurOrderTotalSize(price_level);
-                double our_order_size = getLevelOurOrderTotalSize(price_level);
-
-                if (order_size > not_our_order_size + our_order_size) {
-                    // Add order if updated order size is greater than original
-                    addOrder(price_level, 1, order_size - getLevelTotalSize(price_level), nullptr);
-                } else if (order_size < not_our_order_size + our_order_size) {
-                    // Reduce order if updated order size is lesser than original
-                    reduceOrder(price_level, min(not_our_order_size, not_our_order_size + our_order_size - order_size));
-                }
-            } else {
-                if (getLevelOurOrderTotalSize(price_level) != 0) {
-                    // Fill our orders
-                    for (std::shared_ptr<Order> it : getOurOrderPtr(price_level)) {
-                        if (it->isLiveOrder()) {
-                            filled_orders.push_back(make_tuple(it, price_level, it->getLeverageAdjustedBaseCurrencySize()));
-                        }
-                    }
-                }
+            RestingFills filled_orders;
+            buySideUpdated(price_level, order_size, filled_orders);
+            return filled_orders;
+        }
 
-                book[price_level] = std::make_pair(1, std::queue<pair<double, std::shared_ptr<Order>>>());
-                addOrder(price_level, 1, order_size, nullptr);
+        /**
+         * Handles updated buy side as above, without allocating unless our orders fill.
+         * @param price_level price level to check.
+         * @param order_size updated order size.
+         * @param filled_orders our resting orders that got filled are appended to it; reusing it across events avoids
+         *        allocating.
+        */
+        void buySideUpdated(double price_level, double order_size, RestingFills& filled_orders) {
+            if (price_level <= 0) {
+                throw invalid_argument("Price level should be positive");
+                return;
             }
 
-            // Any price level below price_level should also be buy side
-            for (const auto& entry : book) {
-                double key = entry.first;
-                int value_first = entry.second.first;
+            long long price_tick = toTick(price_level);
+            if (isPastDepth(price_tick, 1)) {
+                return;
+            }
 
-                if (key < price_level && value_first == -1) {
-                    if (getLevelOurOrderTotalSize(key) != 0) {
-                        for (std::shared_ptr<Order> it : getOurOrderPtr(key)) {
-                            if (it->isLiveOrder()) {
-                                filled_orders.push_back(make_tuple(it, key, it->getLeverageAdjustedBaseCurrencySize()));
-                            }
-                        }
-                    }
-                    
-                    book[key] = std::make_pair(1, std::queue<pair<double, std::shared_ptr<Order>>>());
-                }
+            // An ask at the price level is replaced by the bid; fill our orders there
+            if (asks.find(price_tick) != nullptr) {
+                crossLevel(asks, price_tick, price_level, filled_orders);
             }
 
-            return filled_orders;
+            // Then update the price level
+            Level& level = addLevel(price_tick, 1);  // Handling case where price level does not exist
+            double not_our_order_size = level.market_size;
+            double our_order_size = level.our_size;
+
+            if (order_size > not_our_order_size + our_order_size) {
+                // Add order if updated order size is greater than original
+                level.addMarket(order_size - not_our_order_size - our_order_size);
+                syncDepth(price_tick);
+            } else if (order_size < not_our_order_size + our_order_size) {
+                // Reduce order if updated order size is lesser than original
+                reduceOrder(price_level, min(not_our_order_size, not_our_order_size + our_order_size - order_size));
+            }
+
+            // Any ask below price_level is taken by the bid; only the asks crossed are visited
+            for (long long tick = asks.lowest(); tick != PRICE_LADDER_NO_TICK && tick < price_tick; tick = asks.nextAbove(tick)) {
+                crossLevel(asks, tick, toPrice(tick), filled_orders);
+            }
+
+            // price_level is a bid now and no ask is left at or below it
+            best_bid = max(best_bid, price_tick);
+            if (best_ask != PRICE_LADDER_NO_TICK && best_ask <= price_tick) {
+                best_ask = findAskAbove(price_tick);
+            }
+            reclaimLevel(price_tick);
+            trimLevels(1);
+            updateFeatures(price_tick);
         }
 
         /**
@@ -265,56 +423,137 @@ class OrderBook {
          * @return vector of pointer to our order, filled price and size if any of our resting orders got filled.
         */
         vector<tuple<std::shared_ptr<Order>, double, double>> sellSideUpdated(double price_level, double order_size) {
-            vector<tuple<std::shared_ptr<Order>, double, double>> filled_orders;
-            addLevel(price_level, -1);  // Handling case where price level does not exist
-
-            // First update the price level
-            if (book[price_level].first == -1) {
-                double not_our_order_size = getLevelNotOurOrderTotalSize(price_level);
-                double our_order_size = getLevelOurOrderTotalSize(price_level);
-
-                if (order_size > not_our_order_size + our_order_size) {
-                    // Add order if updated order size is greater than original
-                    addOrder(price_level, -1, order_size - not_our_order_size - our_order_size, nullptr);
-                } else if (order_size < not_our_order_size + our_order_size) {
-                    // Reduce order if updated order size is lesser than original
-                    reduceOrder(price_level, min(not_our_order_size, not_our_order_size + our_order_size - order_size));
-                }
-            } else {
-                if (getLevelOurOrderTotalSize(price_level) != 0) {
-                    // Fill our orders
-                    for (std::shared_ptr<Order> it : getOurOrderPtr(price_level)) {
-                        if (it->isLiveOrder()) {
-                            filled_orders.push_back(make_tuple(it, price_level, it->getLeverageAdjustedBaseCurrencySize()));
-                        }
-                    }
-                }
+            RestingFills filled_orders;
+            sellSideUpdated(price_level, order_size, filled_orders);
+            return filled_orders;
+        }
 
-                book[price_level] = std::make_pair(-1, std::queue<pair<double, std::shared_ptr<Order>>>());
-                addOrder(price_level, -1, order_size, nullptr);
+        /**
+         * Handles updated sell side as above, without allocating unless our orders fill.
+         * @param price_level price level to check.
+         * @param order_size updated order size.
+         * @param filled_orders our resting orders that got filled are appended to it; reusing it across events avoids
+         *        allocating.
+        */
+        void sellSideUpdated(double price_level, double order_size, RestingFills& filled_orders) {
+            if (price_level <= 0) {
+                throw invalid_argument("Price level should be positive");
+                return;
             }
 
-            // Any price level below price_level should also be buy side
-            for (const auto& entry : book) {
-                double key = entry.first;
-                int value_first = entry.second.first;
+            long long price_tick = toTick(price_level);
+            if (isPastDepth(price_tick, -1)) {
+                return;
+            }
 
-                if (key > price_level && value_first == 1) {
-                    if (getLevelOurOrderTotalSize(key) != 0) {
-                        for (std::shared_ptr<Order> it : getOurOrderPtr(key)) {
-                            if (it->isLiveOrder()) {
-                                filled_orders.push_back(make_tuple(it, key, it->getLeverageAdjustedBaseCurrencySize()));
-                            }
-                        }
-                    }
-                    
-                    book[key] = std::make_pair(-1, std::queue<pair<double, std::shared_ptr<Order>>>());
-                }
+            // A bid at the price level is replaced by the ask; fill our orders there
+            if (bids.find(price_tick) != nullptr) {
+                crossLevel(bids, price_tick, price_level, filled_orders);
             }
 
+            // Then update the price level
+            Level& level = addLevel(price_tick, -1);  // Handling case where price level does not exist
+            double not_our_order_size = level.market_size;
+            double our_order_size = level.our_size;
+
+            if (order_size > not_our_order_size + our_order_size) {
+                // Add order if updated order size is greater than original
+                level.addMarket(order_size - not_our_order_size - our_order_size);
+                syncDepth(price_tick);
+            } else if (order_size < not_our_order_size + our_order_size) {
+                // Reduce order if updated order size is lesser than original
+                reduceOrder(price_level, min(not_our_order_size, not_our_order_size + our_order_size - order_size));
+            }
+
+            // Any bid above price_level is taken by the ask; only the bids crossed are visited
+            for (long long tick = bids.nextAbove(price_tick); tick != PRICE_LADDER_NO_TICK; tick = bids.nextAbove(tick)) {
+                crossLevel(bids, tick, toPrice(tick), filled_orders);
+            }
+
+            // price_level is an ask now and no bid is left at or above it
+            best_ask = best_ask == PRICE_LADDER_NO_TICK ? price_tick : min(best_ask, price_tick);
+            if (best_bid >= price_tick) {
+                best_bid = findBidBelow(price_tick);
+            }
+            reclaimLevel(price_tick);
+            trimLevels(-1);
+            updateFeatures(price_tick);
+        }
+
+        /**
+         * Applies a quote snapshot of the best levels of both sides, as BID_UPDATE and ASK_UPDATE rows carry.
+         * @param bid_prices bid prices, best first; the bids end at the first price that is not positive.
+         * @param bid_sizes bid sizes.
+         * @param ask_prices ask prices, best first; the asks end at the first price that is not positive.
+         * @param ask_sizes ask sizes.
+         * @param num_levels number of entries of each array.
+         * @return vector of pointer to our order, filled price and size if any of our resting orders got filled.
+         */
+        vector<tuple<std::shared_ptr<Order>, double, double>> applySnapshot(const double* bid_prices, const double* bid_sizes, const double* ask_prices, const double* ask_sizes, size_t num_levels) {
+            RestingFills filled_orders;
+            applySnapshot(bid_prices, bid_sizes, ask_prices, ask_sizes, num_levels, filled_orders);
             return filled_orders;
         }
 
+        /**
+         * Applies a quote snapshot of the best levels of both sides in one pass, without allocating unless our orders
+         * fill.
+         * The levels listed replace the levels of their side from the best level down to the last one listed: levels in
+         * that range that are not listed lose the size of other market participants, and the levels of the other side
+         * that the best bid or ask of the snapshot crosses are removed, filling our orders there. Levels past the last
+         * one listed are kept. Sizes count our orders, as in side updates. The best bid and ask are found once, at the
+         * end. Snapshots whose levels are out of order, or whose best bid reaches its best ask (locked or crossed
+         * quotes), are dropped and counted by getNumRejectedSnapshots, so bad rows in the market data leave the book as
+         * it was.
+         * @param bid_prices bid prices, best first; the bids end at the first price that is not positive.
+         * @param bid_sizes bid sizes.
+         * @param ask_prices ask prices, best first; the asks end at the first price that is not positive.
+         * @param ask_sizes ask sizes.
+         * @param num_levels number of entries of each array.
+         * @param filled_orders our resting orders that got filled are appended to it; reusing it across events avoids
+         *        allocating.
+         */
+        void applySnapshot(const double* bid_prices, const double* bid_sizes, const double* ask_prices, const double* ask_sizes, size_t num_levels, RestingFills& filled_orders) {
+            size_t num_bids = 0;
+            size_t num_asks = 0;
+            if (!countSnapshotLevels(bid_prices, num_levels, 1, num_bids) || !countSnapshotLevels(ask_prices, num_levels, -1, num_asks)
+                    || (num_bids != 0 && num_asks != 0 && toTick(bid_prices[0]) >= toTick(ask_prices[0]))) {
+                ++rejected_snapshots;
+                return;
+            }
+
+            // The best bid takes every ask at or below it and the best ask every bid at or above it
+            if (num_bids != 0) {
+                long long bid_tick = toTick(bid_prices[0]);
+                for (long long tick = best_ask; tick != PRICE_LADDER_NO_TICK && tick <= bid_tick; tick = asks.nextAbove(tick)) {
+                    crossLevel(asks, tick, toPrice(tick), filled_orders);
+                }
+                if (best_ask != PRICE_LADDER_NO_TICK && best_ask <= bid_tick) {
+                    best_ask = findAskAbove(bid_tick);
+                }
+            }
+            if (num_asks != 0) {
+                long long ask_tick = toTick(ask_prices[0]);
+                for (long long tick = best_bid; tick != PRICE_LADDER_NO_TICK && tick >= ask_tick; tick = bids.nextBelow(tick)) {
+                    crossLevel(bids, tick, toPrice(tick), filled_orders);
+                }
+                if (best_bid >= ask_tick) {
+                    best_bid = findBidBelow(ask_tick);
+                }
+            }
+
+            if (num_bids != 0) {
+                replaceLevels<1>(bid_prices, bid_sizes, num_bids);
+            }
+            if (num_asks != 0) {
+                replaceLevels<-1>(ask_prices, ask_sizes, num_asks);
+            }
+
+            trimLevels(1);
+            trimLevels(-1);
+            updateFeatures();
+        }
+
         /**
          * Getter for order side at price level.
          * @param price_level price level to check.
@@ -345,90 +584,184 @@ class OrderBook {
 
         /**
          * Getter for the best bid price.
-         * @return best (highest) bid price.
+         * @return best (highest) bid price, or -1 if there are no bids.
          */
         double getBestBid() const {
-            double best_bid = -1.0;
+            return best_bid != PRICE_LADDER_NO_TICK ? toPrice(best_bid) : -1.0;
+        }
 
-            for (const auto& entry : book) {
-                const auto& key = entry.first;
-                const auto& value = entry.second;
+        /**
+         * Getter for the best ask price.
+         * @return best (lowest) ask price, or -1 if there are no asks.
+         */
+        double getBestAsk() const {
+            return best_ask != PRICE_LADDER_NO_TICK ? toPrice(best_ask) : -1.0;
+        }
 
-                if (value.first == 1 && key > best_bid) {
-                    best_bid = key;
-                }
+        /**
+         * Getter for total order size at price level, ours included.
+         * @param price_level price level to check.
+         */
+        double getLevelTotalSize(double price_level) const {
+            if (price_level <= 0) {
+                throw invalid_argument("Price level should be positive");
+                return 0;
             }
 
-            return best_bid;
+            const Level* level = findLevel(price_level);
+            return level != nullptr ? level->market_size + level->our_size : 0.0;
         }
 
         /**
-         * Getter for the best ask price.
-         * @return best (lowest) ask price.
+         * Getter for total order size which is not our order at price level.
+         * @param price_level price level to check.
          */
-        double getBestAsk() const {
-            double best_ask = std::numeric_limits<double>::max();
+        double getLevelNotOurOrderTotalSize(double price_level) const {
+            if (price_level <= 0) {
+                throw invalid_argument("Price level should be positive");
+                return 0;
+            }
 
-            for (const auto& entry : book) {
-                const auto& key = entry.first;
-                const auto& value = entry.second;
+            const Level* level = findLevel(price_level);
+            return level != nullptr ? level->market_size : 0.0;
+        }
 
-                if (value.first == -1 && key < best_ask) {
-                    best_ask = key;
-                }
+        /**
+         * Getter for total order size which is our order at price level.
+         * @param price_level price level to check.
+         */
+        double getLevelOurOrderTotalSize(double price_level) const {
+            if (price_level <= 0) {
+                throw invalid_argument("Price level should be positive");
+                return 0;
             }
-            return (best_ask == std::numeric_limits<double>::max()) ? -1.0: best_ask;
+
+            const Level* level = findLevel(price_level);
+            return level != nullptr ? level->our_size : 0.0;
         }
 
         /**
-         * Getter for total order size which is not our order at price level.
+         * Getter for the number of our orders at price level.
          * @param price_level price level to check.
          */
-        double getLevelTotalSize(double price_level) const {
+        int getNumOurOrders(double price_level) const {
             if (price_level <= 0) {
                 throw invalid_argument("Price level should be positive");
                 return 0;
             }
 
-            double total_size = 0.0;
-
-            if (book.find(price_level) != book.end()) {
-                const queue<pair<double, std::shared_ptr<Order>>>& order_queue = book.at(price_level).second;
-                queue<pair<double, std::shared_ptr<Order>>> temp_queue = order_queue;
+            const Level* level = findLevel(price_level);
+            return level != nullptr ? level->num_our_orders : 0;
+        }
 
-                while (!temp_queue.empty()) {
-                    total_size += temp_queue.front().first;
-                    temp_queue.pop();
-                }
-            } 
+        /**
+         * Getter for the quantity a limit order could fill instantly against other market participants.
+         * @param price limit price of the order.
+         * @param order_side side of the order.
+         * @return total size of the asks at or below price for a buy, of the bids at or above price for a sell.
+         */
+        double getLimitInstantFillQuantity(double price, int order_side) const {
+            if (order_side != 1 && order_side != -1) {
+                throw invalid_argument("Order side should be 1 or -1");
+                return -1.0;
+            }
 
-            return total_size;
+            // Size of other market participants on the opposite side from the touch up to price. A price that does not
+            // reach the touch fills nothing; checking it here keeps rounding left in the tree from showing up as a fill.
+            long long price_tick = toTick(price);
+            if (order_side == 1) {
+                return best_ask != PRICE_LADDER_NO_TICK && price_tick >= best_ask ? max(ask_depth.prefix(price_tick), 0.0) : 0.0;
+            }
+            return best_bid != PRICE_LADDER_NO_TICK && price_tick <= best_bid ? max(bid_depth.prefix(-price_tick), 0.0) : 0.0;
         }
 
-        double getLimitInstantFillQuantity(double price, int order_side) {
+        /**
+         * Finds the price a sweep of the opposite side reaches, walking out from the touch.
+         * @param order_side side of the sweeping order (1 sweeps the asks, -1 the bids).
+         * @param qty quantity to sweep; should be positive.
+         * @return price of the level where the size of other market participants from the touch reaches qty, or -1 if
+         *         the side holds less.
+         */
+        double getSweepPrice(int order_side, double qty) const {
             if (order_side != 1 && order_side != -1) {
                 throw invalid_argument("Order side should be 1 or -1");
                 return -1.0;
             }
 
-            double best_price = order_side == 1 ? getBestAsk() : getBestBid();
-            double instant_fill_quantity = 0;
+            long long tick = order_side == 1 ? ask_depth.reach(qty) : bid_depth.reach(qty);
+            if (tick == PRICE_LADDER_NO_TICK) {
+                return -1.0;
+            }
+            return toPrice(order_side == 1 ? tick : -tick);
+        }
 
-            if (order_side == 1) {
-                while (best_price <= price && best_price != -1) {
-                    instant_fill_quantity += getLevelNotOurOrderTotalSize(best_price);
-                    best_price = getNextBuySideLevel(best_price);
-                }
-            } else {
-                while (best_price >= price && best_price != -1) {
-                    instant_fill_quantity += getLevelNotOurOrderTotalSize(best_price);
-                    best_price = getNextSellSideLevel(best_price);
-                }
+        /**
+         * Getter for the queue position of one of our orders resting in the book.
+         * @param order_ptr pointer to our order.
+         * @return size of other market participants ahead of the order, or -1 if the order is not resting in this book.
+         */
+        double getQueueAhead(const std::shared_ptr<Order>& order_ptr) const {
+            if (findRestingLevel(order_ptr) == nullptr) {
+                return -1.0;
             }
+            return pool[order_ptr->getBookNode()].ahead;
+        }
+
+        /**
+         * Getter for the microstructure features of the book: spread, mid, microprice, imbalance and the depth of the
+         * best BOOK_FEATURE_LEVELS levels of each side. Kept up to date as the book changes, so reading them is O(1).
+         */
+        const BookFeatures& getFeatures() const {return features;}
 
-            return instant_fill_quantity;
+        /**
+         * Records the best bid and ask and the last trade price in the history, as of a time.
+         * @param timestamp time in nanoseconds since epoch.
+         */
+        void recordHistory(long long timestamp) {
+            history.record(timestamp, features.bid_price, features.ask_price, last_trade_price);
         }
 
+        /**
+         * Getter for the top of book history recorded by recordHistory.
+         */
+        const BookHistory& getHistory() const {return history;}
+
+        /**
+         * Getter for the price of the last trade.
+         * @return price of the last trade, or -1 if there was none.
+         */
+        double getLastTradePrice() const {return last_trade_price;}
+
+        /**
+         * Getter for number of price levels.
+         */
+        size_t getNumLevels() const {return bids.size() + asks.size();}
+
+        /**
+         * Getter for number of levels visited so far while searching for a new best bid or ask.
+         */
+        uint64_t getNumLevelVisits() const {return level_visits;}
+
+        /**
+         * Getter for number of levels removed so far because an update of the other side crossed them.
+         */
+        uint64_t getNumCrossedLevels() const {return crossed_levels;}
+
+        /**
+         * Getter for number of levels dropped so far because they fell past the levels the depth policy keeps.
+         */
+        uint64_t getNumDroppedLevels() const {return dropped_levels;}
+
+        /**
+         * Getter for number of levels erased because nothing rested there any more.
+         */
+        uint64_t getNumReclaimedLevels() const {return reclaimed_levels;}
+
+        /**
+         * Getter for number of snapshots dropped by applySnapshot because they were out of order, locked or crossed.
+         */
+        uint64_t getNumRejectedSnapshots() const {return rejected_snapshots;}
+
         /**
          * Getter for pointer to exchange.
          */
@@ -445,163 +778,506 @@ class OrderBook {
         MarketType getMarketType() {return market_type;}
 
     private:
+        long long toTick(double price) const {return bids.toTick(price);}
+        double toPrice(long long tick) const {return bids.toPrice(tick);}
+
         /**
-         * Add level to the order book.
-         * @param price_level price level to add
+         * Add level to one side of the order book.
+         * @param tick tick of the level, which must not be a level of the other side
+         * @param order_side side to add the level to
+         * @return the level.
          */
-        void addLevel(double price_level, int order_side) {
-            if (book.find(price_level) != book.end()) {
-                return;     // Return if price level already exists.
+        Level& addLevel(long long tick, int order_side) {
+            bool created;
+            Level& level = (order_side == 1 ? bids : asks).insert(tick, created);
+            if (created) {
+                if (order_side == 1) {
+                    best_bid = max(best_bid, tick);
+                } else if (best_ask == PRICE_LADDER_NO_TICK || tick < best_ask) {
+                    best_ask = tick;
+                }
             }
-
-            book[price_level] = std::make_pair(order_side, std::queue<pair<double, std::shared_ptr<Order>>>());
+            return level;
         }
 
         /**
-         * Helper function to find the price level which is less than current_level
-        */
-        double getNextBuySideLevel(double current_level) {
-            auto it = book.lower_bound(current_level);
+         * Helper function removing a level crossed by an update of the other side.
+         * Our live orders resting at the level are filled at price_level.
+         */
+        void crossLevel(PriceLadder<Level>& from, long long tick, double price_level, RestingFills& filled_orders) {
+            Level& level = *from.find(tick);
+            if (level.our_size != 0) {
+                for (uint32_t node = level.head; node != NO_BOOK_NODE; node = pool[node].next) {
+                    const std::shared_ptr<Order>& order = pool[node].order;
+                    if (order->isLiveOrder()) {
+                        filled_orders.push_back(make_tuple(order, price_level, order->getLeverageAdjustedBaseCurrencySize()));
+                    }
+                }
+            }
 
-            if (it != book.begin()) {
-                --it;
-                return it->first;
+            level.clear(pool);
+            if (&from == &bids) {
+                bid_depth.set(-tick, 0.0);
             } else {
-                // No lower level found, return -1
-                return -1;
+                ask_depth.set(tick, 0.0);
             }
+
+            from.erase(tick);
+            ++crossed_levels;
         }
 
         /**
-         * Helper function to find the price level which is greater than current_level
+         * Sweep kernel of instantFillLimit and fillMarketOrder: takes a quantity from other market participants on the
+         * side opposite to Side, walking out from the touch. The quantity left once the side (or the levels within the
+         * limit) runs out fills at the last level reached, if any. Levels the sweep empties are reclaimed. Throws
+         * invalid_argument if the side has no level, as the fill methods did before they shared this kernel.
+         * Specialized at compile time on the side and on whether the walk stops at a limit tick, so each variant walks
+         * one ladder without branching on the side per level.
+         * @param quantity_to_fill quantity to fill.
+         * @param limit_tick tick of the limit price, if Limit.
+         * @param fills filled prices and sizes are appended to it.
          */
-        double getNextSellSideLevel(double current_level) {
-            auto it = book.upper_bound(current_level);
+        template <int Side, bool Limit>
+        void sweep(double quantity_to_fill, long long limit_tick, OrderFills& fills) {
+            PriceLadder<Level>& ladder = Side == 1 ? asks : bids;
+            DepthTree& depth = Side == 1 ? ask_depth : bid_depth;
+            long long tick = Side == 1 ? best_ask : best_bid;
+            if (tick == PRICE_LADDER_NO_TICK) {
+                throw invalid_argument("Orderbook has no level to fill against");
+                return;
+            }
 
-            if (it != book.end()) {
-                return it->first; 
-            } else {
-                // No higher level found, return -1
-                return -1;
+            size_t first_fill = fills.size();
+            bool first_level = true;
+            long long first_kept = PRICE_LADDER_NO_TICK;
+            while (tick != PRICE_LADDER_NO_TICK && (first_level || quantity_to_fill > 0)) {
+                if (Limit && (Side == 1 ? tick > limit_tick : tick < limit_tick)) {
+                    break;
+                }
+
+                // Only orders that are not ours are taken, from the back of the queue
+                Level& level = *ladder.find(tick);
+                double not_our_order_total_size = level.market_size;
+                double subtracting = min(quantity_to_fill, not_our_order_total_size);
+                if (subtracting > 0) {
+                    level.reduceMarket(pool, subtracting);
+                    depth.set(Side == 1 ? tick : -tick, level.market_size);
+                }
+                if (not_our_order_total_size != 0 || quantity_to_fill <= not_our_order_total_size) {
+                    fills.emplace_back(toPrice(tick), subtracting);
+                }
+                quantity_to_fill -= subtracting;
+
+                long long next = Side == 1 ? ladder.nextAbove(tick) : ladder.nextBelow(tick);
+                if (level.empty()) {
+                    ladder.erase(tick);
+                    ++reclaimed_levels;
+                } else if (first_kept == PRICE_LADDER_NO_TICK) {
+                    first_kept = tick;
+                }
+                tick = next;
+                first_level = false;
+            }
+
+            // The touch moves to the first level the sweep left, or past every level it reached
+            (Side == 1 ? best_ask : best_bid) = first_kept != PRICE_LADDER_NO_TICK ? first_kept : tick;
+
+            // Remaining quantity fills at the last level reached, if any
+            if (fills.size() > first_fill) {
+                fills.back().second += quantity_to_fill;
             }
         }
 
         /**
-         * Helper function to reduce the total order size of a given level.
+         * Helper function counting the levels of one side of a snapshot, up to the first price that is not positive.
+         * @param count number of levels.
+         * @return false if they are not strictly ordered best first.
          */
-        void reduceOrder(double price_level, double num_to_reduce) {
-            if (book.find(price_level) != book.end()) {
-                auto& order_queue = book.at(price_level).second;
-
-                // Convert the queue to a deque
-                std::deque<std::pair<double, std::shared_ptr<Order>>> order_deque;
-                while (!order_queue.empty()) {
-                    order_deque.push_back(order_queue.front());
-                    order_queue.pop();
+        bool countSnapshotLevels(const double* prices, size_t num_levels, int order_side, size_t& count) const {
+            count = 0;
+            while (count < num_levels && prices[count] > 0) {
+                if (count != 0 && (order_side == 1 ? toTick(prices[count]) >= toTick(prices[count - 1]) : toTick(prices[count]) <= toTick(prices[count - 1]))) {
+                    return false;
                 }
+                ++count;
+            }
+            return true;
+        }
 
-                // Iterate through the deque from back to front
-                for (auto it = order_deque.rbegin(); it != order_deque.rend() && num_to_reduce > 0; ++it) {
-                    auto& order_pair = *it;
-                    if (order_pair.second == nullptr) {
-                        // Subtract min(double in queue, num_to_reduce)
-                        double reduction = std::min(order_pair.first, num_to_reduce);
-                        order_pair.first -= reduction;
-                        num_to_reduce -= reduction;
-
-                        if (order_pair.first == 0) {
-                            // Remove entry if quantity becomes 0
-                            order_deque.pop_back();
-                        }
+        /**
+         * Helper function replacing the levels of one side, from its best level down to the last snapshot level, with
+         * the levels of a snapshot, then finding the best level of the side once. Levels left empty are erased.
+         * @param prices prices of the snapshot levels, best first.
+         * @param sizes sizes of the snapshot levels.
+         * @param num_levels number of snapshot levels, at least 1.
+         */
+        template <int Side>
+        void replaceLevels(const double* prices, const double* sizes, size_t num_levels) {
+            PriceLadder<Level>& ladder = Side == 1 ? bids : asks;
+            DepthTree& depth = Side == 1 ? bid_depth : ask_depth;
+            long long first = toTick(prices[0]);
+            long long last = toTick(prices[num_levels - 1]);
+            long long& best = Side == 1 ? best_bid : best_ask;
+            long long top = best == PRICE_LADDER_NO_TICK ? first : (Side == 1 ? max(best, first) : min(best, first));
+
+            // Levels up to the last one listed that the snapshot does not list are left with our orders only
+            size_t listed = 0;
+            long long tick = best;
+            while (tick != PRICE_LADDER_NO_TICK && (Side == 1 ? tick >= last : tick <= last)) {
+                long long next = Side == 1 ? ladder.nextBelow(tick) : ladder.nextAbove(tick);
+                while (listed < num_levels && (Side == 1 ? toTick(prices[listed]) > tick : toTick(prices[listed]) < tick)) {
+                    ++listed;
+                }
+                if (listed == num_levels || toTick(prices[listed]) != tick) {
+                    Level& level = *ladder.find(tick);
+                    level.reduceMarket(pool, level.market_size);
+                    depth.set(Side == 1 ? -tick : tick, 0.0);
+                    if (level.empty()) {
+                        ladder.erase(tick);
+                        ++reclaimed_levels;
                     }
                 }
+                tick = next;
+            }
 
-                // Store the updated deque back into the queue
-                for (const auto& order_pair : order_deque) {
-                    order_queue.push(order_pair);
+            // Sizes count our orders; only the size of other market participants changes, at the back of the queue
+            for (size_t index = 0; index < num_levels; ++index) {
+                tick = toTick(prices[index]);
+                bool created;
+                Level& level = ladder.insert(tick, created);
+                double total_size = level.market_size + level.our_size;
+                if (sizes[index] > total_size) {
+                    level.addMarket(sizes[index] - total_size);
+                } else if (sizes[index] < total_size) {
+                    level.reduceMarket(pool, min(level.market_size, total_size - sizes[index]));
+                }
+                depth.set(Side == 1 ? -tick : tick, level.market_size);
+                if (level.empty()) {
+                    ladder.erase(tick);
+                    reclaimed_levels += !created;
                 }
             }
+
+            // No level is left past the best tick the side had or the first one listed
+            best = Side == 1 ? ladder.nextBelow(top + 1) : ladder.nextAbove(top - 1);
         }
 
         /**
-         * Getter for total order size which is not our order at price level.
-         * @param price_level price level to check.
+         * Helper function checking whether an update of a side at a tick worse than all of its levels would only add a
+         * level past the depth the policy keeps, which trimLevels would drop again right away.
          */
-        double getLevelNotOurOrderTotalSize(double price_level) const {
-            if (price_level <= 0) {
-                throw invalid_argument("Price level should be positive");
-                return 0;
+        bool isPastDepth(long long tick, int order_side) const {
+            if constexpr (DepthPolicy::max_levels != 0) {
+                const PriceLadder<Level>& ladder = order_side == 1 ? bids : asks;
+                if (ladder.size() >= DepthPolicy::max_levels) {
+                    return order_side == 1 ? tick < ladder.lowest() : tick > ladder.highest();
+                }
             }
+            return false;
+        }
 
-            double total_size = 0.0;
-
-            if (book.find(price_level) != book.end()) {
-                const queue<pair<double, std::shared_ptr<Order>>>& order_queue = book.at(price_level).second;
-                queue<pair<double, std::shared_ptr<Order>>> temp_queue = order_queue;
+        /**
+         * Helper function dropping the levels of a side past the best DepthPolicy::max_levels, except levels holding
+         * our orders, and reclaiming their nodes. Only walks the levels past that rank.
+         */
+        void trimLevels(int order_side) {
+            if constexpr (DepthPolicy::max_levels != 0) {
+                PriceLadder<Level>& ladder = order_side == 1 ? bids : asks;
+                size_t rank = ladder.size();
+                long long tick = order_side == 1 ? ladder.lowest() : ladder.highest();
+                while (rank > DepthPolicy::max_levels && tick != PRICE_LADDER_NO_TICK) {
+                    long long inner = order_side == 1 ? ladder.nextAbove(tick) : ladder.nextBelow(tick);
+                    Level& level = *ladder.find(tick);
+                    if (level.num_our_orders == 0) {
+                        level.clear(pool);
+                        if (order_side == 1) {
+                            bid_depth.set(-tick, 0.0);
+                        } else {
+                            ask_depth.set(tick, 0.0);
+                        }
+                        ladder.erase(tick);
+                        ++dropped_levels;
+                    }
+                    tick = inner;
+                    --rank;
+                }
+            }
+        }
 
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().second == nullptr) {
-                        total_size += temp_queue.front().first;
+        /**
+         * Helper function erasing the level at a tick if nothing rests there any more, moving the touch past it.
+         * Its size is already 0 in the depth tree.
+         */
+        void reclaimLevel(long long tick) {
+            if (Level* level = bids.find(tick)) {
+                if (level->empty()) {
+                    bids.erase(tick);
+                    ++reclaimed_levels;
+                    if (tick == best_bid) {
+                        best_bid = findBidBelow(tick);
                     }
-                    temp_queue.pop();
                 }
-            } 
+            } else if (Level* level = asks.find(tick)) {
+                if (level->empty()) {
+                    asks.erase(tick);
+                    ++reclaimed_levels;
+                    if (tick == best_ask) {
+                        best_ask = findAskAbove(tick);
+                    }
+                }
+            }
+        }
 
-            return total_size;
+        /**
+         * Helper function copying the size of other market participants at a level to the depth tree of its side.
+         */
+        void syncDepth(long long tick) {
+            if (const Level* level = bids.find(tick)) {
+                bid_depth.set(-tick, level->market_size);
+            } else if (const Level* level = asks.find(tick)) {
+                ask_depth.set(tick, level->market_size);
+            }
         }
 
         /**
-         * Getter for total order size which is our order at price level.
-         * @param price_level price level to check.
+         * Best levels of one side that the depth features cover, as of the last time they were taken.
          */
-        double getLevelOurOrderTotalSize(double price_level) const {
-            if (price_level <= 0) {
-                throw invalid_argument("Price level should be positive");
-                return 0;
+        struct FeatureLevels {
+            long long ticks[BOOK_FEATURE_LEVELS];   /*< Ticks of the levels, best first */
+            double sizes[BOOK_FEATURE_LEVELS];      /*< Total sizes of the levels */
+            size_t count = 0;                       /*< Number of levels taken */
+            size_t ladder_size = 0;                 /*< Number of levels of the side when they were taken */
+            double size = 0.0;                      /*< Total size of the levels */
+            double notional = 0.0;                  /*< Total size times price of the levels */
+        };
+
+        /**
+         * Helper function keeping the best bid and ask in the middle of the windows of their ladders and depth trees. The
+         * windows only move once the touch has drifted a quarter of a window, so depth updates far from it never move
+         * them.
+         */
+        void followTouch() {
+            if (best_bid != PRICE_LADDER_NO_TICK) {
+                bids.follow(best_bid);
+                bid_depth.follow(-best_bid);
             }
+            if (best_ask != PRICE_LADDER_NO_TICK) {
+                asks.follow(best_ask);
+                ask_depth.follow(best_ask);
+            }
+        }
 
-            double total_size = 0.0;
+        /**
+         * Helper function refreshing the features after a change at one tick, and at the levels of the other side it
+         * crossed. A side whose best level and number of levels did not move only has the size at the tick refreshed,
+         * and nothing at all if the tick lies past its best BOOK_FEATURE_LEVELS levels; otherwise its levels are taken
+         * again. The ladder and depth tree windows are moved along with the touch first.
+         */
+        void updateFeatures(long long tick) {
+            followTouch();
+            bool bid_changed = updateFeatureLevels<1>(tick);
+            bool ask_changed = updateFeatureLevels<-1>(tick);
+            if (bid_changed || ask_changed) {
+                combineFeatures();
+            }
+        }
 
-            if (book.find(price_level) != book.end()) {
-                const queue<pair<double, std::shared_ptr<Order>>>& order_queue = book.at(price_level).second;
-                queue<pair<double, std::shared_ptr<Order>>> temp_queue = order_queue;
+        /**
+         * Helper function refreshing the features after a change at any number of levels of both sides, moving the
+         * ladder and depth tree windows along with the touch first.
+         */
+        void updateFeatures() {
+            followTouch();
+            takeFeatureLevels<1>();
+            takeFeatureLevels<-1>();
+            combineFeatures();
+        }
+
+        /**
+         * Helper function refreshing the feature levels of one side after a change at a tick.
+         * @return whether they changed.
+         */
+        template <int Side>
+        bool updateFeatureLevels(long long tick) {
+            FeatureLevels& cache = Side == 1 ? bid_levels : ask_levels;
+            const PriceLadder<Level>& ladder = Side == 1 ? bids : asks;
+            long long best = Side == 1 ? best_bid : best_ask;
+
+            if (ladder.size() == cache.ladder_size && best == (cache.count != 0 ? cache.ticks[0] : PRICE_LADDER_NO_TICK)) {
+                const Level* level = ladder.find(tick);
+                size_t index = 0;
+                while (index < cache.count && cache.ticks[index] != tick) {
+                    ++index;
+                }
 
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().second != nullptr) {
-                        total_size += temp_queue.front().first;
+                if (index < cache.count && level != nullptr) {
+                    double size = level->market_size + level->our_size;
+                    if (size != cache.sizes[index]) {
+                        cache.sizes[index] = size;
+                        sumFeatureLevels(cache);
+                        return true;
                     }
-                    temp_queue.pop();
+                    return false;
                 }
-            } 
 
-            return total_size;
+                // Neither a level the features cover nor one that could take the place of one
+                long long last = cache.count != 0 ? cache.ticks[cache.count - 1] : PRICE_LADDER_NO_TICK;
+                if (index == cache.count && (level == nullptr || (cache.count == BOOK_FEATURE_LEVELS && (Side == 1 ? tick < last : tick > last)))) {
+                    return false;
+                }
+            }
+
+            takeFeatureLevels<Side>();
+            return true;
         }
 
         /**
-         * Helper function that counts number of orders that is not ours in the order book.
-         * @param price_level price level to check.
-         * @return number of orders that is not ours.
+         * Helper function taking the best BOOK_FEATURE_LEVELS levels of one side from the ladder.
          */
-        int getNumNotOurOrder(double price_level) {
-            int num_not_our_order = 0;
+        template <int Side>
+        void takeFeatureLevels() {
+            FeatureLevels& cache = Side == 1 ? bid_levels : ask_levels;
+            const PriceLadder<Level>& ladder = Side == 1 ? bids : asks;
+            cache.count = 0;
+            for (long long tick = Side == 1 ? best_bid : best_ask; tick != PRICE_LADDER_NO_TICK && cache.count < BOOK_FEATURE_LEVELS; tick = Side == 1 ? ladder.nextBelow(tick) : ladder.nextAbove(tick)) {
+                const Level& level = *ladder.find(tick);
+                cache.ticks[cache.count] = tick;
+                cache.sizes[cache.count] = level.market_size + level.our_size;
+                ++cache.count;
+            }
+            cache.ladder_size = ladder.size();
+            sumFeatureLevels(cache);
+        }
 
-            if (book.find(price_level) != book.end()) {
-                const auto& order_queue = book.at(price_level).second;
-                std::queue<std::pair<double, std::shared_ptr<Order>>> temp_queue = order_queue;
+        /**
+         * Helper function summing the sizes of the feature levels of one side; summing them afresh keeps rounding from
+         * piling up over updates.
+         */
+        void sumFeatureLevels(FeatureLevels& cache) const {
+            cache.size = 0.0;
+            cache.notional = 0.0;
+            for (size_t index = 0; index < cache.count; ++index) {
+                cache.size += cache.sizes[index];
+                cache.notional += cache.sizes[index] * toPrice(cache.ticks[index]);
+            }
+        }
 
-                while (!temp_queue.empty()) {
-                    const auto& order_pair = temp_queue.front();
-                    if (order_pair.second == nullptr) {
-                        // If the second element (shared_ptr<Order>) is nullptr
-                        num_not_our_order++;
-                    }
-                    temp_queue.pop();
-                }
-            }  else {
-                throw invalid_argument("Price level not found");
+        /**
+         * Helper function computing the features from the feature levels of both sides.
+         */
+        void combineFeatures() {
+            features = BookFeatures();
+            if (bid_levels.count != 0) {
+                features.bid_price = toPrice(bid_levels.ticks[0]);
+                features.bid_size = bid_levels.sizes[0];
+                features.bid_depth = bid_levels.size;
+            }
+            if (ask_levels.count != 0) {
+                features.ask_price = toPrice(ask_levels.ticks[0]);
+                features.ask_size = ask_levels.sizes[0];
+                features.ask_depth = ask_levels.size;
+            }
+            if (bid_levels.count == 0 || ask_levels.count == 0) {
+                return;
             }
 
-            return num_not_our_order;
+            features.spread = features.ask_price - features.bid_price;
+            features.mid = (features.bid_price + features.ask_price) / 2;
+            double top_size = features.bid_size + features.ask_size;
+            if (top_size > 0) {
+                features.microprice = (features.bid_price * features.ask_size + features.ask_price * features.bid_size) / top_size;
+                features.imbalance = (features.bid_size - features.ask_size) / top_size;
+            } else {
+                features.microprice = features.mid;
+            }
+            if (bid_levels.size > 0 && ask_levels.size > 0) {
+                features.depth_imbalance = (bid_levels.size - ask_levels.size) / (bid_levels.size + ask_levels.size);
+                features.weighted_mid = (bid_levels.notional / bid_levels.size + ask_levels.notional / ask_levels.size) / 2;
+            } else {
+                features.weighted_mid = features.mid;
+            }
+        }
+
+        /**
+         * Helper function finding the lowest ask above a tick.
+         * @return tick of the ask, or PRICE_LADDER_NO_TICK.
+         */
+        long long findAskAbove(long long tick) {
+            ++level_visits;
+            return asks.nextAbove(tick);
+        }
+
+        /**
+         * Helper function finding the highest bid below a tick.
+         * @return tick of the bid, or PRICE_LADDER_NO_TICK.
+         */
+        long long findBidBelow(long long tick) {
+            ++level_visits;
+            return bids.nextBelow(tick);
+        }
+
+        /**
+         * Helper function finding the level at a price.
+         * @return pointer to the level, or nullptr if there is none.
+         */
+        Level* findLevel(double price_level) {
+            long long tick = toTick(price_level);
+            Level* level = bids.find(tick);
+            return level != nullptr ? level : asks.find(tick);
+        }
+
+        const Level* findLevel(double price_level) const {
+            return const_cast<BasicOrderBook*>(this)->findLevel(price_level);
+        }
+
+        /**
+         * Helper function finding the level one of our orders rests at.
+         * @return pointer to the level, or nullptr if the order is not resting in this book.
+         */
+        Level* findRestingLevel(const std::shared_ptr<Order>& order_ptr) {
+            uint32_t node = order_ptr->getBookNode();
+            if (node == NO_BOOK_NODE || node >= pool.getCapacity() || pool[node].order != order_ptr) {
+                return nullptr;
+            }
+            Level* level = bids.find(pool[node].tick);
+            return level != nullptr ? level : asks.find(pool[node].tick);
+        }
+
+        const Level* findRestingLevel(const std::shared_ptr<Order>& order_ptr) const {
+            return const_cast<BasicOrderBook*>(this)->findRestingLevel(order_ptr);
+        }
+
+        /**
+         * Helper function to find the bid which is less than current_level
+        */
+        double getNextBuySideLevel(double current_level) {
+            long long tick = bids.nextBelow(toTick(current_level));
+
+            // No lower level found, return -1
+            return tick != PRICE_LADDER_NO_TICK ? toPrice(tick) : -1;
+        }
+
+        /**
+         * Helper function to find the ask which is greater than current_level
+         */
+        double getNextSellSideLevel(double current_level) {
+            long long tick = asks.nextAbove(toTick(current_level));
+
+            // No higher level found, return -1
+            return tick != PRICE_LADDER_NO_TICK ? toPrice(tick) : -1;
+        }
+
+        /**
+         * Helper function to reduce the total order size of a given level.
+         */
+        void reduceOrder(double price_level, double num_to_reduce) {
+            if (Level* level = findLevel(price_level)) {
+                // Only orders that are not ours are reduced, from the back of the queue
+                if (num_to_reduce > 0) {
+                    level->reduceMarket(pool, num_to_reduce);
+                }
+                syncDepth(toTick(price_level));
+            }
         }
 
         /**
@@ -611,19 +1287,13 @@ class OrderBook {
         vector<std::shared_ptr<Order>> getOurOrderPtr(double price_level) {
             std::vector<std::shared_ptr<Order>> result;
 
-            if (book.find(price_level) != book.end()) {
-                const auto& order_queue = book.at(price_level).second;
+            const Level* level = findLevel(price_level);
+            if (level == nullptr || level->num_our_orders == 0) {
+                return result;
+            }
 
-                // Iterate over the queue
-                std::queue<std::pair<double, std::shared_ptr<Order>>> temp_queue = order_queue;
-                while (!temp_queue.empty()) {
-                    const auto& order_pair = temp_queue.front();
-                    if (order_pair.second != nullptr) {
-                        // Add non-null shared pointer to the result vector
-                        result.push_back(order_pair.second);
-                    }
-                    temp_queue.pop();
-                }
+            for (uint32_t node = level->head; node != NO_BOOK_NODE; node = pool[node].next) {
+                result.push_back(pool[node].order);
             }
 
             return result;
@@ -632,5 +1302,27 @@ class OrderBook {
         std::shared_ptr<Exchange> exchange;     /*< Exchange */
         std::shared_ptr<Security> security;     /*< Security */
         MarketType market_type;                 /*< Market type (Spot or Futures) */
-        map<double, pair<int, queue<pair<double, std::shared_ptr<Order>>>>> book;      /*< Orderbook; key is price level; value is pair of order side (1 or -1) and queue of orders */
-};
\ No newline at end of file
+        OrderNodePool pool;                     /*< Nodes of our orders resting at any level */
+        PriceLadder<Level> bids;                /*< Buy side levels indexed by tick */
+        PriceLadder<Level> asks;                /*< Sell side levels indexed by tick */
+        DepthTree bid_depth;                    /*< Size of other market participants at each bid, by negated tick */
+        DepthTree ask_depth;                    /*< Size of other market participants at each ask, by tick */
+        long long best_bid = PRICE_LADDER_NO_TICK;  /*< Tick of the highest bid level */
+        long long best_ask = PRICE_LADDER_NO_TICK;  /*< Tick of the lowest ask level */
+        uint64_t level_visits = 0;              /*< Levels visited by findAskAbove and findBidBelow */
+        uint64_t crossed_levels = 0;            /*< Levels removed by crossLevel */
+        uint64_t dropped_levels = 0;            /*< Levels dropped by trimLevels */
+        uint64_t reclaimed_levels = 0;          /*< Empty levels erased by reclaimLevel and sweep */
+        uint64_t rejected_snapshots = 0;        /*< Snapshots dropped by applySnapshot */
+        FeatureLevels bid_levels;               /*< Best bids the depth features cover */
+        FeatureLevels ask_levels;               /*< Best asks the depth features cover */
+        BookFeatures features;                  /*< Features as of the last change */
+        double last_trade_price = -1.0;         /*< Price of the last trade, or -1 */
+        BookHistory history;                    /*< Top of book at the times recorded */
+};
+
+
+/**
+ * Order book keeping every level, as the backtester uses.
+ */
+using OrderBook = BasicOrderBook<FullDepth>;
\ No newline at end of file
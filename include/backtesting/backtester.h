@@ -1,19 +1,25 @@
 #pragma once
 
+#include "./consolidatedbook.h"
 #include "./order.h"
-#include "./orderbook.h"
+#include "./OrderBook.h"
 #include "./strategy.h"
 #include "./trade.h"
 #include "./user.h"
 #include "../data/exchange.h"
+#include "../data/eventmerge.h"
+#include "../data/eventstore.h"
+#include "../data/marketevent.h"
+#include "../data/pipeline.h"
 #include "../data/security.h"
+#include "../data/symboltable.h"
 #include "../record/tradelog.h"
 #include <boost/accumulators/accumulators.hpp>
-#include <boost/algorithm/string.hpp>
 
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -24,6 +30,21 @@ using namespace boost;
 
 
 
+/**
+ * Start and end times of runBacktest meaning the whole market data.
+ */
+constexpr long long BACKTEST_START_OF_DATA = numeric_limits<long long>::min();
+constexpr long long BACKTEST_END_OF_DATA = numeric_limits<long long>::max();
+
+/**
+ * Custom hash function for pair<MarketType, Security>
+ */
+struct SecurityKeyHash {
+    size_t operator()(const pair<MarketType, Security>& key) const {
+        return static_cast<size_t>(key.first) ^ (Security::Hash{}(key.second) << 1);
+    }
+};
+
 /**
  * Class for backtesting
  */
@@ -31,6 +52,8 @@ class Backtester {
     public:
         using MarketKey = tuple<MarketType, Exchange, Security>;
         using MarketMap = unordered_map<MarketKey, std::shared_ptr<OrderBook>, MarketKeyHash>;
+        using SecurityKey = pair<MarketType, Security>;
+        using ConsolidatedMap = unordered_map<SecurityKey, std::shared_ptr<ConsolidatedBook>, SecurityKeyHash>;
 
     /**
      * Constructor
@@ -50,6 +73,7 @@ class Backtester {
     */
     void Clear(map<MarketType, double> initial_buying_power) {
         orderbooks.clear();
+        consolidated_books.clear();
         loadOrderBook();
         orderlog.Clear();
         tradelog.Clear();
@@ -60,14 +84,38 @@ class Backtester {
 
     /**
      * Load Orderbook data.
+     * Also builds the symbol table of all listed securities and resolves each entry to its exchange, security and
+     * orderbook, so instruments of the market data are bound with one perfect hash lookup.
+     * The orderbooks of a security on all exchanges are the venues of its consolidated book, in the order of the
+     * user's exchanges.
      */
     void loadOrderBook() {
+        vector<Instrument> listed;
         for (auto&& exchanges : user.getExchanges()) {
             for (auto&& securities : exchanges->getListedSecurities(MarketType::Spot)) {
-                orderbooks[make_tuple(MarketType::Spot, *exchanges, *securities)] = make_shared<OrderBook>(exchanges, MarketType::Spot, securities);
+                createOrderBook(exchanges, MarketType::Spot, securities);
+                listed.push_back({exchanges->getName(), securities->getBase() + "/" + securities->getQuote(), MarketType::Spot});
             }
             for (auto&& securities : exchanges->getListedSecurities(MarketType::Futures)) {
-                orderbooks[make_tuple(MarketType::Futures, *exchanges, *securities)] = make_shared<OrderBook>(exchanges, MarketType::Futures, securities);
+                createOrderBook(exchanges, MarketType::Futures, securities);
+                listed.push_back({exchanges->getName(), securities->getBase() + "/" + securities->getQuote(), MarketType::Futures});
+            }
+        }
+
+        symbols = make_shared<const SymbolTable>(listed);
+        symbol_bindings.assign(symbols->size(), MarketBinding{});
+        for (size_t id = 0; id < symbols->size(); ++id) {
+            const Instrument& instrument = symbols->at(static_cast<uint16_t>(id));
+            MarketBinding& binding = symbol_bindings[id];
+            binding.exchange = user.findExchange(instrument.exchange);
+            binding.security = binding.exchange->findSecurity(MarketType::Spot, instrument.symbol);
+            binding.market_type = instrument.market_type;
+
+            // Left unbound if not resolvable, so bindInstrument reports the error when the instrument shows up
+            auto it = binding.security ? orderbooks.find(make_tuple(instrument.market_type, *binding.exchange, *binding.security)) : orderbooks.end();
+            binding.orderbook = it != orderbooks.end() ? it->second : nullptr;
+            if (binding.orderbook != nullptr) {
+                bindConsolidated(binding);
             }
         }
     }
@@ -76,56 +124,88 @@ class Backtester {
      * Run backtest
      * 
      * Backtest steps:
-     *  1. Open the input data path and read/parse line-by-line
-     *  2. While reading line-by-line call strategy functions accordingly
+     *  1. Open the input data path (converting it to a cached event store if needed) and read event-by-event,
+     *     on a separate parser thread if pipelining is enabled
+     *  2. While reading event-by-event call strategy functions accordingly
      *  3. Also, update orderbooks and check trade fillabilities
      *  4. Record all trades
      * 
-     * @param data_path file path for market data input
+     * @param data_path file path for market data input (CSV or event store), or a glob pattern matching several files
+     * @param start_time only events at or after this time (nanoseconds since epoch) are replayed
+     * @param end_time only events before this time (nanoseconds since epoch) are replayed
      */
-    void runBacktest(const string& data_path) {
-        vector<std::shared_ptr<Order>> current_orders;
-        vector<TimeType*> timetype_vector;
-        ifstream file(data_path);
+    void runBacktest(const string& data_path, long long start_time = BACKTEST_START_OF_DATA, long long end_time = BACKTEST_END_OF_DATA) {
+        runBacktest(expandMarketDataPaths(data_path), start_time, end_time);
+    }
 
-        if (!file.is_open()) {
-            throw invalid_argument("Error opening the file");
-            return;
+    /**
+     * Run backtest on several market data files (e.g. one per exchange and day), merged by COLLECTION_TIME.
+     * With a start time, sources seek to it (event stores by binary search, CSV files through their timestamp index)
+     * instead of reading the data before it; reading stops at the end time.
+     * @param data_paths file paths for market data input, each ordered by time
+     * @param start_time only events at or after this time (nanoseconds since epoch) are replayed
+     * @param end_time only events before this time (nanoseconds since epoch) are replayed
+     */
+    void runBacktest(const vector<string>& data_paths, long long start_time = BACKTEST_START_OF_DATA, long long end_time = BACKTEST_END_OF_DATA) {
+        unique_ptr<EventSource> source = openMarketData(data_paths, use_event_cache, event_cache_directory, symbols);
+        if (start_time != BACKTEST_START_OF_DATA) {
+            source->seek(start_time);
+        }
+        if (pipelined) {
+            source = make_unique<PipelinedEventSource>(std::move(source));
         }
+        replay(*source, start_time, end_time);
+    }
 
-        int n = 2;
-        string line;
-        getline(file, line);    // Skip first line
-        while (getline(file, line)) {
-            vector<string> tokens;
-            boost::split(tokens, line, boost::is_any_of(","));
+    /**
+     * Run backtest on the events of an event source.
+     * @param source source of market events
+     * @param start_time events before this time (nanoseconds since epoch) are skipped
+     * @param end_time replay stops at the first event at or after this time (nanoseconds since epoch)
+     */
+    void replay(EventSource& source, long long start_time = BACKTEST_START_OF_DATA, long long end_time = BACKTEST_END_OF_DATA) {
+        vector<std::shared_ptr<Order>> current_orders;
+        vector<MarketBinding> bindings;
+        MarketEvent event;
 
-            // Finding Exchange
-            std::shared_ptr<Exchange> exchange_ptr = user.findExchange(tokens[4]);
+        // Fill buffers reused across events, so events that fill nothing do not allocate
+        OrderBook::RestingFills filled_orders;
+        OrderBook::OrderFills fills;
 
-            if (exchange_ptr == nullptr) {
-                throw runtime_error("Exchange " + tokens[4] + " is not found");
+        while (source.nextEvent(event)) {
+            // Sources that cannot seek, or seek to an earlier row, deliver events before the window
+            if (event.timestamp < start_time) {
+                continue;
+            }
+            if (event.timestamp >= end_time) {
+                break;
             }
 
-            // Finding Security
-            std::shared_ptr<Security> security_ptr = exchange_ptr->findSecurity(MarketType::Spot, tokens[3]);
-
-            if (security_ptr == nullptr) {
-                throw runtime_error("Security " + tokens[3] + " is not found");
+            // Finding Exchange, Security and Orderbook the first time an instrument appears
+            if (event.instrument_id >= bindings.size()) {
+                bindings.resize(source.getInstruments().size());
             }
+            MarketBinding& binding = bindings[event.instrument_id];
+            if (binding.orderbook == nullptr) {
+                binding = bindInstrument(source.getInstruments().at(event.instrument_id));
+            }
+
+            const std::shared_ptr<Exchange>& exchange_ptr = binding.exchange;
+            const std::shared_ptr<Security>& security_ptr = binding.security;
 
             // Calling strategy functions
             vector<std::shared_ptr<Order>> order_vector;
-            MarketType mt = tokens[5] == "S" ? MarketType::Spot : MarketType::Futures;
-            std::shared_ptr<TimeType> tt = std::make_shared<TimeType>(tokens[0]);
-            std::shared_ptr<OrderBook> ob = getOrderbook(mt, *exchange_ptr, *security_ptr);
+            MarketType mt = binding.market_type;
+            long long tt = event.timestamp;
+            const std::shared_ptr<OrderBook>& ob = binding.orderbook;
 
 
-            if (tokens[2] == "T") {
-                last_traded_price[make_pair(mt, security_ptr)] = stod(tokens[6]);
-                vector<tuple<std::shared_ptr<Order>, double, double>> filled_orders = ob->tradeOccurred(last_traded_price[make_pair(mt, security_ptr)], stod(tokens[7]));
+            if (event.message_type == MessageType::Trade) {
+                last_traded_price[make_pair(mt, security_ptr)] = event.price;
+                filled_orders.clear();
+                ob->tradeOccurred(last_traded_price[make_pair(mt, security_ptr)], event.size, filled_orders);
 
-                for (auto it : filled_orders) {
+                for (const auto& it : filled_orders) {
                     std::get<0>(it)->fillOrder(std::get<2>(it), std::get<1>(it));
 
                     Trade* trade = new Trade(std::get<0>(it), tt, std::get<0>(it)->getSide(), std::get<2>(it), std::get<1>(it), true);
@@ -136,15 +216,17 @@ class Backtester {
                 }
 
 
-                TradeEventMsg msg(tt, exchange_ptr, mt, security_ptr, ob, stod(tokens[6]), stod(tokens[7]));
+                publishTopOfBook(binding, tt);
+                TradeEventMsg msg(tt, exchange_ptr, mt, security_ptr, ob, event.price, event.size, binding.consolidated);
                 order_vector = strategy->onTrade(msg);
             }
 
-            else if (tokens[2] == "BID_UPDATE" || tokens[2] == "ASK_UPDATE") {
-                vector<tuple<std::shared_ptr<Order>, double, double>> filled_orders = tokens[2] == "BID_UPDATE" ? ob->buySideUpdated(stod(tokens[8]), stod(tokens[9])) 
-                        : ob->sellSideUpdated(stod(tokens[14]), stod(tokens[15]));
+            else if (event.message_type == MessageType::BidUpdate || event.message_type == MessageType::AskUpdate) {
+                // Quote rows carry the best levels of both sides; the book takes all of them in one pass
+                filled_orders.clear();
+                ob->applySnapshot(event.bid_price, event.bid_size, event.ask_price, event.ask_size, MARKET_EVENT_NUM_LEVELS, filled_orders);
 
-                for (auto it : filled_orders) {
+                for (const auto& it : filled_orders) {
                     std::get<0>(it)->fillOrder(std::get<2>(it), std::get<1>(it));
 
                     Trade* trade = new Trade(std::get<0>(it), tt, std::get<0>(it)->getSide(), std::get<2>(it), std::get<1>(it), true);
@@ -154,15 +236,20 @@ class Backtester {
                     strategy->updatePosition(std::get<0>(it)->getMarketType(), *std::get<0>(it)->getExchange(), *std::get<0>(it)->getSecurity(), std::get<0>(it)->getSide()*std::get<2>(it));
                 }
 
-                QuoteEventMsg msg(tt, exchange_ptr, mt, security_ptr, ob, stod(tokens[8]), stod(tokens[9]), stod(tokens[14]), stod(tokens[15]));
+                publishTopOfBook(binding, tt);
+                QuoteEventMsg msg(tt, exchange_ptr, mt, security_ptr, ob, event.bid_price[0], event.bid_size[0], event.ask_price[0], event.ask_size[0], binding.consolidated);
                 order_vector = strategy->onTopQuote(msg);
             }
 
-            else if (tokens[2] == "BUY_SIDE_UPDATE" || tokens[2] == "SELL_SIDE_UPDATE") {
-                vector<tuple<std::shared_ptr<Order>, double, double>> filled_orders = tokens[2] == "BUY_SIDE_UPDATE" ? ob->buySideUpdated(stod(tokens[6]), stod(tokens[7])) 
-                        : ob->sellSideUpdated(stod(tokens[6]), stod(tokens[7]));
+            else if (event.message_type == MessageType::BuySideUpdate || event.message_type == MessageType::SellSideUpdate) {
+                filled_orders.clear();
+                if (event.message_type == MessageType::BuySideUpdate) {
+                    ob->buySideUpdated(event.price, event.size, filled_orders);
+                } else {
+                    ob->sellSideUpdated(event.price, event.size, filled_orders);
+                }
 
-                for (auto it : filled_orders) {
+                for (const auto& it : filled_orders) {
                     std::get<0>(it)->fillOrder(std::get<2>(it), std::get<1>(it));
 
                     Trade* trade = new Trade(std::get<0>(it), tt, std::get<0>(it)->getSide(), std::get<2>(it), std::get<1>(it), true);
@@ -172,7 +259,8 @@ class Backtester {
                     strategy->updatePosition(std::get<0>(it)->getMarketType(), *std::get<0>(it)->getExchange(), *std::get<0>(it)->getSecurity(), std::get<0>(it)->getSide()*std::get<2>(it));
                 }
 
-                DepthEventMsg msg(tt, exchange_ptr, mt, security_ptr, ob, tokens[2] == "BUY_SIDE_UPDATE" ? 1 : -1, stod(tokens[6]), stod(tokens[7]));
+                publishTopOfBook(binding, tt);
+                DepthEventMsg msg(tt, exchange_ptr, mt, security_ptr, ob, event.message_type == MessageType::BuySideUpdate ? 1 : -1, event.price, event.size, binding.consolidated);
                 order_vector = strategy->onDepth(msg);
             }
 
@@ -194,25 +282,28 @@ class Backtester {
             // Work with orders
             for (auto&& it : current_orders) {
                 if (it->getOrderState() == OrderState::SentToExchange) {
-                    it->checkOrderReceived(*tt);
+                    it->checkOrderReceived(tt);
                 }
                 if (it->isLiveOrder() && (it->getOrderType() == "STOP" || it->getOrderType() == "STOPLIMIT")) {
                     it->checkTriggered(last_traded_price[make_pair(mt, security_ptr)]);
                 }
                 if (it->checkFillability(ob->getBestBid(),ob->getBestAsk())) {
-                    pair<std::shared_ptr<Order>, vector<pair<double, double>>> fills;
+                    fills.clear();
 
                     if (it->getOrderType() == "MARKET" || it->getOrderType() == "STOP") {
-                        fills = ob->fillMarketOrder(it);
+                        ob->fillMarketOrder(it, fills);
                     } else if (it->getOrderType() == "LIMIT" || it->getOrderType() == "STOPLIMIT") {
                         double qty_fillable = min(ob->getLimitInstantFillQuantity(it->getPrice(), it->getSide()), it->getLeverageAdjustedBaseCurrencySize());
-                        if (qty_fillable != 0) { fills = ob->instantFillLimit(it, qty_fillable); }
+                        if (qty_fillable != 0) { ob->instantFillLimit(it, qty_fillable, fills); }
                         if (qty_fillable < it->getLeverageAdjustedBaseCurrencySize()) {
-                            ob->addOrder(it->getPrice(), it->getSide(), it->getLeverageAdjustedBaseCurrencySize() - qty_fillable, it);
+                            // Only the instant fills are reported; the book's fills of a remainder crossing it never were
+                            size_t num_fills = fills.size();
+                            ob->addOrder(it->getPrice(), it->getSide(), it->getLeverageAdjustedBaseCurrencySize() - qty_fillable, it, fills);
+                            fills.resize(num_fills);
                         }
                     }
 
-                    for (auto& fill_pair : fills.second) {
+                    for (auto& fill_pair : fills) {
                         it->fillOrder(fill_pair.second, fill_pair.first);
                     
                         if (it->getSide() == 1) {
@@ -232,12 +323,24 @@ class Backtester {
             // Remove not-live orders
             for (auto it = current_orders.begin(); it != current_orders.end();) {
                 if (!(*it)->isLiveOrder() && !((*it)->getOrderState() == OrderState::SentToExchange)) {
+                    // Cancelled orders leave the queue they were resting in
+                    if ((*it)->getBookNode() != NO_BOOK_NODE) {
+                        auto book = orderbooks.find(make_tuple((*it)->getMarketType(), *(*it)->getExchange(), *(*it)->getSecurity()));
+                        if (book != orderbooks.end()) {
+                            book->second->removeOrder(*it);
+                            book->second->recordHistory(tt);
+                            updateConsolidated(book->second);
+                        }
+                    }
                     it = current_orders.erase(it);
                 } else {
                     ++it;
                 }
             }
 
+            // Orders filled or rested against the book may have moved its top
+            publishTopOfBook(binding, tt);
+
             // Record balance history
             if (tradelog.getTrades().empty()) {
                 tradelog.addBalanceHistory(tt, user.getCapital(MarketType::Spot), user.getCapital(MarketType::Futures));
@@ -303,14 +406,126 @@ class Backtester {
      */
     TradeLog& getTradeLog() {return tradelog;}
 
+    /**
+     * Setter for whether CSV market data is converted to a cached event store.
+     */
+    void setUseEventCache(bool use_event_cache_) {use_event_cache = use_event_cache_;}
+
+    /**
+     * Setter for the directory holding cached event stores. If empty, stores are placed next to the CSV files.
+     */
+    void setEventCacheDirectory(const string& event_cache_directory_) {event_cache_directory = event_cache_directory_;}
+
+    /**
+     * Setter for whether market data is read and decoded on a separate thread while the backtest runs.
+     * Events are replayed in the same order either way, so results do not change.
+     */
+    void setPipelined(bool pipelined_) {pipelined = pipelined_;}
+
     private:
+    /**
+     * Exchange, security and orderbook an instrument of an event source refers to.
+     */
+    struct MarketBinding {
+        std::shared_ptr<Exchange> exchange;
+        std::shared_ptr<Security> security;
+        MarketType market_type;
+        std::shared_ptr<OrderBook> orderbook;
+        std::shared_ptr<ConsolidatedBook> consolidated;     /*< Consolidated book of the security */
+        size_t venue = 0;                                   /*< Venue of orderbook in consolidated */
+    };
+
     User user;
     Strategy* strategy;
     MarketMap orderbooks;
+    ConsolidatedMap consolidated_books;             /*< Best bid and ask of each security across exchanges */
     OrderLog orderlog;
     TradeLog tradelog;
     map<pair<MarketType, std::shared_ptr<Security>>, double> last_traded_price;
     vector<pair<int, pair<double, double>>> latency_analysis_pnl;
+    bool use_event_cache = true;
+    string event_cache_directory;
+    bool pipelined = false;
+    std::shared_ptr<const SymbolTable> symbols;     /*< Listed securities of all exchanges */
+    vector<MarketBinding> symbol_bindings;          /*< Exchange, security and orderbook of each entry of symbols */
+
+    /**
+     * Finds exchange, security and orderbook of an instrument.
+     */
+    MarketBinding bindInstrument(const Instrument& instrument) {
+        int symbol_id = symbols->find(instrument.exchange, instrument.symbol, instrument.market_type);
+        if (symbol_id != SYMBOL_NOT_FOUND && symbol_bindings[symbol_id].orderbook != nullptr) {
+            return symbol_bindings[symbol_id];
+        }
+
+        // Finding Exchange
+        std::shared_ptr<Exchange> exchange_ptr = user.findExchange(instrument.exchange);
+
+        if (exchange_ptr == nullptr) {
+            throw runtime_error("Exchange " + instrument.exchange + " is not found");
+        }
+
+        // Finding Security
+        std::shared_ptr<Security> security_ptr = exchange_ptr->findSecurity(MarketType::Spot, instrument.symbol);
+
+        if (security_ptr == nullptr) {
+            throw runtime_error("Security " + instrument.symbol + " is not found");
+        }
+
+        MarketBinding binding{exchange_ptr, security_ptr, instrument.market_type, getOrderbook(instrument.market_type, *exchange_ptr, *security_ptr), nullptr};
+        bindConsolidated(binding);
+        return binding;
+    }
+
+    /**
+     * Creates the orderbook of a security on an exchange and adds it as a venue of the security's consolidated book.
+     */
+    void createOrderBook(std::shared_ptr<Exchange> exchange, MarketType market_type, std::shared_ptr<Security> security) {
+        std::shared_ptr<OrderBook> orderbook = make_shared<OrderBook>(exchange, market_type, security);
+        orderbooks[make_tuple(market_type, *exchange, *security)] = orderbook;
+
+        std::shared_ptr<ConsolidatedBook>& consolidated = consolidated_books[make_pair(market_type, *security)];
+        if (consolidated == nullptr) {
+            consolidated = make_shared<ConsolidatedBook>();
+        }
+        consolidated->addVenue(orderbook);
+    }
+
+    /**
+     * Finds the consolidated book and venue of the orderbook of a binding.
+     */
+    void bindConsolidated(MarketBinding& binding) {
+        auto it = consolidated_books.find(make_pair(binding.market_type, *binding.security));
+        int venue = it != consolidated_books.end() ? it->second->findVenue(binding.orderbook.get()) : -1;
+
+        if (venue == -1) {
+            throw invalid_argument("Consolidated book not found");
+            return;
+        }
+
+        binding.consolidated = it->second;
+        binding.venue = venue;
+    }
+
+    /**
+     * Records the top of book of a binding's orderbook in its history and refreshes its venue in the consolidated book,
+     * after the orderbook changed.
+     */
+    void publishTopOfBook(MarketBinding& binding, long long timestamp) {
+        binding.orderbook->recordHistory(timestamp);
+        binding.consolidated->update(binding.venue);
+    }
+
+    /**
+     * Refreshes the venue of an orderbook in its consolidated book, after the orderbook changed outside its events.
+     */
+    void updateConsolidated(const std::shared_ptr<OrderBook>& orderbook) {
+        auto it = consolidated_books.find(make_pair(orderbook->getMarketType(), *orderbook->getSecurity()));
+        int venue = it != consolidated_books.end() ? it->second->findVenue(orderbook.get()) : -1;
+        if (venue != -1) {
+            it->second->update(venue);
+        }
+    }
 
     std::shared_ptr<OrderBook> getOrderbook(MarketType market_type, const Exchange& exchange, const Security& security) {
         MarketKey key = make_tuple(market_type, exchange, security);
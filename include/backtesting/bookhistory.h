@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Default number of entries a BookHistory keeps.
+ */
+constexpr size_t BOOK_HISTORY_CAPACITY = 4096;
+
+/**
+ * Top of book of an order book as of a point in time.
+ */
+struct BookHistoryEntry {
+    long long timestamp = 0;            /*< Time the entry was recorded, in nanoseconds since epoch */
+    double bid_price = -1.0;            /*< Best bid price, or -1 if there were no bids */
+    double ask_price = -1.0;            /*< Best ask price, or -1 if there were no asks */
+    double last_trade_price = -1.0;     /*< Price of the last trade, or -1 if there was none */
+};
+
+/**
+ * Ring of the latest top of book entries of an order book, oldest first, with as-of queries by binary search.
+ * Timestamps are kept apart from the prices, so a search only touches the timestamps. An entry that repeats the
+ * previous one is not recorded, and an entry at the timestamp of the previous one replaces it, so the ring covers as
+ * much time as it can. The ring is allocated when the first entry is recorded.
+ */
+class BookHistory {
+    public:
+        /**
+         * Constructor
+         * @param capacity_ maximum number of entries kept; rounded up to a power of two.
+         */
+        explicit BookHistory(size_t capacity_ = BOOK_HISTORY_CAPACITY) {
+            if (capacity_ == 0) {
+                throw invalid_argument("History capacity should be positive");
+                return;
+            }
+            capacity = 1;
+            while (capacity < capacity_) {
+                capacity <<= 1;
+            }
+        }
+
+        /**
+         * Records the top of book at a time; the oldest entry is dropped once the ring is full.
+         * @param timestamp time in nanoseconds since epoch; a time before the last entry recorded is taken as that
+         *        entry's time.
+         */
+        void record(long long timestamp, double bid_price, double ask_price, double last_trade_price) {
+            if (count != 0) {
+                // Keeps the timestamps ordered for the searches if events come out of order
+                size_t newest = (first + count - 1) & (capacity - 1);
+                timestamp = max(timestamp, timestamps[newest]);
+
+                const BookHistoryEntry& last = entries[newest];
+                if (bid_price == last.bid_price && ask_price == last.ask_price && last_trade_price == last.last_trade_price) {
+                    return;
+                }
+                if (timestamp == timestamps[newest]) {
+                    entries[newest] = {timestamp, bid_price, ask_price, last_trade_price};
+                    return;
+                }
+            } else if (timestamps.empty()) {
+                timestamps.resize(capacity);
+                entries.resize(capacity);
+            }
+
+            size_t slot = (first + count) & (capacity - 1);
+            timestamps[slot] = timestamp;
+            entries[slot] = {timestamp, bid_price, ask_price, last_trade_price};
+            if (count == capacity) {
+                first = (first + 1) & (capacity - 1);
+            } else {
+                ++count;
+            }
+        }
+
+        /**
+         * Finds the top of book as of a time: the latest entry recorded at or before it.
+         * @param timestamp time in nanoseconds since epoch.
+         * @param entry set to the entry if one is found.
+         * @return whether an entry was found; false if the time is before the oldest entry kept.
+         */
+        bool asOf(long long timestamp, BookHistoryEntry& entry) const {
+            // Number of entries at or before timestamp, counted from the oldest
+            size_t low = 0, high = count;
+            while (low < high) {
+                size_t middle = (low + high) / 2;
+                if (timestamps[(first + middle) & (capacity - 1)] <= timestamp) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+
+            if (low == 0) {
+                return false;
+            }
+            entry = entries[(first + low - 1) & (capacity - 1)];
+            return true;
+        }
+
+        /**
+         * Getter for an entry.
+         * @param index index of the entry, 0 for the oldest one kept.
+         */
+        const BookHistoryEntry& at(size_t index) const {
+            if (index >= count) {
+                throw out_of_range("History entry " + to_string(index) + " is out of range");
+            }
+            return entries[(first + index) & (capacity - 1)];
+        }
+
+        /**
+         * Drops all entries, keeping the ring allocated.
+         */
+        void clear() {
+            first = 0;
+            count = 0;
+        }
+
+        /**
+         * Getter for the number of entries kept.
+         */
+        size_t size() const {return count;}
+
+        /**
+         * Getter for the maximum number of entries kept.
+         */
+        size_t getCapacity() const {return capacity;}
+
+    private:
+        vector<long long> timestamps;       /*< Timestamp of each slot */
+        vector<BookHistoryEntry> entries;   /*< Entry of each slot */
+        size_t capacity;                    /*< Number of slots; a power of two */
+        size_t first = 0;                   /*< Slot of the oldest entry */
+        size_t count = 0;                   /*< Number of entries kept */
+};
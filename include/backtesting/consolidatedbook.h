@@ -0,0 +1,230 @@
+#pragma once
+
+#include "./OrderBook.h"
+#include "../data/exchange.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Venue index of an empty tournament slot.
+ */
+constexpr uint32_t CONSOLIDATED_NO_VENUE = numeric_limits<uint32_t>::max();
+
+/**
+ * Best bid and ask of one security across exchanges.
+ * Each exchange's orderbook is a venue; the top of book of a venue is cached and the best of all venues is kept in a
+ * tournament tree per side, so refreshing a venue after its book changed costs O(log venues) and reading the
+ * consolidated top of book costs O(1). Ties go to the venue added first.
+ */
+class ConsolidatedBook {
+    public:
+        /**
+         * Cached top of book of a venue.
+         */
+        struct VenueQuote {
+            std::shared_ptr<OrderBook> orderbook;   /*< Orderbook of the venue */
+            double bid_price = -1.0;                /*< Best bid price, or -1 if there are no bids */
+            double bid_size = 0.0;                  /*< Total size at the best bid */
+            double ask_price = -1.0;                /*< Best ask price, or -1 if there are no asks */
+            double ask_size = 0.0;                  /*< Total size at the best ask */
+        };
+
+        /**
+         * Adds the orderbook of an exchange as a venue.
+         * @param orderbook orderbook of the venue; its current top of book is taken right away.
+         * @return index of the venue, passed to update.
+         */
+        size_t addVenue(std::shared_ptr<OrderBook> orderbook) {
+            if (orderbook == nullptr) {
+                throw invalid_argument("Orderbook of a venue should not be null");
+                return 0;
+            }
+
+            quotes.push_back({orderbook});
+            size_t leaves = 1;
+            while (leaves < quotes.size()) {
+                leaves <<= 1;
+            }
+            if (leaves != num_leaves) {
+                num_leaves = leaves;
+                bid_tree.assign(2 * num_leaves, CONSOLIDATED_NO_VENUE);
+                ask_tree.assign(2 * num_leaves, CONSOLIDATED_NO_VENUE);
+                for (size_t venue = 0; venue + 1 < quotes.size(); ++venue) {
+                    bid_tree[num_leaves + venue] = quotes[venue].bid_price != -1.0 ? venue : CONSOLIDATED_NO_VENUE;
+                    ask_tree[num_leaves + venue] = quotes[venue].ask_price != -1.0 ? venue : CONSOLIDATED_NO_VENUE;
+                }
+                for (size_t node = num_leaves - 1; node > 0; --node) {
+                    bid_tree[node] = betterBid(bid_tree[2 * node], bid_tree[2 * node + 1]);
+                    ask_tree[node] = betterAsk(ask_tree[2 * node], ask_tree[2 * node + 1]);
+                }
+            }
+
+            update(quotes.size() - 1);
+            return quotes.size() - 1;
+        }
+
+        /**
+         * Finds the venue of an orderbook.
+         * @return index of the venue, or -1 if the orderbook is not a venue of this book.
+         */
+        int findVenue(const OrderBook* orderbook) const {
+            for (size_t venue = 0; venue < quotes.size(); ++venue) {
+                if (quotes[venue].orderbook.get() == orderbook) {
+                    return static_cast<int>(venue);
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * Refreshes the top of book of a venue from its orderbook.
+         * Call after the orderbook changed; does nothing if its top of book did not.
+         * @param venue index returned by addVenue.
+         */
+        void update(size_t venue) {
+            if (venue >= quotes.size()) {
+                throw out_of_range("Venue " + to_string(venue) + " is not in the consolidated book");
+                return;
+            }
+
+            VenueQuote& quote = quotes[venue];
+            const BookFeatures& features = quote.orderbook->getFeatures();
+            double bid_price = features.bid_price;
+            double bid_size = features.bid_size;
+            double ask_price = features.ask_price;
+            double ask_size = features.ask_size;
+
+            // The winners only depend on prices; sizes are read through the winning venue
+            bool bid_moved = bid_price != quote.bid_price;
+            bool ask_moved = ask_price != quote.ask_price;
+            quote.bid_price = bid_price;
+            quote.bid_size = bid_size;
+            quote.ask_price = ask_price;
+            quote.ask_size = ask_size;
+
+            if (bid_moved) {
+                size_t node = num_leaves + venue;
+                bid_tree[node] = bid_price != -1.0 ? venue : CONSOLIDATED_NO_VENUE;
+                for (node >>= 1; node > 0; node >>= 1) {
+                    bid_tree[node] = betterBid(bid_tree[2 * node], bid_tree[2 * node + 1]);
+                }
+            }
+            if (ask_moved) {
+                size_t node = num_leaves + venue;
+                ask_tree[node] = ask_price != -1.0 ? venue : CONSOLIDATED_NO_VENUE;
+                for (node >>= 1; node > 0; node >>= 1) {
+                    ask_tree[node] = betterAsk(ask_tree[2 * node], ask_tree[2 * node + 1]);
+                }
+            }
+        }
+
+        /**
+         * Getter for the best bid price across venues.
+         * @return highest bid price, or -1 if no venue has bids.
+         */
+        double getBestBid() const {
+            return getBestBidVenue() != -1 ? quotes[bid_tree[1]].bid_price : -1.0;
+        }
+
+        /**
+         * Getter for the size at the best bid, of the venue holding it.
+         */
+        double getBestBidSize() const {
+            return getBestBidVenue() != -1 ? quotes[bid_tree[1]].bid_size : 0.0;
+        }
+
+        /**
+         * Getter for the exchange holding the best bid.
+         * @return exchange, or nullptr if no venue has bids.
+         */
+        std::shared_ptr<Exchange> getBestBidExchange() const {
+            return getBestBidVenue() != -1 ? quotes[bid_tree[1]].orderbook->getExchange() : nullptr;
+        }
+
+        /**
+         * Getter for the venue holding the best bid.
+         * @return index of the venue, or -1 if no venue has bids.
+         */
+        int getBestBidVenue() const {
+            return num_leaves != 0 && bid_tree[1] != CONSOLIDATED_NO_VENUE ? static_cast<int>(bid_tree[1]) : -1;
+        }
+
+        /**
+         * Getter for the best ask price across venues.
+         * @return lowest ask price, or -1 if no venue has asks.
+         */
+        double getBestAsk() const {
+            return getBestAskVenue() != -1 ? quotes[ask_tree[1]].ask_price : -1.0;
+        }
+
+        /**
+         * Getter for the size at the best ask, of the venue holding it.
+         */
+        double getBestAskSize() const {
+            return getBestAskVenue() != -1 ? quotes[ask_tree[1]].ask_size : 0.0;
+        }
+
+        /**
+         * Getter for the exchange holding the best ask.
+         * @return exchange, or nullptr if no venue has asks.
+         */
+        std::shared_ptr<Exchange> getBestAskExchange() const {
+            return getBestAskVenue() != -1 ? quotes[ask_tree[1]].orderbook->getExchange() : nullptr;
+        }
+
+        /**
+         * Getter for the venue holding the best ask.
+         * @return index of the venue, or -1 if no venue has asks.
+         */
+        int getBestAskVenue() const {
+            return num_leaves != 0 && ask_tree[1] != CONSOLIDATED_NO_VENUE ? static_cast<int>(ask_tree[1]) : -1;
+        }
+
+        /**
+         * Getter for the cached top of book of a venue.
+         */
+        const VenueQuote& getVenueQuote(size_t venue) const {return quotes.at(venue);}
+
+        /**
+         * Getter for the number of venues.
+         */
+        size_t getNumVenues() const {return quotes.size();}
+
+    private:
+        vector<VenueQuote> quotes;      /*< Top of book of each venue */
+        vector<uint32_t> bid_tree;      /*< Tournament of the bids; node 1 is the root, leaves start at num_leaves */
+        vector<uint32_t> ask_tree;      /*< Tournament of the asks; same layout as bid_tree */
+        size_t num_leaves = 0;          /*< Number of leaves of the tournaments; a power of two */
+
+        /**
+         * Winner of two venues on the bid side; the left one is added first and wins ties.
+         */
+        uint32_t betterBid(uint32_t left, uint32_t right) const {
+            if (left == CONSOLIDATED_NO_VENUE) {
+                return right;
+            }
+            if (right == CONSOLIDATED_NO_VENUE) {
+                return left;
+            }
+            return quotes[right].bid_price > quotes[left].bid_price ? right : left;
+        }
+
+        /**
+         * Winner of two venues on the ask side; the left one is added first and wins ties.
+         */
+        uint32_t betterAsk(uint32_t left, uint32_t right) const {
+            if (left == CONSOLIDATED_NO_VENUE) {
+                return right;
+            }
+            if (right == CONSOLIDATED_NO_VENUE) {
+                return left;
+            }
+            return quotes[right].ask_price < quotes[left].ask_price ? right : left;
+        }
+};
@@ -0,0 +1,324 @@
+#pragma once
+
+#include "./priceladder.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Cumulative size of the price levels of one side of a book, indexed by tick.
+ * Answers "how much rests at or below a tick" and "which tick does a size reach" in O(log n) with a Fenwick tree over
+ * a window of ticks. The window grows and follows the touch by the same rules as PriceLadder; sizes outside it are kept
+ * in a sorted overflow map. Running totals of the overflow map, restarting on each side of the window, are cached and
+ * looked up by binary search; a change in the map only drops the totals from its tick on, which are summed again by
+ * the next query reaching them.
+ * Ticks are summed in increasing order, so the bid side of a book stores negated ticks to sum outward from the best bid.
+ */
+class DepthTree {
+    public:
+        /**
+         * Constructor
+         * @param max_ticks_ maximum number of ticks in the window; rounded up to a power of two.
+         */
+        explicit DepthTree(size_t max_ticks_ = PRICE_LADDER_MAX_TICKS) {
+            max_ticks = 1;
+            while (max_ticks < max_ticks_) {
+                max_ticks <<= 1;
+            }
+        }
+
+        /**
+         * Sets the size at a tick.
+         */
+        void set(long long tick, double size) {
+            if (!inWindow(tick)) {
+                auto it = overflow.find(tick);
+                double old_size = it != overflow.end() ? it->second : 0.0;
+                if (size == old_size) {
+                    return;
+                }
+                if (it == overflow.end()) {
+                    placeWindow(tick);
+                }
+            }
+
+            if (inWindow(tick)) {
+                size_t index = tick - base;
+                double delta = size - values[index];
+                int count_delta = (size != 0.0) - (values[index] != 0.0);
+                values[index] = size;
+                window_count += count_delta;
+                total += delta;
+                for (size_t i = index + 1; i <= capacity; i += i & (~i + 1)) {
+                    tree[i] += delta;
+                    counts[i] += count_delta;
+                }
+
+                // Rebuilding from the exact sizes once in a while drops rounding left over from the updates
+                if (++num_updates >= capacity) {
+                    rebuild(base, capacity);
+                }
+                return;
+            }
+
+            auto it = overflow.find(tick);
+            double old_size = it != overflow.end() ? it->second : 0.0;
+            dropOverflowSums(tick);
+            total += size - old_size;
+            if (tick < base) {
+                below_total += size - old_size;
+            }
+            if (size == 0.0) {
+                overflow.erase(tick);
+                if (overflow.empty() || overflow.begin()->first >= base) {
+                    below_total = 0.0;
+                }
+            } else {
+                overflow[tick] = size;
+            }
+        }
+
+        /**
+         * Getter for the size at a tick.
+         */
+        double get(long long tick) const {
+            if (inWindow(tick)) {
+                return values[tick - base];
+            }
+            auto it = overflow.find(tick);
+            return it != overflow.end() ? it->second : 0.0;
+        }
+
+        /**
+         * Total size at ticks at or below a tick.
+         */
+        double prefix(long long tick) const {
+            if (capacity == 0 || tick < base) {
+                return overflowPrefix(tick);
+            }
+
+            long long last = base + static_cast<long long>(capacity) - 1;
+            double window_result = 0.0;
+            int range_count = 0;
+            for (size_t i = static_cast<size_t>(min(tick, last) - base) + 1; i > 0; i -= i & (~i + 1)) {
+                window_result += tree[i];
+                range_count += counts[i];
+            }
+
+            // Sizes cleared from the window can leave rounding in the tree; a range holding no size sums to exactly 0
+            double result = below_total + (range_count != 0 ? window_result : 0.0);
+            return tick > last ? result + overflowPrefix(tick) : result;
+        }
+
+        /**
+         * Finds the lowest tick at which the total size at or below it reaches a size.
+         * @param size size to reach; should be positive.
+         * @return the tick, or PRICE_LADDER_NO_TICK if the whole side holds less.
+         */
+        long long reach(double size) const {
+            if (capacity == 0) {
+                return PRICE_LADDER_NO_TICK;
+            }
+
+            auto [below_tick, below_size] = overflowReach(base - 1, size);
+            if (below_tick != PRICE_LADDER_NO_TICK) {
+                return below_tick;
+            }
+            size -= below_size;
+
+            // Binary lifting down the tree: largest prefix of slots holding less than size
+            size_t position = 0;
+            int count = 0;
+            for (size_t step = capacity; step > 0; step >>= 1) {
+                if (position + step <= capacity && tree[position + step] < size) {
+                    position += step;
+                    size -= tree[position];
+                    count += counts[position];
+                }
+            }
+
+            // Rounding left in the tree can tip the search onto an empty slot; move on to the next size
+            if (position < capacity && values[position] == 0.0) {
+                position = 0;
+                for (size_t step = capacity; step > 0; step >>= 1) {
+                    if (position + step <= capacity && counts[position + step] <= count) {
+                        position += step;
+                        count -= counts[position];
+                    }
+                }
+            }
+            if (position < capacity) {
+                return base + static_cast<long long>(position);
+            }
+            return overflowReach(numeric_limits<long long>::max(), size).first;
+        }
+
+        /**
+         * Keeps a tick, typically the best price, in the middle half of the window, as PriceLadder::follow does. Once it
+         * drifts out of that band the window is recentered on it and the tree rebuilt.
+         */
+        void follow(long long tick) {
+            long long quarter = static_cast<long long>(capacity / 4);
+            if (capacity != 0 && (tick < base + quarter || tick >= base + 3 * quarter)) {
+                rebuild(tick - 2 * quarter, capacity);
+            }
+        }
+
+        /**
+         * Getter for the total size.
+         */
+        double getTotal() const {return total;}
+
+        /**
+         * Getter for number of ticks outside the window holding a size.
+         */
+        size_t getNumOverflowTicks() const {return overflow.size();}
+
+        /**
+         * Getter for the first tick the window covers.
+         */
+        long long getBase() const {return base;}
+
+    private:
+        bool inWindow(long long tick) const {
+            return capacity != 0 && tick >= base && tick - base < static_cast<long long>(capacity);
+        }
+
+        /**
+         * Helper function placing the window for a tick about to be set outside it, as PriceLadder does: the first size,
+         * or a size set while the window holds none, centers the window on its tick; otherwise the window grows to cover
+         * itself and the tick if they span at most max_ticks, and else stays where it is.
+         */
+        void placeWindow(long long tick) {
+            if (capacity == 0 || window_count == 0) {
+                size_t new_capacity = max(capacity, min(PRICE_LADDER_INITIAL_TICKS, max_ticks));
+                rebuild(tick - static_cast<long long>(new_capacity / 2), new_capacity);
+                return;
+            }
+
+            long long low = min(tick, base);
+            long long high = max(tick, base + static_cast<long long>(capacity) - 1);
+            unsigned long long span = static_cast<unsigned long long>(high - low) + 1;
+            if (capacity == max_ticks || span > max_ticks) {
+                return;
+            }
+
+            size_t new_capacity = capacity;
+            while (new_capacity < 2 * span && new_capacity < max_ticks) {
+                new_capacity <<= 1;
+            }
+            rebuild(low - static_cast<long long>((new_capacity - span) / 2), new_capacity);
+        }
+
+        /**
+         * Helper function summing the sizes of the overflow map at ticks at or below a tick outside the window, on the
+         * same side of the window as the tick.
+         */
+        double overflowPrefix(long long tick) const {
+            cacheOverflowSums(tick);
+            auto it = upper_bound(overflow_sums.begin(), overflow_sums.end(), tick, [](long long key, const pair<long long, double>& entry) {return key < entry.first;});
+            return it == overflow_sums.begin() || (prev(it)->first < base) != (tick < base) ? 0.0 : prev(it)->second;
+        }
+
+        /**
+         * Helper function finding the first tick of the overflow map, on the side of the window of a tick and at or below
+         * it, at which the running total reaches a size.
+         * @return the tick, or PRICE_LADDER_NO_TICK, and the total size of that side up to the tick.
+         */
+        pair<long long, double> overflowReach(long long tick, double size) const {
+            cacheOverflowSums(tick);
+            auto first = tick < base ? overflow_sums.begin() : lower_bound(overflow_sums.begin(), overflow_sums.end(), base, [](const pair<long long, double>& entry, long long key) {return entry.first < key;});
+            auto last = tick < base ? lower_bound(first, overflow_sums.end(), base, [](const pair<long long, double>& entry, long long key) {return entry.first < key;}) : overflow_sums.end();
+            auto it = lower_bound(first, last, size, [](const pair<long long, double>& entry, double key) {return entry.second < key;});
+            if (it != last) {
+                return {it->first, it->second};
+            }
+            return {PRICE_LADDER_NO_TICK, first != last ? prev(last)->second : 0.0};
+        }
+
+        /**
+         * Helper function extending the cached running totals of the overflow map to the ticks at or below a tick.
+         */
+        void cacheOverflowSums(long long tick) const {
+            auto it = overflow_sums.empty() ? overflow.begin() : overflow.upper_bound(overflow_sums.back().first);
+            for (; it != overflow.end() && it->first <= tick; ++it) {
+                bool restart = overflow_sums.empty() || (overflow_sums.back().first < base) != (it->first < base);
+                overflow_sums.emplace_back(it->first, (restart ? 0.0 : overflow_sums.back().second) + it->second);
+            }
+        }
+
+        /**
+         * Helper function dropping the cached running totals of the overflow map from a tick on, before the size there
+         * changes.
+         */
+        void dropOverflowSums(long long tick) {
+            auto it = lower_bound(overflow_sums.begin(), overflow_sums.end(), tick, [](const pair<long long, double>& entry, long long key) {return entry.first < key;});
+            overflow_sums.erase(it, overflow_sums.end());
+        }
+
+        /**
+         * Helper function moving the window and rebuilding the tree from the exact sizes in O(window).
+         */
+        void rebuild(long long new_base, size_t new_capacity) {
+            if (new_base != base || new_capacity != capacity) {
+                for (size_t index = 0; index < values.size(); ++index) {
+                    if (values[index] != 0.0) {
+                        overflow[base + static_cast<long long>(index)] = values[index];
+                    }
+                }
+
+                base = new_base;
+                capacity = new_capacity;
+                values.assign(capacity, 0.0);
+
+                auto first = overflow.lower_bound(base);
+                auto last = overflow.lower_bound(base + static_cast<long long>(capacity));
+                for (auto it = first; it != last; ++it) {
+                    values[it->first - base] = it->second;
+                }
+                overflow.erase(first, last);
+                overflow_sums.clear();
+            }
+
+            tree.assign(capacity + 1, 0.0);
+            counts.assign(capacity + 1, 0);
+            total = 0.0;
+            below_total = 0.0;
+            window_count = 0;
+            for (const auto& [tick, size] : overflow) {
+                total += size;
+                below_total += tick < base ? size : 0.0;
+            }
+            for (size_t i = 1; i <= capacity; ++i) {
+                tree[i] += values[i - 1];
+                counts[i] += values[i - 1] != 0.0;
+                window_count += values[i - 1] != 0.0;
+                total += values[i - 1];
+                size_t parent = i + (i & (~i + 1));
+                if (parent <= capacity) {
+                    tree[parent] += tree[i];
+                    counts[parent] += counts[i];
+                }
+            }
+            num_updates = 0;
+        }
+
+        size_t max_ticks;                   /*< Maximum number of ticks in the window */
+        long long base = 0;                 /*< Tick of the first slot */
+        size_t capacity = 0;                /*< Number of slots; 0 until the first size is set */
+        vector<double> values;              /*< Size of each tick in the window */
+        vector<double> tree;                /*< Fenwick tree over values, 1-based */
+        vector<int> counts;                 /*< Fenwick tree over the number of non-zero values, 1-based */
+        map<long long, double> overflow;    /*< Non-zero sizes outside the window */
+        double total = 0.0;                 /*< Total size */
+        double below_total = 0.0;           /*< Total size in the overflow map below the window */
+        size_t window_count = 0;            /*< Number of ticks in the window holding a size */
+        mutable vector<pair<long long, double>> overflow_sums;  /*< Overflow ticks in order, up to the first one changed since, with the running total of their side of the window */
+        size_t num_updates = 0;             /*< Updates since the tree was last rebuilt */
+};
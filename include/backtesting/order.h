@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -13,6 +15,11 @@
 
 using namespace std;
 
+/**
+ * Book node of an order that is not resting in an order book.
+ */
+constexpr uint32_t NO_BOOK_NODE = numeric_limits<uint32_t>::max();
+
 /**
  * Abstract class for orders.
  * @todo Make sure the exchange's market type support certain order type
@@ -24,7 +31,7 @@ class Order {
         /**
          * Constructor to create an order.
          */
-        Order(std::shared_ptr<Security> security_, MarketType market_type_, std::shared_ptr<TimeType> timestamp_, string type_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_ ,double price_, std::shared_ptr<Exchange> exchange_): 
+        Order(std::shared_ptr<Security> security_, MarketType market_type_, long long timestamp_, string type_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_ ,double price_, std::shared_ptr<Exchange> exchange_): 
                 security(security_), market_type(market_type_), timestamp(timestamp_), type(type_), side(side_), base_currency_size(base_currency_size_), quote_currency_size(quote_currency_size_), leverage(leverage_), margin_type(margintype_), price(price_), exchange(exchange_) {
                     id = ++next_id; // Assign a unique order id
                     
@@ -214,10 +221,10 @@ class Order {
 
         /**
          * Check if an exchange received the order and if so, change order status to working
-         * @param current_timestamp Current timestamp in format 'yyyy-MM-dd HH:mm:ss.fffffffff'
+         * @param current_timestamp Current timestamp in nanoseconds since epoch
          */
-        void checkOrderReceived(TimeType& current_timestamp) {
-            long long time_difference = current_timestamp.toNanosecondsSinceEpoch() - timestamp->toNanosecondsSinceEpoch();
+        void checkOrderReceived(long long current_timestamp) {
+            long long time_difference = current_timestamp - timestamp;
 
             if (time_difference >= exchange->getSendingLatency()) {
                 state = OrderState::Working;
@@ -239,15 +246,25 @@ class Order {
          */
         std::shared_ptr<Security> getSecurity() {return security;}
 
+        /**
+         * Getter for the node of the order in its order book's queue, or NO_BOOK_NODE if it is not resting there.
+         */
+        uint32_t getBookNode() const {return book_node;}
+
+        /**
+         * Setter for the node of the order in its order book's queue; only the order book sets it.
+         */
+        void setBookNode(uint32_t node) {book_node = node;}
+
         /**
          * Getter for market type.
          */
         MarketType& getMarketType() {return market_type;}
 
         /**
-         * Getter for timestamp.
+         * Getter for timestamp in nanoseconds since epoch.
          */
-        TimeType& getTimestamp() const {return *timestamp;}
+        long long getTimestamp() const {return timestamp;}
 
         /**
          * Getter for order type.
@@ -322,7 +339,7 @@ class Order {
         int id;     /*< Unique ID */
         MarketType market_type;   /*< Market type */
         std::shared_ptr<Security> security;        /*< Security */
-        std::shared_ptr<TimeType> timestamp;       /*< UTC timestamp */
+        long long timestamp;            /*< UTC timestamp in nanoseconds since epoch */
         string type;              /*< Order type */
         const int side;                 /*< -1 for SELL, 1 for BUY */
         double base_currency_size;      /*< Quantity of the order in base currency before leverage (For BTC/USDT, order size in BTC) */
@@ -336,9 +353,10 @@ class Order {
         std::shared_ptr<Exchange> exchange;        /*< Target exchange for an order */
         OrderState state = OrderState::SentToExchange;         /*< State of the order */
         vector<int> child_trade_id;     /*< Vector of trade ids executed from this order */
+        uint32_t book_node = NO_BOOK_NODE;  /*< Node of the order in its order book's queue */
 
     private:
-        static int next_id; /*< Static member to track the next available ID */ 
+        static inline int next_id = 0; /*< Static member to track the next available ID */ 
 };
 
 
@@ -350,7 +368,7 @@ class Limit : public Order {
     /**
      * Constructor to create an order.
      */
-    Limit(std::shared_ptr<Security> security_, MarketType market_type_ , std::shared_ptr<TimeType> timestamp_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_, double price_, std::shared_ptr<Exchange> exchange_): 
+    Limit(std::shared_ptr<Security> security_, MarketType market_type_ , long long timestamp_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_, double price_, std::shared_ptr<Exchange> exchange_): 
             Order(security_, market_type_, timestamp_, "LIMIT", side_, base_currency_size_, quote_currency_size_, leverage_, margintype_, price_, exchange_) {}
 
     /**
@@ -427,7 +445,7 @@ class Market : public Order {
     /**
      * Constructor to create an order.
      */
-    Market(std::shared_ptr<Security> security_, MarketType market_type_, std::shared_ptr<TimeType> timestamp_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_, double current_price_, std::shared_ptr<Exchange> exchange_): 
+    Market(std::shared_ptr<Security> security_, MarketType market_type_, long long timestamp_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_, double current_price_, std::shared_ptr<Exchange> exchange_): 
             Order(security_, market_type_, timestamp_, "MARKET", side_, base_currency_size_, quote_currency_size_, leverage_, margintype_, current_price_, exchange_) {}
 
     /**
@@ -454,7 +472,7 @@ class Stop : public Order {
     /**
      * Constructor to create an order.
      */
-    Stop(std::shared_ptr<Security> security_, MarketType market_type_, std::shared_ptr<TimeType> timestamp_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_, double trigger_price_, std::shared_ptr<Exchange> exchange_): 
+    Stop(std::shared_ptr<Security> security_, MarketType market_type_, long long timestamp_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_, double trigger_price_, std::shared_ptr<Exchange> exchange_): 
             Order(security_, market_type_, timestamp_, "STOP", side_, base_currency_size_, quote_currency_size_, leverage_, margintype_, trigger_price_, exchange_) {
                 triggered = false, trigger_price = trigger_price_;
             }
@@ -559,7 +577,7 @@ class StopLimit : public Order {
     /**
      * Constructor to create an order.
      */
-    StopLimit(std::shared_ptr<Security> security_, MarketType market_type_, std::shared_ptr<TimeType> timestamp_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_, double price_, double trigger_price_, std::shared_ptr<Exchange> exchange_): 
+    StopLimit(std::shared_ptr<Security> security_, MarketType market_type_, long long timestamp_, int side_, double base_currency_size_, double quote_currency_size_, unsigned leverage_, MarginType margintype_, double price_, double trigger_price_, std::shared_ptr<Exchange> exchange_): 
             Order(security_, market_type_, timestamp_, "STOPLIMIT", side_, base_currency_size_, quote_currency_size_, leverage_, margintype_, price_, exchange_) {
                 triggered = false, trigger_price = trigger_price_;
             }
@@ -668,6 +686,4 @@ class StopLimit : public Order {
 private:
     bool triggered;         /*< Whether the trigger price has been hit */
     double trigger_price;   /*< Trigger price for the stop order */
-};
-
-int Order::next_id = 0;
\ No newline at end of file
+};
\ No newline at end of file
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "./order.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Market size below which an order queue holds none; anything smaller is rounding left over from subtracting sizes.
+ */
+constexpr double ORDER_QUEUE_MIN_SIZE = 1e-12;
+
+/**
+ * Entry of an order queue: one of our orders resting at a price level, and the size of other market participants ahead
+ * of it.
+ */
+struct OrderNode {
+    double size = 0.0;                  /*< Order size */
+    std::shared_ptr<Order> order;       /*< Our order */
+    long long tick = 0;                 /*< Tick of the price level holding the entry */
+    double ahead = 0.0;                 /*< Size of other market participants ahead of the order */
+    uint32_t prev = NO_BOOK_NODE;       /*< Previous entry of the queue, or next free node while in the free list */
+    uint32_t next = NO_BOOK_NODE;       /*< Next entry of the queue */
+};
+
+
+/**
+ * Pool of order queue nodes shared by the price levels of one order book.
+ * Released nodes are kept in a free list and handed out again, so once the pool has grown to the largest number of
+ * our orders the book held, queue operations do not allocate. Nodes are referred to by index, which stays valid when
+ * the pool grows.
+ */
+class OrderNodePool {
+    public:
+        /**
+         * Takes a node from the free list, or adds one.
+         * @return index of the node.
+         */
+        uint32_t allocate(double size, const std::shared_ptr<Order>& order, long long tick, double ahead) {
+            uint32_t node;
+            if (free_head != NO_BOOK_NODE) {
+                node = free_head;
+                free_head = nodes[node].prev;
+            } else {
+                node = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+
+            nodes[node] = OrderNode{size, order, tick, ahead, NO_BOOK_NODE, NO_BOOK_NODE};
+            ++num_used;
+            return node;
+        }
+
+        /**
+         * Returns a node to the free list.
+         */
+        void release(uint32_t node) {
+            nodes[node].order = nullptr;
+            nodes[node].prev = free_head;
+            free_head = node;
+            --num_used;
+        }
+
+        OrderNode& operator[](uint32_t node) {return nodes[node];}
+        const OrderNode& operator[](uint32_t node) const {return nodes[node];}
+
+        /**
+         * Getter for number of nodes in use.
+         */
+        size_t size() const {return num_used;}
+
+        /**
+         * Getter for number of nodes the pool holds, in use or free.
+         */
+        size_t getCapacity() const {return nodes.size();}
+
+    private:
+        vector<OrderNode> nodes;                /*< Nodes, in use or free */
+        uint32_t free_head = NO_BOOK_NODE;      /*< First node of the free list */
+        size_t num_used = 0;                    /*< Number of nodes in use */
+};
+
+
+/**
+ * Queue of the orders resting at a price level.
+ * Other market participants are only kept as an aggregate size; our orders form a small overlay, an intrusive
+ * doubly-linked list of pool nodes in queue order, each recording the market size ahead of it. Market updates therefore
+ * only touch our orders when they change the size ahead of them. Our orders hold the index of their node
+ * (Order::getBookNode), so they are reduced or removed without searching the queue.
+ * A default constructed queue is empty; a queue must be cleared before it is dropped so its nodes return to the pool.
+ */
+struct OrderQueue {
+    double market_size = 0.0;           /*< Total size of the orders of other market participants */
+    double our_size = 0.0;              /*< Total size of our orders */
+    uint32_t head = NO_BOOK_NODE;       /*< First of our orders */
+    uint32_t tail = NO_BOOK_NODE;       /*< Last of our orders */
+    int num_our_orders = 0;             /*< Number of our orders */
+
+    bool empty() const {return market_size == 0.0 && head == NO_BOOK_NODE;}
+
+    /**
+     * Whether an order is the last entry of the queue, with no market size behind it.
+     */
+    bool endsWith(const OrderNodePool& pool, const std::shared_ptr<Order>& order) const {
+        return tail != NO_BOOK_NODE && pool[tail].order == order && pool[tail].ahead == market_size;
+    }
+
+    /**
+     * Adds size of other market participants at the back of the queue.
+     */
+    void addMarket(double size) {
+        market_size += size;
+    }
+
+    /**
+     * Removes size of other market participants from the back of the queue, as cancels do.
+     * Our orders only move up if the size left is less than the size ahead of them.
+     */
+    void reduceMarket(OrderNodePool& pool, double size) {
+        market_size = market_size - size >= ORDER_QUEUE_MIN_SIZE ? market_size - size : 0.0;
+        for (uint32_t node = tail; node != NO_BOOK_NODE && pool[node].ahead > market_size; node = pool[node].prev) {
+            pool[node].ahead = market_size;
+        }
+    }
+
+    /**
+     * Removes size of other market participants from the front of the queue, as trades do; our orders move up by it.
+     * @param size size to remove; must not exceed the size ahead of the first of our orders that is left.
+     */
+    void fillMarket(OrderNodePool& pool, double size) {
+        market_size = market_size - size >= ORDER_QUEUE_MIN_SIZE ? market_size - size : 0.0;
+        for (uint32_t node = head; node != NO_BOOK_NODE; node = pool[node].next) {
+            pool[node].ahead = size < pool[node].ahead ? pool[node].ahead - size : 0.0;
+        }
+    }
+
+    /**
+     * Appends one of our orders behind the market size. If the last entry is the same order, its size is replaced in
+     * place instead, as it already sits where the order would go.
+     */
+    void push(OrderNodePool& pool, double size, const std::shared_ptr<Order>& order, long long tick) {
+        if (endsWith(pool, order)) {
+            our_size -= pool[tail].size;
+            pool[tail].size = size;
+        } else {
+            uint32_t node = pool.allocate(size, order, tick, market_size);
+            pool[node].prev = tail;
+            (tail != NO_BOOK_NODE ? pool[tail].next : head) = node;
+            tail = node;
+
+            order->setBookNode(node);
+            ++num_our_orders;
+        }
+        our_size += size;
+    }
+
+    /**
+     * Reduces the size of one of our orders, removing it once nothing is left.
+     */
+    void reduce(OrderNodePool& pool, uint32_t node, double size) {
+        pool[node].size -= size;
+        our_size -= size;
+        if (pool[node].size == 0.0) {
+            erase(pool, node);
+        }
+    }
+
+    /**
+     * Sets the size of one of our orders in place, keeping its position in the queue; a size of zero removes it.
+     */
+    void resize(OrderNodePool& pool, uint32_t node, double size) {
+        our_size += size - pool[node].size;
+        pool[node].size = size;
+        if (size == 0.0) {
+            erase(pool, node);
+        }
+    }
+
+    /**
+     * Removes one of our orders and returns its node to the pool.
+     */
+    void erase(OrderNodePool& pool, uint32_t node) {
+        OrderNode& entry = pool[node];
+        (entry.prev != NO_BOOK_NODE ? pool[entry.prev].next : head) = entry.next;
+        (entry.next != NO_BOOK_NODE ? pool[entry.next].prev : tail) = entry.prev;
+
+        entry.order->setBookNode(NO_BOOK_NODE);
+        our_size -= entry.size;
+        if (--num_our_orders == 0) {
+            our_size = 0.0;     // Drop rounding left over from the running total
+        }
+        pool.release(node);
+    }
+
+    /**
+     * Removes every entry and returns the nodes to the pool.
+     */
+    void clear(OrderNodePool& pool) {
+        while (head != NO_BOOK_NODE) {
+            erase(pool, head);
+        }
+        market_size = 0.0;
+    }
+};
@@ -0,0 +1,548 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Tick returned by PriceLadder searches that find no level.
+ */
+constexpr long long PRICE_LADDER_NO_TICK = numeric_limits<long long>::min();
+
+/**
+ * Number of ticks the window of a PriceLadder covers when its first level is added.
+ */
+constexpr size_t PRICE_LADDER_INITIAL_TICKS = 1024;
+
+/**
+ * Default maximum number of ticks the window of a PriceLadder grows to; levels past it are kept in the overflow map.
+ */
+constexpr size_t PRICE_LADDER_MAX_TICKS = 1 << 16;
+
+/**
+ * Price levels indexed by integer tick (price / tick size).
+ * Levels near the market live in a contiguous window of slots, one per tick, with a bitmap of occupied slots
+ * (and a summary bitmap of non-empty words) so the next level above or below a tick is found with a few bit scans.
+ * The window grows to cover the occupied ticks up to max_ticks; levels added outside it after that go to a sorted
+ * overflow map without moving the window, so far-away prices never blow up or drag the window. The window only moves
+ * when follow is given a tick (the best price, for an order book side) that has drifted out of the middle half of the
+ * window, or when a level is added while the window holds none. Slots are indexed by tick modulo the window size, so
+ * moving the window only moves the levels that cross its edges. Nodes of levels leaving the overflow map are kept in a
+ * free list and reused, so once the map has grown to the largest number of levels it held, moving levels in and out of
+ * it does not allocate.
+ * @tparam Level level type; a default constructed Level is an empty level.
+ */
+template <typename Level>
+class PriceLadder {
+    public:
+        /**
+         * Constructor
+         * @param tick_size_ minimum price increment.
+         * @param max_ticks_ maximum number of ticks in the window; rounded up to a power of two.
+         */
+        explicit PriceLadder(double tick_size_, size_t max_ticks_ = PRICE_LADDER_MAX_TICKS): tick_size(tick_size_) {
+            if (!(tick_size > 0) || !isfinite(tick_size)) {
+                throw invalid_argument("Tick size should be positive");
+                return;
+            }
+
+            // Decimal tick sizes (0.01, 1e-8, ...) convert back by dividing by an exact integer, so a parsed price
+            // round-trips to the same double
+            double reciprocal = round(1.0 / tick_size);
+            ticks_per_unit = (reciprocal >= 1 && fabs(reciprocal * tick_size - 1) < 1e-9) ? reciprocal : 0;
+
+            max_ticks = WORD_BITS;
+            while (max_ticks < max_ticks_) {
+                max_ticks <<= 1;
+            }
+        }
+
+        /**
+         * Converts a price to the nearest tick.
+         */
+        long long toTick(double price) const {
+            return ticks_per_unit != 0 ? llround(price * ticks_per_unit) : llround(price / tick_size);
+        }
+
+        /**
+         * Converts a tick to its price.
+         */
+        double toPrice(long long tick) const {
+            return ticks_per_unit != 0 ? tick / ticks_per_unit : tick * tick_size;
+        }
+
+        /**
+         * Finds the level at a tick.
+         * @return pointer to the level, or nullptr if there is none.
+         */
+        Level* find(long long tick) {
+            if (inWindow(tick)) {
+                size_t slot = slotOf(tick);
+                return testBit(slot) ? &slots[slot] : nullptr;
+            }
+            auto it = overflow.find(tick);
+            return it != overflow.end() ? &it->second : nullptr;
+        }
+
+        /**
+         * Finds the level at a tick.
+         * @return pointer to the level, or nullptr if there is none.
+         */
+        const Level* find(long long tick) const {
+            return const_cast<PriceLadder*>(this)->find(tick);
+        }
+
+        /**
+         * Finds the level at a tick, adding an empty level if there is none.
+         * @param created set to whether the level was added.
+         */
+        Level& insert(long long tick, bool& created) {
+            Level* level = find(tick);
+            created = level == nullptr;
+            if (level != nullptr) {
+                return *level;
+            }
+
+            ++num_levels;
+            if (!inWindow(tick)) {
+                placeWindow(tick);
+            }
+            if (inWindow(tick)) {
+                size_t slot = slotOf(tick);
+                setBit(slot);
+                ++window_levels;
+                return slots[slot];
+            }
+            return emplaceOverflow(tick, Level());
+        }
+
+        /**
+         * Finds the level at a tick, adding an empty level if there is none.
+         */
+        Level& insert(long long tick) {
+            bool created;
+            return insert(tick, created);
+        }
+
+        /**
+         * Removes the level at a tick.
+         * @return whether there was a level.
+         */
+        bool erase(long long tick) {
+            if (inWindow(tick)) {
+                size_t slot = slotOf(tick);
+                if (!testBit(slot)) {
+                    return false;
+                }
+                clearBit(slot);
+                slots[slot] = Level();
+                --window_levels;
+            } else {
+                auto it = overflow.find(tick);
+                if (it == overflow.end()) {
+                    return false;
+                }
+                eraseOverflow(it);
+            }
+
+            --num_levels;
+            return true;
+        }
+
+        /**
+         * Keeps a tick, typically the best price, in the middle half of the window. Once it drifts out of that band the
+         * window is recentered on it, moving only the levels that cross the window edges; within the band nothing moves.
+         */
+        void follow(long long tick) {
+            long long quarter = static_cast<long long>(capacity / 4);
+            if (capacity != 0 && (tick < base + quarter || tick >= base + 3 * quarter)) {
+                shiftWindow(tick - 2 * quarter);
+            }
+        }
+
+        /**
+         * Finds the closest level above a tick.
+         * @return tick of the level, or PRICE_LADDER_NO_TICK.
+         */
+        long long nextAbove(long long tick) const {
+            long long result = PRICE_LADDER_NO_TICK;
+            auto it = overflow.upper_bound(tick);
+            if (it != overflow.end()) {
+                result = it->first;
+            }
+
+            if (window_levels != 0 && tick < base + static_cast<long long>(capacity) - 1) {
+                size_t index = scanUp(tick < base ? 0 : static_cast<size_t>(tick - base) + 1);
+                if (index < capacity && (result == PRICE_LADDER_NO_TICK || base + static_cast<long long>(index) < result)) {
+                    result = base + index;
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Finds the closest level below a tick.
+         * @return tick of the level, or PRICE_LADDER_NO_TICK.
+         */
+        long long nextBelow(long long tick) const {
+            long long result = PRICE_LADDER_NO_TICK;
+            auto it = overflow.lower_bound(tick);
+            if (it != overflow.begin()) {
+                result = prev(it)->first;
+            }
+
+            if (window_levels != 0 && tick > base) {
+                size_t from = tick - base - 1 < static_cast<long long>(capacity) ? static_cast<size_t>(tick - base - 1) : capacity - 1;
+                size_t index = scanDown(from);
+                if (index != NO_INDEX && base + static_cast<long long>(index) > result) {
+                    result = base + index;
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Getter for the tick of the lowest level, or PRICE_LADDER_NO_TICK if there are no levels.
+         */
+        long long lowest() const {
+            long long result = overflow.empty() ? PRICE_LADDER_NO_TICK : overflow.begin()->first;
+            if (window_levels != 0 && (result == PRICE_LADDER_NO_TICK || result > base)) {
+                result = base + scanUp(0);
+            }
+            return result;
+        }
+
+        /**
+         * Getter for the tick of the highest level, or PRICE_LADDER_NO_TICK if there are no levels.
+         */
+        long long highest() const {
+            long long result = overflow.empty() ? PRICE_LADDER_NO_TICK : overflow.rbegin()->first;
+            if (window_levels != 0 && result < base) {
+                result = base + scanDown(capacity - 1);
+            }
+            return result;
+        }
+
+        /**
+         * Getter for number of levels.
+         */
+        size_t size() const {return num_levels;}
+
+        /**
+         * Getter for number of levels outside the window.
+         */
+        size_t getNumOverflowLevels() const {return overflow.size();}
+
+        /**
+         * Getter for number of overflow map nodes kept for reuse.
+         */
+        size_t getNumSpareNodes() const {return spare_nodes.size();}
+
+        /**
+         * Getter for number of ticks the window covers.
+         */
+        size_t getCapacity() const {return capacity;}
+
+        /**
+         * Getter for the first tick the window covers.
+         */
+        long long getBase() const {return base;}
+
+        /**
+         * Getter for the tick size.
+         */
+        double getTickSize() const {return tick_size;}
+
+    private:
+        static constexpr size_t WORD_BITS = 64;
+        static constexpr size_t NO_INDEX = numeric_limits<size_t>::max();
+
+        /**
+         * Helper function checking whether a tick is inside the window.
+         */
+        bool inWindow(long long tick) const {
+            return capacity != 0 && tick >= base && tick - base < static_cast<long long>(capacity);
+        }
+
+        /**
+         * Helper function giving the slot of a tick inside the window.
+         */
+        size_t slotOf(long long tick) const {return static_cast<size_t>(tick) & (capacity - 1);}
+
+        bool testBit(size_t index) const {return (bits[index / WORD_BITS] >> (index % WORD_BITS)) & 1;}
+
+        void setBit(size_t index) {
+            bits[index / WORD_BITS] |= 1ULL << (index % WORD_BITS);
+            summary[index / WORD_BITS / WORD_BITS] |= 1ULL << (index / WORD_BITS % WORD_BITS);
+        }
+
+        void clearBit(size_t index) {
+            size_t word = index / WORD_BITS;
+            bits[word] &= ~(1ULL << (index % WORD_BITS));
+            if (bits[word] == 0) {
+                summary[word / WORD_BITS] &= ~(1ULL << (word % WORD_BITS));
+            }
+        }
+
+        /**
+         * Helper function finding the first level at or after an offset from the start of the window.
+         * @return offset of the level, or capacity if there is none.
+         */
+        size_t scanUp(size_t from) const {
+            if (from >= capacity) {
+                return capacity;
+            }
+
+            // Slots run from the slot of base to the end, then wrap around to the slot before it
+            size_t start = slotOf(base);
+            size_t slot = start + from;
+            if (slot < capacity) {
+                size_t found = scanUpSlots(slot);
+                if (found < capacity) {
+                    return found - start;
+                }
+                slot = 0;
+            } else {
+                slot -= capacity;
+            }
+            size_t found = scanUpSlots(slot);
+            return found < start ? found + capacity - start : capacity;
+        }
+
+        /**
+         * Helper function finding the last level at or before an offset from the start of the window (which must be below
+         * capacity).
+         * @return offset of the level, or NO_INDEX if there is none.
+         */
+        size_t scanDown(size_t from) const {
+            size_t start = slotOf(base);
+            size_t slot = start + from;
+            if (slot >= capacity) {
+                size_t found = scanDownSlots(slot - capacity);
+                if (found != NO_INDEX) {
+                    return found + capacity - start;
+                }
+                slot = capacity - 1;
+            }
+            size_t found = scanDownSlots(slot);
+            return found != NO_INDEX && found >= start ? found - start : NO_INDEX;
+        }
+
+        /**
+         * Helper function finding the first occupied slot at or after a slot.
+         * @return the slot, or capacity if there is none.
+         */
+        size_t scanUpSlots(size_t from) const {
+            if (from >= capacity) {
+                return capacity;
+            }
+
+            size_t word = from / WORD_BITS;
+            uint64_t mask = bits[word] & (~0ULL << (from % WORD_BITS));
+            if (mask != 0) {
+                return word * WORD_BITS + __builtin_ctzll(mask);
+            }
+
+            // Skip empty words through the summary
+            size_t next_word = word + 1;
+            if (next_word == bits.size()) {
+                return capacity;
+            }
+            size_t summary_word = next_word / WORD_BITS;
+            uint64_t summary_mask = summary[summary_word] & (~0ULL << (next_word % WORD_BITS));
+            while (summary_mask == 0) {
+                if (++summary_word == summary.size()) {
+                    return capacity;
+                }
+                summary_mask = summary[summary_word];
+            }
+            word = summary_word * WORD_BITS + __builtin_ctzll(summary_mask);
+            return word * WORD_BITS + __builtin_ctzll(bits[word]);
+        }
+
+        /**
+         * Helper function finding the last occupied slot at or before a slot (which must be below capacity).
+         * @return the slot, or NO_INDEX if there is none.
+         */
+        size_t scanDownSlots(size_t from) const {
+            size_t word = from / WORD_BITS;
+            uint64_t mask = bits[word] & (~0ULL >> (WORD_BITS - 1 - from % WORD_BITS));
+            if (mask != 0) {
+                return word * WORD_BITS + WORD_BITS - 1 - __builtin_clzll(mask);
+            }
+
+            // Skip empty words through the summary
+            if (word == 0) {
+                return NO_INDEX;
+            }
+            size_t prev_word = word - 1;
+            size_t summary_word = prev_word / WORD_BITS;
+            uint64_t summary_mask = summary[summary_word] & (~0ULL >> (WORD_BITS - 1 - prev_word % WORD_BITS));
+            while (summary_mask == 0) {
+                if (summary_word-- == 0) {
+                    return NO_INDEX;
+                }
+                summary_mask = summary[summary_word];
+            }
+            word = summary_word * WORD_BITS + WORD_BITS - 1 - __builtin_clzll(summary_mask);
+            return word * WORD_BITS + WORD_BITS - 1 - __builtin_clzll(bits[word]);
+        }
+
+        /**
+         * Helper function placing the window for a tick about to be added outside it.
+         * The first level, or a level added while the window holds none, centers the window on its tick. Otherwise the
+         * window grows to cover its levels and the tick if they span at most max_ticks, and else stays where it is, the
+         * tick going to the overflow map.
+         */
+        void placeWindow(long long tick) {
+            if (capacity == 0) {
+                size_t new_capacity = min(PRICE_LADDER_INITIAL_TICKS, max_ticks);
+                rebuild(tick - static_cast<long long>(new_capacity / 2), new_capacity);
+                return;
+            }
+            if (window_levels == 0) {
+                shiftWindow(tick - static_cast<long long>(capacity / 2));
+                return;
+            }
+            if (capacity == max_ticks) {
+                return;
+            }
+
+            long long low = min(tick, base + static_cast<long long>(scanUp(0)));
+            long long high = max(tick, base + static_cast<long long>(scanDown(capacity - 1)));
+            unsigned long long span = static_cast<unsigned long long>(high - low) + 1;
+            if (span > max_ticks) {
+                return;
+            }
+
+            // Leave room for the price to keep drifting in the same direction
+            size_t new_capacity = capacity;
+            while (new_capacity < 2 * span && new_capacity < max_ticks) {
+                new_capacity <<= 1;
+            }
+            if (new_capacity > capacity) {
+                rebuild(low - static_cast<long long>((new_capacity - span) / 2), new_capacity);
+            }
+        }
+
+        /**
+         * Helper function moving the window without resizing it. Slots keep their ticks modulo capacity, so only the
+         * levels leaving the window move to the overflow map and only those entering it move out of the map.
+         */
+        void shiftWindow(long long new_base) {
+            long long shift = new_base - base;
+            long long ticks = static_cast<long long>(capacity);
+            size_t from = shift >= 0 ? 0 : (-shift < ticks ? static_cast<size_t>(ticks + shift) : 0);
+            size_t to = shift >= 0 ? (shift < ticks ? static_cast<size_t>(shift) : capacity) : capacity;
+            for (size_t index = scanUp(from); index < to; index = scanUp(index + 1)) {
+                long long tick = base + static_cast<long long>(index);
+                size_t slot = slotOf(tick);
+                emplaceOverflow(tick, std::move(slots[slot]));
+                slots[slot] = Level();
+                clearBit(slot);
+                --window_levels;
+            }
+
+            base = new_base;
+            pullOverflow();
+        }
+
+        /**
+         * Helper function resizing the window, moving every level into its new slot or the overflow map.
+         */
+        void rebuild(long long new_base, size_t new_capacity) {
+            vector<Level> old_slots = std::move(slots);
+            vector<uint64_t> old_bits = std::move(bits);
+            long long old_base = base;
+            size_t old_capacity = capacity;
+
+            base = new_base;
+            capacity = new_capacity;
+            slots = vector<Level>(capacity);
+            bits.assign(capacity / WORD_BITS, 0);
+            summary.assign((bits.size() + WORD_BITS - 1) / WORD_BITS, 0);
+            window_levels = 0;
+
+            for (size_t word = 0; word < old_bits.size(); ++word) {
+                for (uint64_t mask = old_bits[word]; mask != 0; mask &= mask - 1) {
+                    size_t slot = word * WORD_BITS + __builtin_ctzll(mask);
+                    long long tick = old_base + static_cast<long long>((slot - static_cast<size_t>(old_base)) & (old_capacity - 1));
+                    moveIn(tick, std::move(old_slots[slot]));
+                }
+            }
+            pullOverflow();
+        }
+
+        /**
+         * Helper function moving the levels of the overflow map that the window covers into their slots.
+         */
+        void pullOverflow() {
+            auto first = overflow.lower_bound(base);
+            auto last = overflow.lower_bound(base + static_cast<long long>(capacity));
+            while (first != last) {
+                size_t slot = slotOf(first->first);
+                slots[slot] = std::move(first->second);
+                setBit(slot);
+                ++window_levels;
+                eraseOverflow(first++);
+            }
+        }
+
+        /**
+         * Helper function placing a level in the window or, if outside it, in the overflow map.
+         */
+        void moveIn(long long tick, Level&& level) {
+            if (inWindow(tick)) {
+                size_t slot = slotOf(tick);
+                slots[slot] = std::move(level);
+                setBit(slot);
+                ++window_levels;
+            } else {
+                emplaceOverflow(tick, std::move(level));
+            }
+        }
+
+        /**
+         * Helper function adding a level to the overflow map, reusing a spare node if there is one.
+         */
+        Level& emplaceOverflow(long long tick, Level&& level) {
+            if (spare_nodes.empty()) {
+                return overflow.emplace(tick, std::move(level)).first->second;
+            }
+
+            auto node = std::move(spare_nodes.back());
+            spare_nodes.pop_back();
+            node.key() = tick;
+            node.mapped() = std::move(level);
+            return overflow.insert(std::move(node)).position->second;
+        }
+
+        /**
+         * Helper function removing a level from the overflow map and keeping its node for reuse.
+         */
+        void eraseOverflow(typename map<long long, Level>::iterator it) {
+            spare_nodes.push_back(overflow.extract(it));
+            spare_nodes.back().mapped() = Level();
+        }
+
+        double tick_size;                   /*< Minimum price increment */
+        double ticks_per_unit;              /*< 1 / tick_size if it is an integer, otherwise 0 */
+        size_t max_ticks;                   /*< Maximum number of ticks in the window */
+
+        long long base = 0;                 /*< First tick of the window */
+        size_t capacity = 0;                /*< Number of slots; 0 until the first level is added */
+        vector<Level> slots;                /*< Level of each tick in the window, at the tick modulo capacity */
+        vector<uint64_t> bits;              /*< Bit per slot, set if the slot holds a level */
+        vector<uint64_t> summary;           /*< Bit per word of bits, set if the word is non-zero */
+        size_t window_levels = 0;           /*< Number of levels in the window */
+        map<long long, Level> overflow;     /*< Levels outside the window */
+        vector<typename map<long long, Level>::node_type> spare_nodes;  /*< Overflow nodes of erased levels, reused by later levels */
+        size_t num_levels = 0;              /*< Number of levels */
+};
@@ -16,7 +16,7 @@ class Trade {
         /**
          * Constructor to create a trade.
          */
-        Trade(std::shared_ptr<Order> parent_order_, std::shared_ptr<TimeType> timestamp_, int side_, double base_currency_size_, double price_, bool is_maker_): 
+        Trade(std::shared_ptr<Order> parent_order_, long long timestamp_, int side_, double base_currency_size_, double price_, bool is_maker_): 
                 parent_order(parent_order_), timestamp(timestamp_), side(side_), base_currency_size(base_currency_size_), price(price_), is_maker(is_maker_) {
                     id = ++next_id; // Assign a unique order id
 
@@ -44,9 +44,9 @@ class Trade {
         std::shared_ptr<Security> getSecurity() const {return parent_order->getSecurity();}
 
         /**
-         * Getter for timestamp.
+         * Getter for timestamp in nanoseconds since epoch.
          */
-        std::shared_ptr<TimeType> getTimestamp() const {return timestamp;}
+        long long getTimestamp() const {return timestamp;}
 
         /**
          * Getter for side.
@@ -82,7 +82,7 @@ class Trade {
         int id;                     /*< Unique id */
         static int next_id;         /*< Static member to track the next available ID */ 
         std::shared_ptr<Order> parent_order;    /*< Parent order */
-        std::shared_ptr<TimeType> timestamp;    /*< UTC timestamp */
+        long long timestamp;        /*< UTC timestamp in nanoseconds since epoch */
         int side;                   /*< -1 for SELL, 1 for BUY */
         double base_currency_size;  /*< Quantity of the order in base currency */
         double price;               /*< Price at which trade occurred */
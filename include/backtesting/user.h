@@ -3,6 +3,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "../data/exchange.h"
@@ -90,9 +91,9 @@ class User {
      * @param name name of the exchange to find
      * @return pointer to the exchange
      */
-    std::shared_ptr<Exchange> findExchange(const string& name) {
+    std::shared_ptr<Exchange> findExchange(string_view name) {
     // Convert the target name to lowercase for case-insensitive comparison
-    string lowercase_name = name;
+    string lowercase_name(name);
     transform(lowercase_name.begin(), lowercase_name.end(), lowercase_name.begin(), ::tolower);
 
         for (auto&& exchange : exchange_list) {
@@ -0,0 +1,458 @@
+#pragma once
+
+#include <zlib.h>
+#ifdef CRYPTOPULSE_WITH_ZSTD
+#include <zstd.h>
+#endif
+#ifdef CRYPTOPULSE_WITH_LZ4
+#include <lz4frame.h>
+#endif
+
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "./marketdata.h"
+#include "./marketevent.h"
+#include "./tokenizer.h"
+
+using namespace std;
+
+
+/**
+ * Size in bytes of each of the two decompressed blocks handed from the inflate thread to the row decoder.
+ */
+constexpr size_t COMPRESSED_BLOCK_SIZE = 4 << 20;
+
+/**
+ * Enumeration class for compression formats of market data files.
+ */
+enum class Compression {
+    None,
+    Gzip,
+    Zstd,
+    Lz4
+};
+
+/**
+ * Detects the compression format of a file from its magic number.
+ * @param data_path file path for market data input.
+ * @return Compression::None for plain files and files that cannot be read.
+ */
+inline Compression detectCompression(const string& data_path) {
+    unsigned char magic[4] = {0, 0, 0, 0};
+    ifstream file(data_path, ios::binary);
+    file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+
+    if (file.gcount() >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        return Compression::Gzip;
+    }
+    if (file.gcount() == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return Compression::Zstd;
+    }
+    if (file.gcount() == 4 && magic[0] == 0x04 && magic[1] == 0x22 && magic[2] == 0x4d && magic[3] == 0x18) {
+        return Compression::Lz4;
+    }
+    return Compression::None;
+}
+
+
+/**
+ * Abstract class for streaming decompressors.
+ */
+class Decompressor {
+    public:
+        /**
+         * Destructor
+         */
+        virtual ~Decompressor() = default;
+
+        /**
+         * Decompresses the next bytes of the file.
+         * @param output buffer to fill.
+         * @param capacity size of the buffer.
+         * @return number of bytes written, 0 at the end of the file.
+         */
+        virtual size_t read(char* output, size_t capacity) = 0;
+};
+
+/**
+ * Decompressor for gzip files, including files of several concatenated gzip members.
+ */
+class GzipDecompressor : public Decompressor {
+    public:
+        /**
+         * Constructor
+         * @param data_path file path for market data input.
+         */
+        GzipDecompressor(const string& data_path) {
+            file = gzopen(data_path.c_str(), "rb");
+            if (file == nullptr) {
+                throw invalid_argument("Error opening the file");
+                return;
+            }
+            gzbuffer(file, 1 << 20);
+        }
+
+        /**
+         * Destructor
+         */
+        ~GzipDecompressor() override {gzclose(file);}
+
+        GzipDecompressor(const GzipDecompressor&) = delete;
+        GzipDecompressor& operator=(const GzipDecompressor&) = delete;
+
+        size_t read(char* output, size_t capacity) override {
+            int bytes = gzread(file, output, static_cast<unsigned>(min<size_t>(capacity, 1 << 30)));
+
+            // A truncated archive ends without a negative return, so the error state is checked at the end too
+            int error = Z_OK;
+            const char* message = bytes <= 0 ? gzerror(file, &error) : nullptr;
+            if (bytes < 0 || (error != Z_OK && error != Z_STREAM_END)) {
+                throw runtime_error(string("Error decompressing gzip market data: ") + message);
+                return 0;
+            }
+            return static_cast<size_t>(bytes);
+        }
+
+    private:
+        gzFile file;    /*< zlib file handle */
+};
+
+/**
+ * Base for decompressors reading the compressed file through an input buffer.
+ */
+class BufferedDecompressor : public Decompressor {
+    protected:
+        /**
+         * Constructor
+         * @param data_path file path for market data input.
+         */
+        BufferedDecompressor(const string& data_path): file(data_path, ios::binary), input(1 << 20) {
+            if (!file.is_open()) {
+                throw invalid_argument("Error opening the file");
+            }
+        }
+
+        /**
+         * Helper function refilling the input buffer once it is consumed.
+         * @return false if the file is exhausted.
+         */
+        bool refill() {
+            if (input_position < input_size) {
+                return true;
+            }
+            file.read(input.data(), input.size());
+            input_size = static_cast<size_t>(file.gcount());
+            input_position = 0;
+            return input_size > 0;
+        }
+
+        ifstream file;                  /*< Compressed file */
+        vector<char> input;             /*< Compressed bytes read from the file */
+        size_t input_size = 0;          /*< Number of valid bytes in input */
+        size_t input_position = 0;      /*< Next byte of input to decompress */
+};
+
+#ifdef CRYPTOPULSE_WITH_ZSTD
+/**
+ * Decompressor for zstd files (requires -DCRYPTOPULSE_WITH_ZSTD and -lzstd).
+ */
+class ZstdDecompressor : public BufferedDecompressor {
+    public:
+        /**
+         * Constructor
+         * @param data_path file path for market data input.
+         */
+        ZstdDecompressor(const string& data_path): BufferedDecompressor(data_path), stream(ZSTD_createDStream()) {
+            ZSTD_initDStream(stream);
+        }
+
+        /**
+         * Destructor
+         */
+        ~ZstdDecompressor() override {ZSTD_freeDStream(stream);}
+
+        ZstdDecompressor(const ZstdDecompressor&) = delete;
+        ZstdDecompressor& operator=(const ZstdDecompressor&) = delete;
+
+        size_t read(char* output, size_t capacity) override {
+            ZSTD_outBuffer out = {output, capacity, 0};
+            while (out.pos == 0 && refill()) {
+                ZSTD_inBuffer in = {input.data(), input_size, input_position};
+                size_t result = ZSTD_decompressStream(stream, &out, &in);
+                if (ZSTD_isError(result)) {
+                    throw runtime_error(string("Error decompressing zstd market data: ") + ZSTD_getErrorName(result));
+                    return 0;
+                }
+                input_position = in.pos;
+            }
+            return out.pos;
+        }
+
+    private:
+        ZSTD_DStream* stream;   /*< zstd decompression context */
+};
+#endif
+
+#ifdef CRYPTOPULSE_WITH_LZ4
+/**
+ * Decompressor for lz4 frame files (requires -DCRYPTOPULSE_WITH_LZ4 and -llz4).
+ */
+class Lz4Decompressor : public BufferedDecompressor {
+    public:
+        /**
+         * Constructor
+         * @param data_path file path for market data input.
+         */
+        Lz4Decompressor(const string& data_path): BufferedDecompressor(data_path) {
+            if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION))) {
+                throw runtime_error("Error creating lz4 decompression context");
+            }
+        }
+
+        /**
+         * Destructor
+         */
+        ~Lz4Decompressor() override {LZ4F_freeDecompressionContext(context);}
+
+        Lz4Decompressor(const Lz4Decompressor&) = delete;
+        Lz4Decompressor& operator=(const Lz4Decompressor&) = delete;
+
+        size_t read(char* output, size_t capacity) override {
+            size_t written = 0;
+            while (written == 0 && refill()) {
+                size_t output_size = capacity;
+                size_t input_consumed = input_size - input_position;
+                size_t result = LZ4F_decompress(context, output, &output_size, input.data() + input_position, &input_consumed, nullptr);
+                if (LZ4F_isError(result)) {
+                    throw runtime_error(string("Error decompressing lz4 market data: ") + LZ4F_getErrorName(result));
+                    return 0;
+                }
+                input_position += input_consumed;
+                written = output_size;
+            }
+            return written;
+        }
+
+    private:
+        LZ4F_dctx* context = nullptr;   /*< lz4 frame decompression context */
+};
+#endif
+
+/**
+ * Creates the decompressor for a compressed market data file.
+ * @param data_path file path for market data input.
+ * @param compression compression format of the file.
+ */
+inline unique_ptr<Decompressor> makeDecompressor(const string& data_path, Compression compression) {
+    switch (compression) {
+        case Compression::Gzip:
+            return make_unique<GzipDecompressor>(data_path);
+        case Compression::Zstd:
+#ifdef CRYPTOPULSE_WITH_ZSTD
+            return make_unique<ZstdDecompressor>(data_path);
+#else
+            throw runtime_error("zstd support is not compiled in (build with -DCRYPTOPULSE_WITH_ZSTD -lzstd) to read " + data_path);
+#endif
+        case Compression::Lz4:
+#ifdef CRYPTOPULSE_WITH_LZ4
+            return make_unique<Lz4Decompressor>(data_path);
+#else
+            throw runtime_error("lz4 support is not compiled in (build with -DCRYPTOPULSE_WITH_LZ4 -llz4) to read " + data_path);
+#endif
+        default:
+            throw invalid_argument(data_path + " is not compressed");
+    }
+    return nullptr;
+}
+
+
+/**
+ * Event source decoding a compressed market data CSV file without decompressing it to disk.
+ * An inflate thread decompresses the file into two alternating blocks that always end on a line boundary (a partial
+ * last line is carried over to the next block), while the calling thread splits and decodes the rows of the other
+ * block. Errors of the inflate thread are rethrown after the rows decompressed before them.
+ */
+class CompressedCsvEventSource : public EventSource {
+    public:
+        /**
+         * Constructor. Starts the inflate thread.
+         * @param data_path file path for market data input.
+         * @param block_size size of each decompressed block in bytes; grows if a line does not fit.
+         * @param symbols symbol table of the configured instruments, may be null.
+         */
+        CompressedCsvEventSource(const string& data_path, size_t block_size = COMPRESSED_BLOCK_SIZE, shared_ptr<const SymbolTable> symbols = nullptr)
+                : decompressor(makeDecompressor(data_path, detectCompression(data_path))), instruments(std::move(symbols)) {
+            for (Block& block : blocks) {
+                block.data.resize(block_size);
+            }
+            inflater = thread(&CompressedCsvEventSource::inflate, this);
+        }
+
+        /**
+         * Destructor. Stops the inflate thread.
+         */
+        ~CompressedCsvEventSource() override {
+            {
+                lock_guard<mutex> lock(blocks_mutex);
+                stopping = true;
+            }
+            block_released.notify_all();
+            inflater.join();
+        }
+
+        CompressedCsvEventSource(const CompressedCsvEventSource&) = delete;
+        CompressedCsvEventSource& operator=(const CompressedCsvEventSource&) = delete;
+
+        /**
+         * Reads and decodes the next row, waiting for the next block if needed.
+         */
+        bool nextEvent(MarketEvent& event) override {
+            while (true) {
+                if (tokenizer.nextRow(tokens)) {
+                    if (header_skipped) {
+                        break;
+                    }
+                    header_skipped = true;  // Skip first line
+                } else if (!takeNextBlock()) {
+                    return false;
+                }
+            }
+
+            decodeMarketDataRow(tokens, instruments, event);
+            return true;
+        }
+
+        /**
+         * Getter for instruments seen so far.
+         */
+        const InstrumentTable& getInstruments() const override {return instruments;}
+
+    private:
+        /**
+         * Decompressed block, ending on a line boundary.
+         */
+        struct Block {
+            vector<char> data;
+            size_t length = 0;      /*< Number of bytes handed to the decoder */
+            bool ready = false;     /*< Filled and not released by the decoder yet */
+        };
+
+        /**
+         * Helper function releasing the block being decoded and switching to the next one.
+         * @return false if the whole file was decoded.
+         */
+        bool takeNextBlock() {
+            unique_lock<mutex> lock(blocks_mutex);
+            if (decoding) {
+                blocks[current].ready = false;
+                current ^= 1;
+                block_released.notify_all();
+            }
+
+            block_filled.wait(lock, [this]() {return blocks[current].ready || finished;});
+            if (!blocks[current].ready) {
+                if (error) {
+                    rethrow_exception(error);
+                }
+                return false;
+            }
+
+            decoding = true;
+            const char* begin = blocks[current].data.data();
+            tokenizer = CsvTokenizer(begin, begin + blocks[current].length);
+            return true;
+        }
+
+        /**
+         * Body of the inflate thread.
+         */
+        void inflate() {
+            try {
+                size_t carry = 0;       // Bytes of a partial line at the end of the previous block
+                size_t fill = 0;
+                bool end_of_file = false;
+
+                while (!end_of_file) {
+                    {
+                        unique_lock<mutex> lock(blocks_mutex);
+                        block_released.wait(lock, [this, fill]() {return stopping || !blocks[fill].ready;});
+                        if (stopping) {
+                            return;
+                        }
+                    }
+
+                    // The previous block is only read by the decoder, so its partial line can be copied concurrently
+                    Block& block = blocks[fill];
+                    const Block& previous = blocks[fill ^ 1];
+                    if (carry > block.data.size() / 2) {
+                        block.data.resize(2 * carry);
+                    }
+                    memcpy(block.data.data(), previous.data.data() + previous.length, carry);
+
+                    size_t size = carry;
+                    while (true) {
+                        while (size < block.data.size()) {
+                            size_t bytes = decompressor->read(block.data.data() + size, block.data.size() - size);
+                            if (bytes == 0) {
+                                end_of_file = true;
+                                break;
+                            }
+                            size += bytes;
+                        }
+
+                        size_t last_newline = string_view(block.data.data(), size).rfind('\n');
+                        if (end_of_file || last_newline != string_view::npos) {
+                            block.length = end_of_file ? size : last_newline + 1;
+                            break;
+                        }
+                        block.data.resize(2 * block.data.size());   // Line longer than the block
+                    }
+                    carry = size - block.length;
+
+                    {
+                        lock_guard<mutex> lock(blocks_mutex);
+                        block.ready = true;
+                    }
+                    block_filled.notify_all();
+                    fill ^= 1;
+                }
+            } catch (...) {
+                error = current_exception();
+            }
+
+            {
+                lock_guard<mutex> lock(blocks_mutex);
+                finished = true;
+            }
+            block_filled.notify_all();
+        }
+
+        unique_ptr<Decompressor> decompressor;  /*< Decompressor, only used by the inflate thread */
+
+        Block blocks[2];                        /*< Double buffer between the inflate thread and the decoder */
+        bool finished = false;                  /*< Set by the inflate thread after its last block */
+        bool stopping = false;                  /*< Set by the destructor to stop the inflate thread */
+        exception_ptr error;                    /*< Error thrown by the decompressor */
+        mutex blocks_mutex;                     /*< Guards ready of the blocks, finished and stopping */
+        condition_variable block_filled;        /*< Signalled when a block is filled or on finishing */
+        condition_variable block_released;      /*< Signalled when the decoder releases a block or on stop */
+
+        size_t current = 0;                     /*< Block being decoded */
+        bool decoding = false;                  /*< Whether the decoder holds the current block */
+        CsvTokenizer tokenizer{nullptr, nullptr};   /*< Splits the current block into rows */
+        MarketDataReader::Row tokens;           /*< Fields of the current row */
+        bool header_skipped = false;            /*< Whether the first line was skipped */
+        InstrumentTable instruments;            /*< Instruments seen so far */
+
+        thread inflater;                        /*< Inflate thread, started last */
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <glob.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./eventstore.h"
+#include "./marketevent.h"
+
+using namespace std;
+
+
+/**
+ * Event source merging several time-ordered event sources by timestamp.
+ * Each source is read one event at a time and a min-heap keyed by (timestamp, source index) picks the next event,
+ * so memory stays at one event plus the source's own read buffer per input. Events with equal timestamps come
+ * out in the order of the sources. Instrument ids are translated to one table shared by all sources.
+ */
+class MergedEventSource : public EventSource {
+    public:
+        /**
+         * Constructor. Reads the first event of every source.
+         * @param sources_ sources to merge, each ordered by timestamp.
+         */
+        MergedEventSource(vector<unique_ptr<EventSource>> sources_): sources(std::move(sources_)), heads(sources.size()), instrument_ids(sources.size()) {
+            for (size_t i = 0; i < sources.size(); ++i) {
+                if (sources[i]->nextEvent(heads[i])) {
+                    heap.push({heads[i].timestamp, i});
+                }
+            }
+        }
+
+        /**
+         * Reads the earliest pending event of all sources.
+         */
+        bool nextEvent(MarketEvent& event) override {
+            if (heap.empty()) {
+                return false;
+            }
+
+            size_t index = heap.top().second;
+            heap.pop();
+
+            event = heads[index];
+            event.instrument_id = translateInstrument(index, event.instrument_id);
+
+            if (sources[index]->nextEvent(heads[index])) {
+                heap.push({heads[index].timestamp, index});
+            }
+            return true;
+        }
+
+        /**
+         * Getter for instruments seen so far.
+         */
+        const InstrumentTable& getInstruments() const override {return instruments;}
+
+        /**
+         * Seeks every source and reads their first events again. Sources that cannot seek keep their pending event.
+         * @return false if any source cannot seek.
+         */
+        bool seek(long long timestamp) override {
+            vector<bool> pending(sources.size(), false);
+            for (; !heap.empty(); heap.pop()) {
+                pending[heap.top().second] = true;
+            }
+
+            bool all_seeked = true;
+            for (size_t i = 0; i < sources.size(); ++i) {
+                if (sources[i]->seek(timestamp)) {
+                    pending[i] = sources[i]->nextEvent(heads[i]);
+                } else {
+                    all_seeked = false;
+                }
+                if (pending[i]) {
+                    heap.push({heads[i].timestamp, i});
+                }
+            }
+            return all_seeked;
+        }
+
+    private:
+        /**
+         * Helper function mapping an instrument id of a source to the shared table.
+         */
+        uint16_t translateInstrument(size_t index, uint16_t id) {
+            vector<uint16_t>& ids = instrument_ids[index];
+            while (id >= ids.size()) {
+                const Instrument& instrument = sources[index]->getInstruments().at(static_cast<uint16_t>(ids.size()));
+                ids.push_back(instruments.intern(instrument.exchange, instrument.symbol, instrument.market_type));
+            }
+            return ids[id];
+        }
+
+        using HeapEntry = pair<int64_t, size_t>;    /*< Timestamp of the pending event and index of its source */
+
+        vector<unique_ptr<EventSource>> sources;                                    /*< Merged sources */
+        vector<MarketEvent> heads;                                                  /*< Pending event of each source */
+        priority_queue<HeapEntry, vector<HeapEntry>, greater<HeapEntry>> heap;      /*< Sources with a pending event */
+        vector<vector<uint16_t>> instrument_ids;                                    /*< Shared id of each instrument of each source */
+        InstrumentTable instruments;                                                /*< Instruments seen so far */
+};
+
+
+/**
+ * Expands a market data path that may contain wildcards ('*', '?', '[...]') into the matching files, sorted by name.
+ * Paths without wildcards are returned as they are. Event stores and indexes of matched CSV files are left out.
+ * @param pattern file path or glob pattern.
+ */
+inline vector<string> expandMarketDataPaths(const string& pattern) {
+    if (pattern.find_first_of("*?[") == string::npos) {
+        return {pattern};
+    }
+
+    glob_t matches;
+    int result = glob(pattern.c_str(), 0, nullptr, &matches);
+    vector<string> matched;
+    if (result == 0) {
+        matched.assign(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+    }
+    globfree(&matches);
+    sort(matched.begin(), matched.end());
+
+    // Skip event stores and timestamp indexes kept next to matched CSV files
+    auto isSidecar = [&matched](const string& path, const string& extension) {
+        return path.size() > extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0
+                && binary_search(matched.begin(), matched.end(), path.substr(0, path.size() - extension.size()));
+    };
+    vector<string> paths;
+    for (const string& path : matched) {
+        if (!isSidecar(path, EVENT_STORE_EXTENSION) && !isSidecar(path, TIMESTAMP_INDEX_EXTENSION)) {
+            paths.push_back(path);
+        }
+    }
+
+    if (paths.empty()) {
+        throw invalid_argument("No market data files match " + pattern);
+        return paths;
+    }
+    return paths;
+}
+
+/**
+ * Opens several market data files for replay as one stream merged by timestamp.
+ * Every file is opened as by openMarketData, so CSV files are converted to cached event stores individually.
+ * @param data_paths file paths for market data input, each ordered by timestamp.
+ * @param use_cache whether to convert and cache CSV files.
+ * @param cache_directory directory holding cached stores; if empty, stores are placed next to the CSV files.
+ * @param symbols symbol table used to intern instruments while decoding CSV files, may be null.
+ */
+inline unique_ptr<EventSource> openMarketData(const vector<string>& data_paths, bool use_cache = true, const string& cache_directory = "",
+        shared_ptr<const SymbolTable> symbols = nullptr) {
+    if (data_paths.size() == 1) {
+        return openMarketData(data_paths[0], use_cache, cache_directory, symbols);
+    }
+
+    vector<unique_ptr<EventSource>> sources;
+    for (const string& data_path : data_paths) {
+        sources.push_back(openMarketData(data_path, use_cache, cache_directory, symbols));
+    }
+    return make_unique<MergedEventSource>(std::move(sources));
+}
@@ -4,7 +4,8 @@
 #include "./exchange.h"
 #include "./security.h"
 #include "./timetype.h"
-#include "../backtesting/orderbook.h"
+#include "../backtesting/OrderBook.h"
+#include "../backtesting/consolidatedbook.h"
 
 #include <string>
 
@@ -16,14 +17,15 @@ using namespace std;
  */
 class EventMsg {
 public:
-    EventMsg(std::shared_ptr<TimeType> timestamp_, std::shared_ptr<Exchange> exchange_, MarketType market_type_, std::shared_ptr<Security> security_, std::shared_ptr<OrderBook> orderbook_)
-        : timestamp(timestamp_), exchange(exchange_), market_type(market_type_), security(security_), orderbook(orderbook_) {}
+    EventMsg(long long timestamp_, std::shared_ptr<Exchange> exchange_, MarketType market_type_, std::shared_ptr<Security> security_, std::shared_ptr<OrderBook> orderbook_, std::shared_ptr<ConsolidatedBook> consolidated_ = nullptr)
+        : timestamp(timestamp_), exchange(exchange_), market_type(market_type_), security(security_), orderbook(orderbook_), consolidated(consolidated_) {}
 
-    std::shared_ptr<TimeType> timestamp;    /*< timestamp of an event */
+    long long timestamp;                    /*< timestamp of an event in nanoseconds since epoch */
     std::shared_ptr<Exchange> exchange;     /*< exchange an event occurred */
     MarketType market_type;                 /*< Market type (Futures or spot) */
     std::shared_ptr<Security> security;     /*< Instrument an event occurred */
     std::shared_ptr<OrderBook> orderbook;   /*< Orderbook */
+    std::shared_ptr<ConsolidatedBook> consolidated;     /*< Best bid and ask of the security across exchanges, or nullptr */
 };
 
 /**
@@ -31,8 +33,8 @@ class EventMsg {
  */
 class TradeEventMsg : public EventMsg {
 public:
-    TradeEventMsg(std::shared_ptr<TimeType> timestamp_, std::shared_ptr<Exchange> exchange_, MarketType market_type_, std::shared_ptr<Security> security_, std::shared_ptr<OrderBook> orderbook_, double price_, double size_): 
-            EventMsg(timestamp_, exchange_, market_type_, security_, orderbook_), price(price_), size(size_) {}
+    TradeEventMsg(long long timestamp_, std::shared_ptr<Exchange> exchange_, MarketType market_type_, std::shared_ptr<Security> security_, std::shared_ptr<OrderBook> orderbook_, double price_, double size_, std::shared_ptr<ConsolidatedBook> consolidated_ = nullptr): 
+            EventMsg(timestamp_, exchange_, market_type_, security_, orderbook_, consolidated_), price(price_), size(size_) {}
 
     double price;  /*< price at which the trade occurred */
     double size;   /*< size of the trade in base currency */ 
@@ -42,7 +44,7 @@ class TradeEventMsg : public EventMsg {
      */
     friend ostream& operator<<(ostream& os, TradeEventMsg& msg) {
         os << "========== Trade Event ==========" << endl;
-        os << "Timestamp: " << msg.timestamp->toString() << endl;
+        os << "Timestamp: " << formatTimestamp(msg.timestamp) << endl;
         os << "Market: " << msg.market_type << endl;
         os << "Security: " << msg.security << endl;
         os << "Exchange: " << msg.exchange->getName() << endl;
@@ -59,8 +61,8 @@ class TradeEventMsg : public EventMsg {
  */ 
 class QuoteEventMsg : public EventMsg {
 public:
-    QuoteEventMsg(std::shared_ptr<TimeType> timestamp_, std::shared_ptr<Exchange> exchange_, MarketType market_type_, std::shared_ptr<Security> security_, std::shared_ptr<OrderBook> orderbook_, double bid_price_, double bid_size_, double ask_price_, double ask_size_): 
-        EventMsg(timestamp_, exchange_, market_type_, security_, orderbook_), bid_price(bid_price_), bid_size(bid_size_), ask_price(ask_price_), ask_size(ask_size_) {}
+    QuoteEventMsg(long long timestamp_, std::shared_ptr<Exchange> exchange_, MarketType market_type_, std::shared_ptr<Security> security_, std::shared_ptr<OrderBook> orderbook_, double bid_price_, double bid_size_, double ask_price_, double ask_size_, std::shared_ptr<ConsolidatedBook> consolidated_ = nullptr): 
+        EventMsg(timestamp_, exchange_, market_type_, security_, orderbook_, consolidated_), bid_price(bid_price_), bid_size(bid_size_), ask_price(ask_price_), ask_size(ask_size_) {}
 
     double bid_price;  /*< best bid price */
     double bid_size;   /*< best bid size in base currency */
@@ -72,7 +74,7 @@ class QuoteEventMsg : public EventMsg {
      */
     friend ostream& operator<<(ostream& os, QuoteEventMsg& msg) {
         os << "========== Quote Update ==========" << endl;
-        os << "Timestamp: " << msg.timestamp->toString() << endl;
+        os << "Timestamp: " << formatTimestamp(msg.timestamp) << endl;
         os << "Market: " << msg.market_type << endl;
         os << "Security: " << msg.security << endl;
         os << "Exchange: " << msg.exchange->getName() << endl;
@@ -91,8 +93,8 @@ class QuoteEventMsg : public EventMsg {
  */ 
 class DepthEventMsg : public EventMsg {
 public:
-    DepthEventMsg(std::shared_ptr<TimeType> timestamp_, std::shared_ptr<Exchange> exchange_, MarketType market_type_, std::shared_ptr<Security> security_, std::shared_ptr<OrderBook> orderbook_, int side_, double price_, double size_): 
-        EventMsg(timestamp_, exchange_, market_type_, security_, orderbook_), side(side_), price(price_), size(size_) {}
+    DepthEventMsg(long long timestamp_, std::shared_ptr<Exchange> exchange_, MarketType market_type_, std::shared_ptr<Security> security_, std::shared_ptr<OrderBook> orderbook_, int side_, double price_, double size_, std::shared_ptr<ConsolidatedBook> consolidated_ = nullptr): 
+        EventMsg(timestamp_, exchange_, market_type_, security_, orderbook_, consolidated_), side(side_), price(price_), size(size_) {}
 
     int side;      /*< indicates bid (1) or ask (-1) side of the order book */
     double price;  /*< price for the entry in the order book */
@@ -103,7 +105,7 @@ class DepthEventMsg : public EventMsg {
      */
     friend ostream& operator<<(ostream& os, DepthEventMsg& msg) {
         os << "========== Quote Update ==========" << endl;
-        os << "Timestamp: " << msg.timestamp->toString() << endl;
+        os << "Timestamp: " << formatTimestamp(msg.timestamp) << endl;
         os << "Market: " << msg.market_type << endl;
         os << "Security: " << msg.security << endl;
         os << "Exchange: " << msg.exchange->getName() << endl;
@@ -0,0 +1,437 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "./compression.h"
+#include "./filestamp.h"
+#include "./marketdata.h"
+#include "./marketevent.h"
+#include "./parallelcsv.h"
+
+using namespace std;
+
+
+/**
+ * Binary event store format.
+ *
+ * Layout:
+ *  1. EventStoreHeader (64 bytes)
+ *  2. num_events fixed-width MarketEvent records (128 bytes each)
+ *  3. Instrument table: uint32 count, then per instrument uint8 market type, uint16 length + MARKET_CENTER bytes,
+ *     uint16 length + SYMBOL bytes
+ *  4. Source description: uint32 length + absolute path of the CSV file the store was converted from
+ *
+ * All integers are stored in host byte order; stores are a local cache, not an interchange format.
+ */
+constexpr char EVENT_STORE_MAGIC[8] = {'C', 'P', 'E', 'V', 'E', 'N', 'T', 'S'};
+constexpr uint32_t EVENT_STORE_VERSION = 1;
+constexpr const char* EVENT_STORE_EXTENSION = ".events";
+
+/**
+ * Header of an event store file.
+ */
+struct EventStoreHeader {
+    char magic[8];                  /*< EVENT_STORE_MAGIC */
+    uint32_t version;               /*< EVENT_STORE_VERSION */
+    uint32_t record_size;           /*< sizeof(MarketEvent) */
+    uint64_t num_events;            /*< Number of records */
+    uint64_t events_offset;         /*< Byte offset of the first record */
+    uint64_t instruments_offset;    /*< Byte offset of the instrument table */
+    uint64_t source_size;           /*< Size of the source CSV file in bytes */
+    int64_t source_mtime;           /*< Last write time of the source CSV file */
+    uint64_t reserved;              /*< Always zero */
+};
+
+static_assert(sizeof(EventStoreHeader) == 64, "EventStoreHeader must stay a 64 byte header");
+
+
+/**
+ * Writer for event store files.
+ * Writes to a temporary file that is renamed into place by finish(), so a partially written store is never picked up.
+ */
+class EventStoreWriter {
+    public:
+        /**
+         * Constructor
+         * @param path_ path of the event store to create.
+         */
+        EventStoreWriter(const string& path_): path(path_), temp_path(path_ + ".tmp") {
+            file = fopen(temp_path.c_str(), "wb");
+            if (!file) {
+                throw runtime_error("Error opening " + temp_path + " for writing");
+                return;
+            }
+
+            EventStoreHeader header{};
+            fwrite(&header, sizeof(header), 1, file);
+        }
+
+        /**
+         * Destructor. Discards the temporary file if the store was not finished.
+         */
+        ~EventStoreWriter() {
+            if (file) {
+                fclose(file);
+                remove(temp_path.c_str());
+            }
+        }
+
+        EventStoreWriter(const EventStoreWriter&) = delete;
+        EventStoreWriter& operator=(const EventStoreWriter&) = delete;
+
+        /**
+         * Appends an event.
+         */
+        void append(const MarketEvent& event) {
+            fwrite(&event, sizeof(MarketEvent), 1, file);
+            ++num_events;
+        }
+
+        /**
+         * Writes the instrument table and the header, then moves the store into place.
+         * @param instruments instruments referred to by the appended events.
+         * @param source_path path of the CSV file the events were converted from.
+         * @param source_stamp stamp of the CSV file.
+         */
+        void finish(const InstrumentTable& instruments, const string& source_path, const FileStamp& source_stamp) {
+            EventStoreHeader header{};
+            memcpy(header.magic, EVENT_STORE_MAGIC, sizeof(header.magic));
+            header.version = EVENT_STORE_VERSION;
+            header.record_size = sizeof(MarketEvent);
+            header.num_events = num_events;
+            header.events_offset = sizeof(EventStoreHeader);
+            header.instruments_offset = sizeof(EventStoreHeader) + num_events * sizeof(MarketEvent);
+            header.source_size = source_stamp.size;
+            header.source_mtime = source_stamp.mtime;
+
+            uint32_t num_instruments = static_cast<uint32_t>(instruments.size());
+            fwrite(&num_instruments, sizeof(num_instruments), 1, file);
+            for (uint32_t i = 0; i < num_instruments; ++i) {
+                const Instrument& instrument = instruments.at(static_cast<uint16_t>(i));
+                uint8_t market_type = static_cast<uint8_t>(instrument.market_type);
+                fwrite(&market_type, sizeof(market_type), 1, file);
+                writeString16(instrument.exchange);
+                writeString16(instrument.symbol);
+            }
+
+            uint32_t path_length = static_cast<uint32_t>(source_path.size());
+            fwrite(&path_length, sizeof(path_length), 1, file);
+            fwrite(source_path.data(), 1, source_path.size(), file);
+
+            fseek(file, 0, SEEK_SET);
+            fwrite(&header, sizeof(header), 1, file);
+
+            bool failed = ferror(file) != 0;
+            failed |= fclose(file) != 0;
+            file = nullptr;
+
+            if (failed || rename(temp_path.c_str(), path.c_str()) != 0) {
+                remove(temp_path.c_str());
+                throw runtime_error("Error writing " + path);
+            }
+        }
+
+    private:
+        /**
+         * Helper function writing a string prefixed by its 16 bit length.
+         */
+        void writeString16(const string& value) {
+            uint16_t length = static_cast<uint16_t>(value.size());
+            fwrite(&length, sizeof(length), 1, file);
+            fwrite(value.data(), 1, length, file);
+        }
+
+        string path;                /*< Final path of the store */
+        string temp_path;           /*< Path written until finish() */
+        FILE* file = nullptr;       /*< Temporary file */
+        uint64_t num_events = 0;    /*< Number of events appended */
+};
+
+
+/**
+ * Event source replaying an event store file.
+ * The file is memory-mapped and events are read in place.
+ */
+class EventStoreReader : public EventSource {
+    public:
+        /**
+         * Constructor. Maps the file and validates its layout.
+         * @param path path of the event store.
+         */
+        EventStoreReader(const string& path) {
+            fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw invalid_argument("Error opening the file");
+                return;
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(EventStoreHeader)) {
+                close(fd);
+                throw runtime_error(path + " is not an event store");
+                return;
+            }
+            size = static_cast<size_t>(st.st_size);
+
+            void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("Error mapping " + path);
+                return;
+            }
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(mapping);
+
+            memcpy(&header, data, sizeof(header));
+            if (memcmp(header.magic, EVENT_STORE_MAGIC, sizeof(header.magic)) != 0 || header.version != EVENT_STORE_VERSION
+                    || header.record_size != sizeof(MarketEvent) || header.instruments_offset > size
+                    || header.events_offset + header.num_events * sizeof(MarketEvent) != header.instruments_offset) {
+                unmap();
+                throw runtime_error(path + " is not a valid event store of version " + to_string(EVENT_STORE_VERSION));
+                return;
+            }
+
+            events = reinterpret_cast<const MarketEvent*>(data + header.events_offset);
+            readTail(path);
+        }
+
+        /**
+         * Destructor. Unmaps the file.
+         */
+        ~EventStoreReader() {unmap();}
+
+        EventStoreReader(const EventStoreReader&) = delete;
+        EventStoreReader& operator=(const EventStoreReader&) = delete;
+
+        /**
+         * Reads the next event.
+         */
+        bool nextEvent(MarketEvent& event) override {
+            if (position >= header.num_events) {
+                return false;
+            }
+
+            event = events[position++];
+            return true;
+        }
+
+        /**
+         * Getter for instruments of the store.
+         */
+        const InstrumentTable& getInstruments() const override {return instruments;}
+
+        /**
+         * Moves to the first event at or after a timestamp. Records are ordered by time, so this is a binary search.
+         */
+        bool seek(long long timestamp) override {
+            const MarketEvent* first = lower_bound(events, events + header.num_events, timestamp, [](const MarketEvent& event, long long value) {
+                return event.timestamp < value;
+            });
+            position = first - events;
+            return true;
+        }
+
+        /**
+         * Getter for number of events in the store.
+         */
+        uint64_t getNumEvents() const {return header.num_events;}
+
+        /**
+         * Getter for path of the CSV file the store was converted from.
+         */
+        const string& getSourcePath() const {return source_path;}
+
+        /**
+         * Getter for stamp of the CSV file the store was converted from.
+         */
+        FileStamp getSourceStamp() const {
+            FileStamp stamp;
+            stamp.size = header.source_size;
+            stamp.mtime = header.source_mtime;
+            return stamp;
+        }
+
+    private:
+        /**
+         * Helper function parsing the instrument table and the source description.
+         */
+        void readTail(const string& path) {
+            const char* cursor = data + header.instruments_offset;
+            const char* end = data + size;
+
+            auto read = [&](void* out, size_t length) {
+                if (static_cast<size_t>(end - cursor) < length) {
+                    unmap();
+                    throw runtime_error(path + " is truncated");
+                }
+                memcpy(out, cursor, length);
+                cursor += length;
+            };
+            auto readString16 = [&]() {
+                uint16_t length = 0;
+                read(&length, sizeof(length));
+                string value(length, '\0');
+                read(value.data(), length);
+                return value;
+            };
+
+            uint32_t num_instruments = 0;
+            read(&num_instruments, sizeof(num_instruments));
+            for (uint32_t i = 0; i < num_instruments; ++i) {
+                uint8_t market_type = 0;
+                read(&market_type, sizeof(market_type));
+                string exchange = readString16();
+                string symbol = readString16();
+                instruments.add({exchange, symbol, static_cast<MarketType>(market_type)});
+            }
+
+            uint32_t path_length = 0;
+            read(&path_length, sizeof(path_length));
+            source_path.resize(path_length);
+            read(source_path.data(), path_length);
+        }
+
+        /**
+         * Helper function releasing the mapping.
+         */
+        void unmap() {
+            if (data != nullptr) {
+                munmap(const_cast<char*>(data), size);
+                data = nullptr;
+            }
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+
+        int fd = -1;                        /*< File descriptor of the store */
+        const char* data = nullptr;         /*< Start of the mapping */
+        size_t size = 0;                    /*< Size of the mapping in bytes */
+        EventStoreHeader header{};          /*< Header of the store */
+        const MarketEvent* events = nullptr;    /*< First record */
+        uint64_t position = 0;              /*< Index of the next record */
+        InstrumentTable instruments;        /*< Instruments of the store */
+        string source_path;                 /*< Path of the source CSV file */
+};
+
+
+/**
+ * Converts a market data CSV file into an event store.
+ * Plain CSV files are decoded by ParallelCsvEventSource, so conversion scales with the number of cores;
+ * compressed files are decompressed on the fly by CompressedCsvEventSource.
+ * @param csv_path file path for market data input.
+ * @param output_path path of the event store to create.
+ * @param num_threads number of decoding threads; 0 uses one per hardware thread.
+ * @param symbols symbol table of the configured instruments, may be null.
+ * @return number of events written.
+ */
+inline uint64_t convertMarketData(const string& csv_path, const string& output_path, size_t num_threads = 0, shared_ptr<const SymbolTable> symbols = nullptr) {
+    FileStamp stamp = FileStamp::of(csv_path);
+    unique_ptr<EventSource> source;
+    if (detectCompression(csv_path) != Compression::None) {
+        source = make_unique<CompressedCsvEventSource>(csv_path, COMPRESSED_BLOCK_SIZE, symbols);
+    } else {
+        source = make_unique<ParallelCsvEventSource>(csv_path, num_threads, PARALLEL_CSV_BLOCK_SIZE, symbols);
+    }
+    EventStoreWriter writer(output_path);
+
+    MarketEvent event;
+    uint64_t num_events = 0;
+    while (source->nextEvent(event)) {
+        writer.append(event);
+        ++num_events;
+    }
+
+    writer.finish(source->getInstruments(), std::filesystem::absolute(csv_path).string(), stamp);
+    return num_events;
+}
+
+/**
+ * Path of the cached event store for a CSV file.
+ * @param csv_path file path for market data input.
+ * @param cache_directory directory holding cached stores; if empty, the store is placed next to the CSV file.
+ */
+inline string getEventStoreCachePath(const string& csv_path, const string& cache_directory) {
+    if (cache_directory.empty()) {
+        return csv_path + EVENT_STORE_EXTENSION;
+    }
+
+    // Key the file name by the absolute path so equally named files in different directories do not collide
+    ostringstream name;
+    name << std::filesystem::path(csv_path).filename().string() << "." << hex << std::hash<string>{}(std::filesystem::absolute(csv_path).string())
+            << EVENT_STORE_EXTENSION;
+    return (std::filesystem::path(cache_directory) / name.str()).string();
+}
+
+/**
+ * Checks whether a cached event store was converted from the current contents of a CSV file,
+ * i.e. it was converted from the same path and the size and last write time still match.
+ */
+inline bool isEventStoreCacheValid(const string& store_path, const string& csv_path) {
+    if (!std::filesystem::exists(store_path)) {
+        return false;
+    }
+
+    try {
+        EventStoreReader store(store_path);
+        FileStamp current = FileStamp::of(csv_path);
+        FileStamp converted = store.getSourceStamp();
+        return store.getSourcePath() == std::filesystem::absolute(csv_path).string() && converted.size == current.size && converted.mtime == current.mtime;
+    } catch (const exception&) {
+        return false;   // Corrupted or outdated format; convert again
+    }
+}
+
+/**
+ * Opens market data for replay.
+ * Event stores are replayed directly. CSV files are converted to an event store on first use and the store is reused
+ * while the CSV file is unchanged; if the store cannot be written, the CSV file is decoded directly.
+ * Compressed CSV files (gzip, zstd, lz4) are always decompressed on the fly, as a store would take far more disk space.
+ * @param data_path file path for market data input.
+ * @param use_cache whether to convert and cache CSV files.
+ * @param cache_directory directory holding cached stores; if empty, stores are placed next to the CSV files.
+ * @param symbols symbol table used to intern instruments while decoding CSV files, may be null.
+ */
+inline unique_ptr<EventSource> openMarketData(const string& data_path, bool use_cache = true, const string& cache_directory = "",
+        shared_ptr<const SymbolTable> symbols = nullptr) {
+    if (std::filesystem::path(data_path).extension() == EVENT_STORE_EXTENSION) {
+        return make_unique<EventStoreReader>(data_path);
+    }
+    if (detectCompression(data_path) != Compression::None) {
+        return make_unique<CompressedCsvEventSource>(data_path, COMPRESSED_BLOCK_SIZE, symbols);
+    }
+    if (!use_cache) {
+        return make_unique<CsvEventSource>(data_path, symbols, cache_directory);
+    }
+    if (!std::filesystem::exists(data_path)) {
+        throw invalid_argument("Error opening the file");
+    }
+
+    string store_path = getEventStoreCachePath(data_path, cache_directory);
+    if (!isEventStoreCacheValid(store_path, data_path)) {
+        try {
+            if (!cache_directory.empty()) {
+                std::filesystem::create_directories(cache_directory);
+            }
+            convertMarketData(data_path, store_path, 0, symbols);
+        } catch (const runtime_error&) {
+            return make_unique<CsvEventSource>(data_path, symbols, cache_directory);  // Store not writable
+        }
+    }
+
+    return make_unique<EventStoreReader>(store_path);
+}
@@ -6,6 +6,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -206,7 +207,7 @@ class Exchange {
         /**
          * Search for the secuity with provided name
          */
-        std::shared_ptr<Security> findSecurity(MarketType market_type, const std::string& name) const {
+        std::shared_ptr<Security> findSecurity(MarketType market_type, std::string_view name) const {
             auto it = listed_securities.find(market_type);
             if (it != listed_securities.end()) {
                 // Search within the vector for the specified security name
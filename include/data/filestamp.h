@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+using namespace std;
+
+
+/**
+ * Size and last write time of a file; used to detect whether a file derived from it (event store, index) is stale.
+ */
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+
+    /**
+     * Reads the stamp of a file.
+     */
+    static FileStamp of(const string& path) {
+        FileStamp stamp;
+        stamp.size = std::filesystem::file_size(path);
+        stamp.mtime = std::filesystem::last_write_time(path).time_since_epoch().count();
+        return stamp;
+    }
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "./marketevent.h"
+#include "./timestampindex.h"
+#include "./timetype.h"
+#include "./tokenizer.h"
+
+using namespace std;
+
+
+/**
+ * Number of columns in the market data CSV format (see docs/documentation.md).
+ */
+constexpr size_t MARKET_DATA_NUM_COLUMNS = 20;
+
+/**
+ * Converts a CSV field to double without copying it.
+ * Equivalent to stod, but works on string_view and never allocates.
+ * @param field field to convert.
+ * @return converted value.
+ */
+inline double parseDouble(string_view field) {
+    double value = 0.0;
+
+    if (!parseDecimal(field, value)) {
+        throw invalid_argument("Invalid numeric field '" + string(field) + "'");
+        return 0.0;
+    }
+
+    return value;
+}
+
+
+/**
+ * Zero-copy reader for market data CSV files.
+ * Maps the whole file into memory and hands out fields as string_views pointing into the mapping,
+ * so reading a row costs no heap allocation. The views are valid as long as the reader is alive.
+ * Rows are split by CsvTokenizer, which uses AVX2/SSE when the CPU supports them.
+ */
+class MarketDataReader {
+    public:
+        using Row = array<string_view, MARKET_DATA_NUM_COLUMNS>;
+
+        /**
+         * Constructor. Maps the file and skips the header line.
+         * @param data_path file path for market data input.
+         */
+        MarketDataReader(const string& data_path) {
+            fd = open(data_path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw invalid_argument("Error opening the file");
+                return;
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                throw runtime_error("Error reading the size of " + data_path);
+                return;
+            }
+            size = static_cast<size_t>(st.st_size);
+
+            if (size > 0) {
+                void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED) {
+                    close(fd);
+                    throw runtime_error("Error mapping " + data_path);
+                    return;
+                }
+                madvise(mapping, size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(mapping);
+            }
+
+            tokenizer = CsvTokenizer(data, data + size);
+
+            Row header;
+            nextRow(header);    // Skip first line
+            rows_read = 0;
+            rows_offset = tokenizer.getCursor() - data;
+        }
+
+        /**
+         * Destructor. Unmaps the file.
+         */
+        ~MarketDataReader() {
+            if (data != nullptr) {
+                munmap(const_cast<char*>(data), size);
+            }
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        MarketDataReader(const MarketDataReader&) = delete;
+        MarketDataReader& operator=(const MarketDataReader&) = delete;
+
+        /**
+         * Reads the next row and splits it into fields.
+         * Missing trailing fields are left empty, extra fields are ignored, empty lines are skipped.
+         * @param row array filled with views of the fields of the row.
+         * @return false if there are no more rows.
+         */
+        bool nextRow(Row& row) {
+            if (!tokenizer.nextRow(row)) {
+                return false;
+            }
+
+            ++rows_read;
+            return true;
+        }
+
+        /**
+         * Getter for number of rows read so far (header excluded).
+         */
+        size_t getRowsRead() const {return rows_read;}
+
+        /**
+         * Getter for file size in bytes.
+         */
+        size_t getSize() const {return size;}
+
+        /**
+         * Moves to the row starting at a byte offset.
+         * @param offset byte offset of a row start, at or after getRowsOffset().
+         */
+        void seek(size_t offset) {
+            tokenizer = CsvTokenizer(data + min(offset, size), data + size);
+        }
+
+        /**
+         * Getter for the contents of the file.
+         */
+        string_view getFile() const {return string_view(data, size);}
+
+        /**
+         * Getter for byte offset of the first row after the header.
+         */
+        size_t getRowsOffset() const {return rows_offset;}
+
+        /**
+         * Getter for the part of the file not read yet.
+         */
+        string_view getUnread() const {return string_view(tokenizer.getCursor(), data + size - tokenizer.getCursor());}
+
+    private:
+        int fd = -1;                    /*< File descriptor of the market data file */
+        const char* data = nullptr;     /*< Start of the mapping */
+        size_t size = 0;                /*< Size of the mapping in bytes */
+        CsvTokenizer tokenizer{nullptr, nullptr};  /*< Splits the mapping into rows */
+        size_t rows_read = 0;           /*< Number of rows read */
+        size_t rows_offset = 0;         /*< Byte offset of the first row after the header */
+};
+
+
+/**
+ * Decodes a market data row into a market event.
+ * Fields a message type does not use may be empty and are decoded as zero.
+ * @param tokens fields of the row.
+ * @param instruments table used to assign the instrument id.
+ * @param event event to fill.
+ */
+inline void decodeMarketDataRow(const MarketDataReader::Row& tokens, InstrumentTable& instruments, MarketEvent& event) {
+    event = MarketEvent{};
+    event.timestamp = parseTimestamp(tokens[0]);
+    event.message_type = toMessageType(tokens[2]);
+    event.instrument_id = instruments.intern(tokens[4], tokens[3], tokens[5] == "S" ? MarketType::Spot : MarketType::Futures);
+
+    bool has_price = event.message_type == MessageType::Trade || event.message_type == MessageType::BuySideUpdate || event.message_type == MessageType::SellSideUpdate;
+    bool has_top_quote = event.message_type == MessageType::BidUpdate || event.message_type == MessageType::AskUpdate;
+
+    // Columns the message type does not use may be empty
+    auto field = [&tokens](size_t column, bool required) {
+        return (tokens[column].empty() && !required) ? 0.0 : parseDouble(tokens[column]);
+    };
+
+    event.price = field(6, has_price);
+    event.size = field(7, has_price);
+    for (size_t level = 0; level < MARKET_EVENT_NUM_LEVELS; ++level) {
+        event.bid_price[level] = field(8 + 2 * level, has_top_quote && level == 0);
+        event.bid_size[level] = field(9 + 2 * level, has_top_quote && level == 0);
+        event.ask_price[level] = field(14 + 2 * level, has_top_quote && level == 0);
+        event.ask_size[level] = field(15 + 2 * level, has_top_quote && level == 0);
+    }
+}
+
+
+/**
+ * Event source decoding a market data CSV file through MarketDataReader.
+ */
+class CsvEventSource : public EventSource {
+    public:
+        /**
+         * Constructor
+         * @param data_path file path for market data input.
+         * @param symbols symbol table of the configured instruments, may be null.
+         * @param cache_directory_ directory for the timestamp index; if empty, it is placed next to the CSV file.
+         */
+        CsvEventSource(const string& data_path_, shared_ptr<const SymbolTable> symbols = nullptr, const string& cache_directory_ = ""):
+                data_path(data_path_), cache_directory(cache_directory_), reader(data_path_), instruments(std::move(symbols)) {}
+
+        /**
+         * Reads and decodes the next row.
+         */
+        bool nextEvent(MarketEvent& event) override {
+            if (!reader.nextRow(tokens)) {
+                return false;
+            }
+
+            decodeMarketDataRow(tokens, instruments, event);
+            return true;
+        }
+
+        /**
+         * Getter for instruments seen so far.
+         */
+        const InstrumentTable& getInstruments() const override {return instruments;}
+
+        /**
+         * Moves to the last indexed row before a timestamp, building the timestamp index of the file on first use.
+         */
+        bool seek(long long timestamp) override {
+            if (!index_loaded) {
+                index = openTimestampIndex(data_path, cache_directory, reader.getFile(), reader.getRowsOffset());
+                index_loaded = true;
+            }
+
+            reader.seek(index.findOffset(timestamp, reader.getRowsOffset()));
+            return true;
+        }
+
+        /**
+         * Getter for the underlying reader.
+         */
+        const MarketDataReader& getReader() const {return reader;}
+
+    private:
+        string data_path;               /*< Path of the CSV file */
+        string cache_directory;         /*< Directory for the timestamp index, or empty */
+        MarketDataReader reader;        /*< Reader of the CSV file */
+        MarketDataReader::Row tokens;   /*< Fields of the current row */
+        InstrumentTable instruments;    /*< Instruments seen so far */
+        TimestampIndex index;           /*< Timestamp index, loaded by the first seek */
+        bool index_loaded = false;      /*< Whether index is loaded */
+};
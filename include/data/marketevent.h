@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./symboltable.h"
+#include "./util.h"
+
+using namespace std;
+
+
+/**
+ * Number of book levels per side carried by a market data row.
+ */
+constexpr size_t MARKET_EVENT_NUM_LEVELS = 3;
+
+/**
+ * Enumeration class for market data message types
+ */
+enum class MessageType : uint8_t {
+    Trade,              /*< 'T' */
+    BidUpdate,          /*< "BID_UPDATE" */
+    AskUpdate,          /*< "ASK_UPDATE" */
+    BuySideUpdate,      /*< "BUY_SIDE_UPDATE" */
+    SellSideUpdate,     /*< "SELL_SIDE_UPDATE" */
+    Unknown             /*< Any other message type; replayed without a strategy callback */
+};
+
+/**
+ * Converts MESSAGE_TYPE field to MessageType.
+ */
+inline MessageType toMessageType(string_view field) {
+    if (field == "T") {return MessageType::Trade;}
+    if (field == "BID_UPDATE") {return MessageType::BidUpdate;}
+    if (field == "ASK_UPDATE") {return MessageType::AskUpdate;}
+    if (field == "BUY_SIDE_UPDATE") {return MessageType::BuySideUpdate;}
+    if (field == "SELL_SIDE_UPDATE") {return MessageType::SellSideUpdate;}
+    return MessageType::Unknown;
+}
+
+
+/**
+ * Fixed-width record for one market data row.
+ * This is both the in-memory representation used by the backtester and the on-disk record of the event store,
+ * so the layout must not change without bumping EVENT_STORE_VERSION.
+ */
+struct MarketEvent {
+    int64_t timestamp;              /*< COLLECTION_TIME in nanoseconds since epoch */
+    MessageType message_type;       /*< MESSAGE_TYPE */
+    uint8_t reserved;               /*< Padding, always zero */
+    uint16_t instrument_id;         /*< Index into the instrument table of the event source */
+    uint32_t reserved2;             /*< Padding, always zero */
+    double price;                   /*< PRICE */
+    double size;                    /*< SIZE */
+    double bid_price[MARKET_EVENT_NUM_LEVELS];  /*< BID_PRICE_1..3 */
+    double bid_size[MARKET_EVENT_NUM_LEVELS];   /*< BID_SIZE_1..3 */
+    double ask_price[MARKET_EVENT_NUM_LEVELS];  /*< ASK_PRICE_1..3 */
+    double ask_size[MARKET_EVENT_NUM_LEVELS];   /*< ASK_SIZE_1..3 */
+};
+
+static_assert(sizeof(MarketEvent) == 128, "MarketEvent must stay a 128 byte record");
+
+
+/**
+ * Table assigning dense ids to instruments in order of first appearance.
+ * With a symbol table, configured instruments are resolved through its perfect hash and only instruments missing
+ * from it are searched linearly, so decoding a row neither allocates nor compares strings against every instrument.
+ */
+class InstrumentTable {
+    public:
+        /**
+         * Default constructor, without symbol table.
+         */
+        InstrumentTable() = default;
+
+        /**
+         * Constructor
+         * @param symbols_ symbol table of the configured instruments, may be null.
+         */
+        explicit InstrumentTable(shared_ptr<const SymbolTable> symbols_): symbols(std::move(symbols_)) {
+            if (symbols) {
+                symbol_ids.assign(symbols->size(), UNASSIGNED_ID);
+            }
+        }
+
+        /**
+         * Finds the id of an instrument, adding it if it was not seen before.
+         * Instruments not in the symbol table are few, so a linear scan over string_views beats hashing and never
+         * allocates for known ones.
+         */
+        uint16_t intern(string_view exchange, string_view symbol, MarketType market_type) {
+            int symbol_id = symbols ? symbols->find(exchange, symbol, market_type) : SYMBOL_NOT_FOUND;
+            if (symbol_id != SYMBOL_NOT_FOUND && symbol_ids[symbol_id] != UNASSIGNED_ID) {
+                return static_cast<uint16_t>(symbol_ids[symbol_id]);
+            }
+
+            if (symbol_id == SYMBOL_NOT_FOUND) {
+                for (size_t i = 0; i < instruments.size(); ++i) {
+                    const Instrument& instrument = instruments[i];
+                    if (instrument.market_type == market_type && instrument.symbol == symbol && instrument.exchange == exchange) {
+                        return static_cast<uint16_t>(i);
+                    }
+                }
+            }
+
+            if (instruments.size() > UINT16_MAX) {
+                throw runtime_error("Too many instruments in market data");
+                return 0;
+            }
+
+            // Exchange names match the symbol table case-insensitively; keep the spelling of the data
+            instruments.push_back({string(exchange), string(symbol), market_type});
+            if (symbol_id != SYMBOL_NOT_FOUND) {
+                symbol_ids[symbol_id] = static_cast<uint32_t>(instruments.size() - 1);
+            }
+            return static_cast<uint16_t>(instruments.size() - 1);
+        }
+
+        /**
+         * Adds an instrument with the next id without checking for duplicates.
+         */
+        void add(const Instrument& instrument) {instruments.push_back(instrument);}
+
+        /**
+         * Getter for the instrument with given id.
+         */
+        const Instrument& at(uint16_t id) const {return instruments.at(id);}
+
+        /**
+         * Getter for number of instruments.
+         */
+        size_t size() const {return instruments.size();}
+
+    private:
+        static constexpr uint32_t UNASSIGNED_ID = UINT32_MAX;   /*< Symbol table entry without id yet */
+
+        vector<Instrument> instruments;             /*< Instruments indexed by id */
+        shared_ptr<const SymbolTable> symbols;      /*< Symbol table of the configured instruments, may be null */
+        vector<uint32_t> symbol_ids;                /*< Id of each symbol table entry, or UNASSIGNED_ID */
+};
+
+
+/**
+ * Abstract class for sources of market events replayed by the backtester.
+ */
+class EventSource {
+    public:
+        /**
+         * Destructor
+         */
+        virtual ~EventSource() = default;
+
+        /**
+         * Reads the next event.
+         * @param event event to fill.
+         * @return false if there are no more events.
+         */
+        virtual bool nextEvent(MarketEvent& event) = 0;
+
+        /**
+         * Getter for the instruments referred to by instrument_id of the events read so far.
+         */
+        virtual const InstrumentTable& getInstruments() const = 0;
+
+        /**
+         * Moves the source to the first event at or after a timestamp, or to an earlier event.
+         * Sources that cannot seek stay where they are, so readers must still skip earlier events.
+         * @param timestamp nanoseconds since epoch.
+         * @return false if the source cannot seek.
+         */
+        virtual bool seek(long long /*timestamp*/) {return false;}
+};
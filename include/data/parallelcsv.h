@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "./marketdata.h"
+#include "./marketevent.h"
+#include "./tokenizer.h"
+
+using namespace std;
+
+
+/**
+ * Default size in bytes of the newline-aligned blocks a market data file is split into for parallel parsing.
+ */
+constexpr size_t PARALLEL_CSV_BLOCK_SIZE = 4 << 20;
+
+/**
+ * Event source decoding a market data CSV file on several worker threads.
+ * The mapped file is split into byte ranges ending on line boundaries. Workers claim ranges in file order and
+ * decode each into a block of events with its own instrument table; blocks are handed out strictly in file order
+ * and their instrument ids are translated to one shared table in order of first appearance, so the events and ids
+ * are exactly those CsvEventSource produces. At most two blocks per worker are decoded ahead of the reader,
+ * which bounds memory use regardless of file size.
+ */
+class ParallelCsvEventSource : public EventSource {
+    public:
+        /**
+         * Constructor. Splits the file and starts the workers.
+         * @param data_path file path for market data input.
+         * @param num_threads number of worker threads; 0 uses one per hardware thread.
+         * @param block_size approximate size of a range in bytes.
+         * @param symbols_ symbol table of the configured instruments, may be null.
+         */
+        ParallelCsvEventSource(const string& data_path, size_t num_threads = 0, size_t block_size = PARALLEL_CSV_BLOCK_SIZE, shared_ptr<const SymbolTable> symbols_ = nullptr)
+                : reader(data_path), symbols(std::move(symbols_)), instruments(symbols) {
+            if (num_threads == 0) {
+                num_threads = max(1u, thread::hardware_concurrency());
+            }
+
+            // Range boundaries, each one just after a newline
+            string_view unread = reader.getUnread();
+            const char* begin = unread.data();
+            const char* end = begin + unread.size();
+            boundaries.push_back(begin);
+            while (end - boundaries.back() > static_cast<ptrdiff_t>(block_size)) {
+                const char* newline = static_cast<const char*>(memchr(boundaries.back() + block_size, '\n', end - boundaries.back() - block_size));
+                if (newline == nullptr) {
+                    break;
+                }
+                boundaries.push_back(newline + 1);
+            }
+            boundaries.push_back(end);
+
+            blocks.resize(2 * num_threads);
+            for (size_t i = 0; i < num_threads; ++i) {
+                workers.emplace_back(&ParallelCsvEventSource::work, this);
+            }
+        }
+
+        /**
+         * Destructor. Stops the workers.
+         */
+        ~ParallelCsvEventSource() override {
+            {
+                lock_guard<mutex> lock(blocks_mutex);
+                stopping = true;
+            }
+            block_consumed.notify_all();
+            for (thread& worker : workers) {
+                worker.join();
+            }
+        }
+
+        ParallelCsvEventSource(const ParallelCsvEventSource&) = delete;
+        ParallelCsvEventSource& operator=(const ParallelCsvEventSource&) = delete;
+
+        /**
+         * Reads the next event, waiting for its block to be decoded if needed.
+         * An error in a range is thrown after the events of the rows before it.
+         */
+        bool nextEvent(MarketEvent& event) override {
+            while (position == current.events.size()) {
+                if (current.error) {
+                    rethrow_exception(current.error);
+                }
+                if (!takeNextBlock()) {
+                    return false;
+                }
+            }
+
+            event = current.events[position++];
+            event.instrument_id = instrument_ids[event.instrument_id];
+            return true;
+        }
+
+        /**
+         * Getter for instruments seen so far.
+         */
+        const InstrumentTable& getInstruments() const override {return instruments;}
+
+        /**
+         * Getter for number of ranges the file is split into.
+         */
+        size_t getNumRanges() const {return boundaries.size() - 1;}
+
+    private:
+        /**
+         * Events decoded from one range, with instrument ids local to the range.
+         */
+        struct EventBlock {
+            vector<MarketEvent> events;
+            InstrumentTable instruments;
+            exception_ptr error;            /*< Error that stopped decoding the range */
+            bool ready = false;
+        };
+
+        /**
+         * Helper function moving the next block into current and mapping its instruments to the shared table.
+         * @return false if all ranges were read.
+         */
+        bool takeNextBlock() {
+            if (next_to_read == getNumRanges()) {
+                return false;
+            }
+
+            {
+                unique_lock<mutex> lock(blocks_mutex);
+                EventBlock& slot = blocks[next_to_read % blocks.size()];
+                block_ready.wait(lock, [&slot]() {return slot.ready;});
+                current = std::move(slot);
+                slot = EventBlock();
+                ++next_to_read;
+            }
+            block_consumed.notify_all();
+
+            instrument_ids.resize(current.instruments.size());
+            for (size_t i = 0; i < current.instruments.size(); ++i) {
+                const Instrument& instrument = current.instruments.at(static_cast<uint16_t>(i));
+                instrument_ids[i] = instruments.intern(instrument.exchange, instrument.symbol, instrument.market_type);
+            }
+            position = 0;
+            return true;
+        }
+
+        /**
+         * Body of the worker threads.
+         */
+        void work() {
+            while (true) {
+                size_t index;
+                {
+                    unique_lock<mutex> lock(blocks_mutex);
+                    block_consumed.wait(lock, [this]() {return stopping || next_to_decode == getNumRanges() || next_to_decode < next_to_read + blocks.size();});
+                    if (stopping || next_to_decode == getNumRanges()) {
+                        return;
+                    }
+                    index = next_to_decode++;
+                }
+
+                EventBlock block;
+                block.instruments = InstrumentTable(symbols);
+                decodeRange(boundaries[index], boundaries[index + 1], block);
+
+                {
+                    lock_guard<mutex> lock(blocks_mutex);
+                    block.ready = true;
+                    blocks[index % blocks.size()] = std::move(block);
+                }
+                block_ready.notify_all();
+            }
+        }
+
+        /**
+         * Helper function decoding the rows of a range into a block.
+         */
+        static void decodeRange(const char* begin, const char* end, EventBlock& block) {
+            try {
+                CsvTokenizer tokenizer(begin, end);
+                MarketDataReader::Row tokens;
+                MarketEvent event;
+
+                block.events.reserve((end - begin) / 64);
+                while (tokenizer.nextRow(tokens)) {
+                    decodeMarketDataRow(tokens, block.instruments, event);
+                    block.events.push_back(event);
+                }
+            } catch (...) {
+                block.error = current_exception();
+            }
+        }
+
+        MarketDataReader reader;                /*< Mapping of the CSV file */
+        shared_ptr<const SymbolTable> symbols;  /*< Symbol table of the configured instruments, may be null */
+        vector<const char*> boundaries;         /*< Start of each range, followed by the end of the file */
+
+        vector<EventBlock> blocks;              /*< Decoded blocks, range i in slot i % size */
+        size_t next_to_decode = 0;              /*< Next range a worker claims */
+        size_t next_to_read = 0;                /*< Next range handed to the reader */
+        bool stopping = false;                  /*< Set by the destructor to stop the workers */
+        mutex blocks_mutex;                     /*< Guards blocks, next_to_decode, next_to_read and stopping */
+        condition_variable block_ready;         /*< Signalled when a block is decoded */
+        condition_variable block_consumed;      /*< Signalled when a slot frees up or on stop */
+
+        EventBlock current;                     /*< Block being read */
+        size_t position = 0;                    /*< Index of the next event in current */
+        vector<uint16_t> instrument_ids;        /*< Ids in instruments of the instruments of current */
+        InstrumentTable instruments;            /*< Instruments seen so far */
+
+        vector<thread> workers;                 /*< Worker threads, started last */
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./marketevent.h"
+#include "./spscring.h"
+
+using namespace std;
+
+
+/**
+ * Default number of events buffered between the parser thread and the engine (128 bytes each).
+ */
+constexpr size_t PIPELINE_DEFAULT_CAPACITY = 8192;
+
+/**
+ * Event source reading another event source on a background thread.
+ * The parser thread decodes events and pushes them into an SpscRing, the calling thread pops them, so reading and
+ * decoding overlap with the simulation. Events come out in exactly the order the wrapped source produces them.
+ * Errors thrown by the wrapped source are rethrown by nextEvent once the events before them are consumed.
+ */
+class PipelinedEventSource : public EventSource {
+    public:
+        /**
+         * Constructor. Starts the parser thread.
+         * @param source_ event source to read on the parser thread.
+         * @param capacity number of events buffered between the threads.
+         */
+        PipelinedEventSource(unique_ptr<EventSource> source_, size_t capacity = PIPELINE_DEFAULT_CAPACITY): source(std::move(source_)), ring(capacity) {
+            producer = thread(&PipelinedEventSource::produce, this);
+        }
+
+        /**
+         * Destructor. Stops the parser thread, even if events are left.
+         */
+        ~PipelinedEventSource() override {
+            stopping.store(true, memory_order_relaxed);
+            producer.join();
+        }
+
+        PipelinedEventSource(const PipelinedEventSource&) = delete;
+        PipelinedEventSource& operator=(const PipelinedEventSource&) = delete;
+
+        /**
+         * Pops the next event, waiting for the parser thread if the ring is empty.
+         */
+        bool nextEvent(MarketEvent& event) override {
+            while (!ring.tryPop(event)) {
+                if (finished.load(memory_order_acquire)) {
+                    // Events pushed before finishing are visible now
+                    if (ring.tryPop(event)) {
+                        break;
+                    }
+                    if (error) {
+                        rethrow_exception(error);
+                    }
+                    return false;
+                }
+                this_thread::yield();
+            }
+
+            if (event.instrument_id >= instruments.size()) {
+                lock_guard<mutex> lock(new_instruments_mutex);
+                for (size_t i = instruments.size(); i < new_instruments.size(); ++i) {
+                    instruments.add(new_instruments[i]);
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Getter for instruments of the events popped so far.
+         */
+        const InstrumentTable& getInstruments() const override {return instruments;}
+
+    private:
+        /**
+         * Body of the parser thread.
+         */
+        void produce() {
+            try {
+                MarketEvent event;
+                while (!stopping.load(memory_order_relaxed) && source->nextEvent(event)) {
+                    // Publish new instruments before the first event referring to them
+                    const InstrumentTable& source_instruments = source->getInstruments();
+                    if (source_instruments.size() > num_published) {
+                        lock_guard<mutex> lock(new_instruments_mutex);
+                        for (; num_published < source_instruments.size(); ++num_published) {
+                            new_instruments.push_back(source_instruments.at(static_cast<uint16_t>(num_published)));
+                        }
+                    }
+
+                    while (!ring.tryPush(event)) {
+                        if (stopping.load(memory_order_relaxed)) {
+                            return;
+                        }
+                        this_thread::yield();
+                    }
+                }
+            } catch (...) {
+                error = current_exception();
+            }
+            finished.store(true, memory_order_release);
+        }
+
+        unique_ptr<EventSource> source;         /*< Wrapped source, only used by the parser thread */
+        SpscRing<MarketEvent> ring;             /*< Events decoded but not consumed yet */
+        InstrumentTable instruments;            /*< Consumer's copy of the instruments */
+        vector<Instrument> new_instruments;     /*< Instruments published by the parser thread */
+        mutex new_instruments_mutex;            /*< Guards new_instruments */
+        size_t num_published = 0;               /*< Instruments copied to new_instruments, parser thread only */
+        exception_ptr error;                    /*< Error thrown by the wrapped source */
+        atomic<bool> finished{false};           /*< Set by the parser thread after its last push */
+        atomic<bool> stopping{false};           /*< Set by the destructor to stop the parser thread */
+        thread producer;                        /*< Parser thread, started last */
+};
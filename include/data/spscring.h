@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Size of a cache line, used to keep the producer and consumer indices apart.
+ */
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Bounded lock-free ring buffer for exactly one producer thread and one consumer thread.
+ * Each side owns one index and only reads the other's; a local copy of the other index is refreshed only when
+ * the ring looks full (producer) or empty (consumer), so most operations touch no shared cache line.
+ */
+template <typename T>
+class SpscRing {
+    public:
+        /**
+         * Constructor
+         * @param capacity_ number of slots, rounded up to a power of two.
+         */
+        explicit SpscRing(size_t capacity_) {
+            size_t capacity = 1;
+            while (capacity < capacity_) {
+                capacity <<= 1;
+            }
+            slots.resize(capacity);
+            mask = capacity - 1;
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        /**
+         * Appends an item. Producer thread only.
+         * @return false if the ring is full.
+         */
+        bool tryPush(const T& item) {
+            size_t current_tail = tail.load(memory_order_relaxed);
+            if (current_tail - cached_head > mask) {
+                cached_head = head.load(memory_order_acquire);
+                if (current_tail - cached_head > mask) {
+                    return false;
+                }
+            }
+
+            slots[current_tail & mask] = item;
+            tail.store(current_tail + 1, memory_order_release);
+            return true;
+        }
+
+        /**
+         * Removes the oldest item. Consumer thread only.
+         * @return false if the ring is empty.
+         */
+        bool tryPop(T& item) {
+            size_t current_head = head.load(memory_order_relaxed);
+            if (current_head == cached_tail) {
+                cached_tail = tail.load(memory_order_acquire);
+                if (current_head == cached_tail) {
+                    return false;
+                }
+            }
+
+            item = slots[current_head & mask];
+            head.store(current_head + 1, memory_order_release);
+            return true;
+        }
+
+        /**
+         * Getter for number of slots.
+         */
+        size_t getCapacity() const {return slots.size();}
+
+    private:
+        vector<T> slots;                                        /*< Storage, indexed by position & mask */
+        size_t mask = 0;                                        /*< Number of slots - 1 */
+        alignas(CACHE_LINE_SIZE) atomic<size_t> head{0};        /*< Next position to pop, written by the consumer */
+        size_t cached_tail = 0;                                 /*< Consumer's copy of tail */
+        alignas(CACHE_LINE_SIZE) atomic<size_t> tail{0};        /*< Next position to push, written by the producer */
+        size_t cached_head = 0;                                 /*< Producer's copy of head */
+};
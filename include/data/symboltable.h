@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "./util.h"
+
+using namespace std;
+
+
+/**
+ * Instrument a market event refers to: (MARKET_CENTER, SYMBOL, market type).
+ */
+struct Instrument {
+    string exchange;            /*< MARKET_CENTER as it appears in the data */
+    string symbol;              /*< SYMBOL in pair notation */
+    MarketType market_type;     /*< Spot or Futures */
+};
+
+/**
+ * Result of SymbolTable::find for instruments that are not in the table.
+ */
+constexpr int SYMBOL_NOT_FOUND = -1;
+
+/**
+ * Table of the instruments known up front (e.g. everything listed in exchange.json), with dense ids 0..size()-1.
+ * Lookups go through a perfect hash built with hash-and-displace: a first hash picks a bucket, the bucket's
+ * displacement picks a slot no other instrument uses. A lookup therefore costs two hashes of the bytes, one slot read
+ * and one comparison with the single candidate, with no allocation. Exchange names are matched case-insensitively.
+ */
+class SymbolTable {
+    public:
+        /**
+         * Default constructor, empty table.
+         */
+        SymbolTable(): displacements(1, 0), slots(1, EMPTY_SLOT) {}
+
+        /**
+         * Constructor. Builds the perfect hash; duplicate instruments are dropped.
+         * @param instruments_ instruments in id order.
+         */
+        explicit SymbolTable(const vector<Instrument>& instruments_) {
+            set<tuple<string, string, MarketType>> seen;
+            for (const Instrument& instrument : instruments_) {
+                string exchange = instrument.exchange;
+                transform(exchange.begin(), exchange.end(), exchange.begin(), ::tolower);
+                if (seen.insert({exchange, instrument.symbol, instrument.market_type}).second) {
+                    instruments.push_back(instrument);
+                }
+            }
+
+            if (instruments.size() >= UINT16_MAX) {
+                throw runtime_error("Too many instruments in symbol table");
+                return;
+            }
+
+            size_t num_slots = 2;
+            while (num_slots < 2 * instruments.size()) {
+                num_slots <<= 1;
+            }
+            while (!build(num_slots)) {
+                num_slots <<= 1;
+            }
+        }
+
+        /**
+         * Finds the id of an instrument.
+         * @return id, or SYMBOL_NOT_FOUND.
+         */
+        int find(string_view exchange, string_view symbol, MarketType market_type) const {
+            uint64_t hash = hashKey(exchange, symbol, market_type);
+            uint16_t id = slots[slotOf(hash, displacements[bucketOf(hash)])];
+            if (id == EMPTY_SLOT) {
+                return SYMBOL_NOT_FOUND;
+            }
+
+            const Instrument& candidate = instruments[id];
+            bool same = candidate.market_type == market_type && candidate.symbol == symbol && candidate.exchange.size() == exchange.size()
+                    && equal(exchange.begin(), exchange.end(), candidate.exchange.begin(), [](char a, char b) {return toLower(a) == toLower(b);});
+            return same ? id : SYMBOL_NOT_FOUND;
+        }
+
+        /**
+         * Getter for the instrument with given id.
+         */
+        const Instrument& at(uint16_t id) const {return instruments.at(id);}
+
+        /**
+         * Getter for number of instruments.
+         */
+        size_t size() const {return instruments.size();}
+
+    private:
+        static constexpr uint16_t EMPTY_SLOT = UINT16_MAX;      /*< Slot without instrument; ids stay below it */
+        static constexpr uint32_t MAX_DISPLACEMENT = 1 << 16;   /*< Tries per bucket before growing the slot array */
+
+        /**
+         * Helper function lowercasing an ASCII character without locale lookups.
+         */
+        static char toLower(char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+        }
+
+        /**
+         * Helper function mixing the bits of a hash (splitmix64 finalizer).
+         */
+        static uint64_t mix(uint64_t hash) {
+            hash ^= hash >> 30;
+            hash *= 0xbf58476d1ce4e5b9ULL;
+            hash ^= hash >> 27;
+            hash *= 0x94d049bb133111ebULL;
+            return hash ^ (hash >> 31);
+        }
+
+        /**
+         * Helper function hashing an instrument key (FNV-1a over the lowercased exchange, the symbol and the market type).
+         */
+        static uint64_t hashKey(string_view exchange, string_view symbol, MarketType market_type) {
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for (char c : exchange) {
+                hash = (hash ^ static_cast<uint8_t>(toLower(c))) * 0x100000001b3ULL;
+            }
+            hash = (hash ^ 0xff) * 0x100000001b3ULL;    // Separator, so ("ab", "c") and ("a", "bc") differ
+            for (char c : symbol) {
+                hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+            }
+            return mix(hash ^ static_cast<uint64_t>(market_type));
+        }
+
+        /**
+         * Helper function selecting the bucket of a hash.
+         */
+        size_t bucketOf(uint64_t hash) const {
+            return (hash >> 32) & (displacements.size() - 1);
+        }
+
+        /**
+         * Helper function selecting the slot of a hash for a displacement.
+         */
+        size_t slotOf(uint64_t hash, uint32_t displacement) const {
+            return mix(hash + displacement * 0x9e3779b97f4a7c15ULL) & (slots.size() - 1);
+        }
+
+        /**
+         * Helper function placing all instruments into num_slots slots.
+         * @return false if some bucket found no free displacement.
+         */
+        bool build(size_t num_slots) {
+            size_t num_buckets = 1;
+            while (2 * num_buckets < instruments.size()) {
+                num_buckets <<= 1;
+            }
+            displacements.assign(num_buckets, 0);
+            slots.assign(num_slots, EMPTY_SLOT);
+
+            vector<uint64_t> hashes(instruments.size());
+            vector<vector<uint16_t>> buckets(num_buckets);
+            for (size_t id = 0; id < instruments.size(); ++id) {
+                const Instrument& instrument = instruments[id];
+                hashes[id] = hashKey(instrument.exchange, instrument.symbol, instrument.market_type);
+                buckets[bucketOf(hashes[id])].push_back(static_cast<uint16_t>(id));
+            }
+
+            // Largest buckets first, while most slots are still free
+            vector<size_t> order(num_buckets);
+            for (size_t i = 0; i < num_buckets; ++i) {
+                order[i] = i;
+            }
+            stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {return buckets[a].size() > buckets[b].size();});
+
+            vector<size_t> placed;
+            for (size_t bucket : order) {
+                if (buckets[bucket].empty()) {
+                    break;
+                }
+
+                uint32_t displacement = 0;
+                for (; displacement < MAX_DISPLACEMENT; ++displacement) {
+                    placed.clear();
+                    for (uint16_t id : buckets[bucket]) {
+                        size_t slot = slotOf(hashes[id], displacement);
+                        if (slots[slot] != EMPTY_SLOT || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+                            break;
+                        }
+                        placed.push_back(slot);
+                    }
+                    if (placed.size() == buckets[bucket].size()) {
+                        break;
+                    }
+                }
+                if (displacement == MAX_DISPLACEMENT) {
+                    return false;
+                }
+
+                displacements[bucket] = displacement;
+                for (size_t i = 0; i < placed.size(); ++i) {
+                    slots[placed[i]] = buckets[bucket][i];
+                }
+            }
+            return true;
+        }
+
+        vector<Instrument> instruments;     /*< Instruments indexed by id */
+        vector<uint32_t> displacements;     /*< Displacement of each bucket */
+        vector<uint16_t> slots;             /*< Id of the instrument in each slot, or EMPTY_SLOT */
+};
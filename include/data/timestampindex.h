@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./filestamp.h"
+#include "./timetype.h"
+#include "./tokenizer.h"
+
+using namespace std;
+
+
+/**
+ * Sparse timestamp index format.
+ *
+ * Layout:
+ *  1. TimestampIndexHeader (64 bytes)
+ *  2. num_entries TimestampIndexEntry records (16 bytes each), ordered by file offset
+ *
+ * Stored next to the CSV file as '<Market Data Path>.index', or in the cache directory when one is set, and rebuilt
+ * when the size or last write time of the CSV file changes. All integers are stored in host byte order like the event
+ * store; an index written on a machine of the other byte order fails the version check and is rebuilt.
+ */
+constexpr char TIMESTAMP_INDEX_MAGIC[8] = {'C', 'P', 'T', 'S', 'I', 'N', 'D', 'X'};
+constexpr uint32_t TIMESTAMP_INDEX_VERSION = 1;
+constexpr const char* TIMESTAMP_INDEX_EXTENSION = ".index";
+
+/**
+ * Default number of rows between two index entries.
+ */
+constexpr uint64_t TIMESTAMP_INDEX_ROW_INTERVAL = 4096;
+
+/**
+ * Default maximum time between two index entries in nanoseconds, for sparse stretches of the file.
+ */
+constexpr int64_t TIMESTAMP_INDEX_TIME_INTERVAL = 1'000'000'000;
+
+/**
+ * Header of a timestamp index file.
+ */
+struct TimestampIndexHeader {
+    char magic[8];                  /*< TIMESTAMP_INDEX_MAGIC */
+    uint32_t version;               /*< TIMESTAMP_INDEX_VERSION */
+    uint32_t entry_size;            /*< sizeof(TimestampIndexEntry) */
+    uint64_t num_entries;           /*< Number of entries */
+    uint64_t row_interval;          /*< Rows between two entries */
+    int64_t time_interval;          /*< Maximum nanoseconds between two entries */
+    uint64_t source_size;           /*< Size of the CSV file in bytes */
+    int64_t source_mtime;           /*< Last write time of the CSV file */
+    uint64_t reserved;              /*< Always zero */
+};
+
+static_assert(sizeof(TimestampIndexHeader) == 64, "TimestampIndexHeader must stay a 64 byte header");
+
+/**
+ * Index entry: COLLECTION_TIME of a row and the byte offset of the row in the CSV file.
+ */
+struct TimestampIndexEntry {
+    int64_t timestamp;
+    uint64_t offset;
+};
+
+
+/**
+ * Sparse index from timestamps to byte offsets of a time-ordered market data CSV file.
+ * An entry is recorded every row_interval rows, or earlier once time_interval has passed since the previous entry,
+ * so seeking reads at most row_interval rows before the requested time.
+ */
+class TimestampIndex {
+    public:
+        /**
+         * Builds the index by scanning the rows of a file.
+         * @param file contents of the CSV file.
+         * @param rows_offset byte offset of the first row after the header.
+         * @param row_interval rows between two entries.
+         * @param time_interval maximum nanoseconds between two entries.
+         */
+        static TimestampIndex build(string_view file, size_t rows_offset, uint64_t row_interval = TIMESTAMP_INDEX_ROW_INTERVAL,
+                int64_t time_interval = TIMESTAMP_INDEX_TIME_INTERVAL) {
+            TimestampIndex index;
+            index.row_interval = row_interval;
+            index.time_interval = time_interval;
+
+            CsvTokenizer tokenizer(file.data() + rows_offset, file.data() + file.size());
+            array<string_view, 1> tokens;
+            uint64_t rows_since_entry = row_interval;
+            const char* row_start = tokenizer.getCursor();
+
+            while (tokenizer.nextRow(tokens)) {
+                long long timestamp = parseTimestamp(tokens[0]);
+                if (rows_since_entry >= row_interval || timestamp - index.entries.back().timestamp >= time_interval) {
+                    // Blank lines before the row are included, which is harmless
+                    index.entries.push_back({timestamp, static_cast<uint64_t>(row_start - file.data())});
+                    rows_since_entry = 0;
+                }
+                ++rows_since_entry;
+                row_start = tokenizer.getCursor();
+            }
+
+            return index;
+        }
+
+        /**
+         * Loads an index file.
+         * @param index_path path of the index file.
+         * @param source_stamp stamp the CSV file has now.
+         * @param index loaded index.
+         * @return false if the file is missing, invalid or was built from a different version of the CSV file.
+         */
+        static bool load(const string& index_path, const FileStamp& source_stamp, TimestampIndex& index) {
+            ifstream file(index_path, ios::binary);
+            TimestampIndexHeader header{};
+            if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+                return false;
+            }
+            if (memcmp(header.magic, TIMESTAMP_INDEX_MAGIC, sizeof(header.magic)) != 0 || header.version != TIMESTAMP_INDEX_VERSION
+                    || header.entry_size != sizeof(TimestampIndexEntry) || header.source_size != source_stamp.size
+                    || header.source_mtime != source_stamp.mtime || header.num_entries > source_stamp.size) {
+                return false;
+            }
+
+            index.row_interval = header.row_interval;
+            index.time_interval = header.time_interval;
+            index.entries.resize(header.num_entries);
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(index.entries.data()), header.num_entries * sizeof(TimestampIndexEntry)));
+        }
+
+        /**
+         * Writes the index to a file, through a temporary file renamed into place.
+         * @param index_path path of the index file.
+         * @param source_stamp stamp of the CSV file the index was built from.
+         */
+        void save(const string& index_path, const FileStamp& source_stamp) const {
+            TimestampIndexHeader header{};
+            memcpy(header.magic, TIMESTAMP_INDEX_MAGIC, sizeof(header.magic));
+            header.version = TIMESTAMP_INDEX_VERSION;
+            header.entry_size = sizeof(TimestampIndexEntry);
+            header.num_entries = entries.size();
+            header.row_interval = row_interval;
+            header.time_interval = time_interval;
+            header.source_size = source_stamp.size;
+            header.source_mtime = source_stamp.mtime;
+
+            string temp_path = index_path + ".tmp";
+            FILE* file = fopen(temp_path.c_str(), "wb");
+            if (!file) {
+                throw runtime_error("Error opening " + temp_path + " for writing");
+                return;
+            }
+            fwrite(&header, sizeof(header), 1, file);
+            fwrite(entries.data(), sizeof(TimestampIndexEntry), entries.size(), file);
+
+            bool failed = ferror(file) != 0;
+            failed |= fclose(file) != 0;
+            if (failed || rename(temp_path.c_str(), index_path.c_str()) != 0) {
+                remove(temp_path.c_str());
+                throw runtime_error("Error writing " + index_path);
+            }
+        }
+
+        /**
+         * Finds where to start reading to see every row at or after a timestamp.
+         * @param timestamp nanoseconds since epoch.
+         * @param rows_offset byte offset of the first row, returned if the timestamp is not after any entry.
+         * @return byte offset of the last indexed row before the timestamp.
+         */
+        uint64_t findOffset(long long timestamp, uint64_t rows_offset) const {
+            auto after = lower_bound(entries.begin(), entries.end(), timestamp, [](const TimestampIndexEntry& entry, long long value) {
+                return entry.timestamp < value;
+            });
+            return after == entries.begin() ? rows_offset : prev(after)->offset;
+        }
+
+        /**
+         * Getter for the entries.
+         */
+        const vector<TimestampIndexEntry>& getEntries() const {return entries;}
+
+    private:
+        vector<TimestampIndexEntry> entries;                    /*< Entries ordered by offset */
+        uint64_t row_interval = TIMESTAMP_INDEX_ROW_INTERVAL;   /*< Rows between two entries */
+        int64_t time_interval = TIMESTAMP_INDEX_TIME_INTERVAL;  /*< Maximum nanoseconds between two entries */
+};
+
+
+/**
+ * Path of the timestamp index of a CSV file.
+ * @param csv_path file path for market data input.
+ * @param cache_directory directory holding cached indexes; if empty, the index is placed next to the CSV file.
+ */
+inline string getTimestampIndexPath(const string& csv_path, const string& cache_directory) {
+    if (cache_directory.empty()) {
+        return csv_path + TIMESTAMP_INDEX_EXTENSION;
+    }
+
+    // Key the file name by the absolute path so equally named files in different directories do not collide
+    ostringstream name;
+    name << std::filesystem::path(csv_path).filename().string() << "." << hex << std::hash<string>{}(std::filesystem::absolute(csv_path).string())
+            << TIMESTAMP_INDEX_EXTENSION;
+    return (std::filesystem::path(cache_directory) / name.str()).string();
+}
+
+/**
+ * Loads the index of a CSV file, building and saving it first if it is missing or stale.
+ * If the index cannot be written (e.g. read-only directory), the built index is used without saving it.
+ * @param csv_path file path for market data input.
+ * @param cache_directory directory holding cached indexes; if empty, the index is placed next to the CSV file.
+ * @param file contents of the CSV file.
+ * @param rows_offset byte offset of the first row after the header.
+ */
+inline TimestampIndex openTimestampIndex(const string& csv_path, const string& cache_directory, string_view file, size_t rows_offset) {
+    string index_path = getTimestampIndexPath(csv_path, cache_directory);
+    FileStamp stamp = FileStamp::of(csv_path);
+
+    TimestampIndex index;
+    if (TimestampIndex::load(index_path, stamp, index)) {
+        return index;
+    }
+
+    index = TimestampIndex::build(file, rows_offset);
+    try {
+        if (!cache_directory.empty()) {
+            std::filesystem::create_directories(cache_directory);
+        }
+        index.save(index_path, stamp);
+    } catch (const exception&) {
+        // Not writable; keep the index in memory only
+    }
+    return index;
+}
@@ -2,9 +2,83 @@
 
 #include <iomanip>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/**
+ * Computes the number of days from 1970-01-01 to a proleptic Gregorian date.
+ * Constant time algorithm by Howard Hinnant.
+ */
+inline long long daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    const long long era = (y >= 0 ? y : y - 399) / 400;
+    const long long yoe = y - era * 400;                                    // [0, 399]
+    const long long doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;  // [0, 365]
+    const long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;            // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * Converts the number of days from 1970-01-01 back to a proleptic Gregorian date.
+ */
+inline void civilFromDays(long long days, int& y, int& m, int& d) {
+    days += 719468;
+    const long long era = (days >= 0 ? days : days - 146096) / 146097;
+    const long long doe = days - era * 146097;                                      // [0, 146096]
+    const long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;    // [0, 399]
+    const long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                  // [0, 365]
+    const long long mp = (5 * doy + 2) / 153;                                       // [0, 11]
+    d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    y = static_cast<int>(yoe + era * 400 + (m <= 2));
+}
+
+/**
+ * Parses a timestamp in format 'yyyy-mm-dd HH:MM:SS.fffffffff' into nanoseconds since epoch.
+ * Every field sits at a fixed position, so no stream or allocation is involved.
+ * The fractional part may have fewer than 9 digits or be omitted.
+ * @param timestamp timestamp to parse.
+ * @return nanoseconds since epoch.
+ */
+inline long long parseTimestamp(std::string_view timestamp) {
+    if (timestamp.size() < 19 || timestamp.size() == 20 || timestamp.size() > 29 || timestamp[4] != '-' || timestamp[7] != '-' || timestamp[10] != ' '
+            || timestamp[13] != ':' || timestamp[16] != ':' || (timestamp.size() > 19 && timestamp[19] != '.')) {
+        throw std::invalid_argument("Invalid timestamp '" + std::string(timestamp) + "'");
+        return 0;
+    }
+
+    auto digits = [timestamp](size_t pos, size_t count) {
+        long long value = 0;
+        for (size_t i = pos; i < pos + count; ++i) {
+            unsigned digit = static_cast<unsigned>(timestamp[i] - '0');
+            if (digit > 9) {
+                throw std::invalid_argument("Invalid timestamp '" + std::string(timestamp) + "'");
+            }
+            value = value * 10 + digit;
+        }
+        return value;
+    };
+
+    long long days = daysFromCivil(static_cast<int>(digits(0, 4)), static_cast<int>(digits(5, 2)), static_cast<int>(digits(8, 2)));
+    long long seconds = days * 86400 + digits(11, 2) * 3600 + digits(14, 2) * 60 + digits(17, 2);
+
+    long long subsecond = 0;
+    if (timestamp.size() > 20) {
+        size_t num_digits = timestamp.size() - 20;
+        subsecond = digits(20, num_digits);
+        for (size_t i = num_digits; i < 9; ++i) {
+            subsecond *= 10;
+        }
+    }
+
+    return seconds * 1'000'000'000 + subsecond;
+}
+
 
 /**
  * Struct for recording timestamps
+ * Broken-down form of a nanoseconds-since-epoch timestamp; only used to format timestamps for output.
  */
 struct TimeType {
     int year;
@@ -18,11 +92,30 @@ struct TimeType {
     /**
      * Constructor
      */
-    TimeType(const std::string& timestampStr) {
-        std::istringstream iss(timestampStr);
-        char delimiter;
-        iss >> year >> delimiter >> month >> delimiter >> day >> hour >> delimiter >>
-            minute >> delimiter >> second >> delimiter >> subsecond;
+    TimeType(std::string_view timestampStr): TimeType(parseTimestamp(timestampStr)) {}
+
+    /**
+     * Constructor from nanoseconds since epoch
+     */
+    TimeType(long long nanoseconds_since_epoch) {
+        long long total_seconds = nanoseconds_since_epoch / 1'000'000'000;
+        subsecond = static_cast<int>(nanoseconds_since_epoch % 1'000'000'000);
+        if (subsecond < 0) {
+            subsecond += 1'000'000'000;
+            --total_seconds;
+        }
+
+        long long days = total_seconds / 86400;
+        long long seconds_of_day = total_seconds % 86400;
+        if (seconds_of_day < 0) {
+            seconds_of_day += 86400;
+            --days;
+        }
+
+        civilFromDays(days, year, month, day);
+        hour = static_cast<int>(seconds_of_day / 3600);
+        minute = static_cast<int>(seconds_of_day % 3600 / 60);
+        second = static_cast<int>(seconds_of_day % 60);
     }
 
     /**
@@ -45,33 +138,17 @@ struct TimeType {
      * Return nanoseconds time
      */
     long long toNanosecondsSinceEpoch() const {
-        // Calculate total seconds since epoch
-        const int epochYear = 1970;
-        long long totalSeconds = 0;
-        for (int y = epochYear; y < year; ++y) {
-            totalSeconds += isLeapYear(y) ? 366 * 24 * 60 * 60 : 365 * 24 * 60 * 60;
-        }
-        totalSeconds += calculateSecondsInYear();
+        long long totalSeconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
 
         // Convert to nanoseconds
         long long totalNanoseconds = totalSeconds * 1'000'000'000 + subsecond;
         return totalNanoseconds;
     }
+};
 
-    /**
-     * Helper function to calculate leap year
-     */
-    bool isLeapYear(int y) const {
-        return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
-    }
-
-    /**
-     * Helper function to calculate seconds in the current year
-     */
-    long long calculateSecondsInYear() const {
-        // Assuming all months have 30 days for simplicity
-        const int daysInMonth = 30;
-        long long totalDays = (month - 1) * daysInMonth + day - 1;
-        return totalDays * 24 * 60 * 60 + hour * 60 * 60 + minute * 60 + second;
-    }
-};
\ No newline at end of file
+/**
+ * Formats nanoseconds since epoch as 'yyyy-mm-dd HH:MM:SS.fffffffff'.
+ */
+inline std::string formatTimestamp(long long nanoseconds_since_epoch) {
+    return TimeType(nanoseconds_since_epoch).toString();
+}
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRYPTOPULSE_X86 1
+#endif
+
+using namespace std;
+
+
+/**
+ * Enumeration class for instruction sets the CSV tokenizer can use.
+ */
+enum class SimdLevel {
+    Scalar,     /*< Portable byte-by-byte scan */
+    SSE,        /*< 16 byte compares, four per 64 byte block */
+    AVX2        /*< 32 byte compares, two per 64 byte block */
+};
+
+/**
+ * Detects the best instruction set supported by the running CPU.
+ */
+inline SimdLevel detectSimdLevel() {
+#ifdef CRYPTOPULSE_X86
+    static const SimdLevel level = __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : (__builtin_cpu_supports("sse4.2") ? SimdLevel::SSE : SimdLevel::Scalar);
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+/**
+ * Helper function computing the bitmask of ',' and '\n' bytes of a 64 byte block, one bit per byte.
+ */
+inline uint64_t structuralMaskScalar(const char* block, size_t length) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < length; ++i) {
+        mask |= static_cast<uint64_t>(block[i] == ',' || block[i] == '\n') << i;
+    }
+    return mask;
+}
+
+#ifdef CRYPTOPULSE_X86
+/**
+ * SSE version of structuralMaskScalar for full 64 byte blocks.
+ */
+__attribute__((target("sse4.2"))) inline uint64_t structuralMaskSSE(const char* block) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, newline));
+        mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(hits))) << (16 * i);
+    }
+    return mask;
+}
+
+/**
+ * AVX2 version of structuralMaskScalar for full 64 byte blocks.
+ */
+__attribute__((target("avx2"))) inline uint64_t structuralMaskAVX2(const char* block) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    uint32_t low_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(low, comma), _mm256_cmpeq_epi8(low, newline))));
+    uint32_t high_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(high, comma), _mm256_cmpeq_epi8(high, newline))));
+    return static_cast<uint64_t>(low_mask) | (static_cast<uint64_t>(high_mask) << 32);
+}
+#endif
+
+
+/**
+ * Tokenizer splitting CSV rows into fields.
+ * The buffer is scanned in 64 byte blocks; each block is turned into a bitmask of delimiter and newline positions
+ * with vector compares, and fields are cut at the set bits. Bytes are only looked at one by one in the last partial
+ * block or when no vector instructions are available.
+ */
+class CsvTokenizer {
+    public:
+        /**
+         * Constructor
+         * @param begin_ start of the buffer.
+         * @param end_ end of the buffer.
+         * @param level_ instruction set to use.
+         */
+        CsvTokenizer(const char* begin_, const char* end_, SimdLevel level_ = detectSimdLevel()): cursor(begin_), end(end_), level(level_) {
+            block = begin_;
+            loadBlock();
+        }
+
+        /**
+         * Splits the next non-empty row into fields.
+         * Missing trailing fields are left empty, extra fields are ignored, a trailing '\r' is dropped.
+         * @param row array filled with views of the fields of the row.
+         * @return false if there are no more rows.
+         */
+        template <size_t N>
+        bool nextRow(array<string_view, N>& row) {
+            size_t column = 0;
+            const char* field_start = cursor;
+
+            while (true) {
+                while (mask == 0) {
+                    if (end - block <= 64) {
+                        // Last row without line ending
+                        cursor = end;
+                        if (column == 0 && isBlank(field_start, end)) {
+                            return false;
+                        }
+                        finishRow(row, column, field_start, end);
+                        return true;
+                    }
+                    block += 64;
+                    loadBlock();
+                }
+
+                const char* position = block + __builtin_ctzll(mask);
+                mask &= mask - 1;
+
+                if (*position == ',') {
+                    if (column < N) {
+                        row[column] = string_view(field_start, position - field_start);
+                    }
+                    ++column;
+                    field_start = position + 1;
+                } else if (column == 0 && isBlank(field_start, position)) {
+                    field_start = position + 1;     // Skip empty lines
+                } else {
+                    cursor = position + 1;
+                    finishRow(row, column, field_start, position);
+                    return true;
+                }
+            }
+        }
+
+        /**
+         * Getter for start of the next row.
+         */
+        const char* getCursor() const {return cursor;}
+
+    private:
+        /**
+         * Helper function storing the last field of a row and clearing missing ones.
+         */
+        template <size_t N>
+        static void finishRow(array<string_view, N>& row, size_t column, const char* field_start, const char* line_end) {
+            if (line_end > field_start && *(line_end - 1) == '\r') {
+                --line_end;
+            }
+            if (column < N) {
+                row[column++] = string_view(field_start, line_end - field_start);
+            }
+            for (; column < N; ++column) {
+                row[column] = string_view();
+            }
+        }
+
+        /**
+         * Helper function checking whether a line is empty apart from '\r'.
+         */
+        static bool isBlank(const char* begin, const char* end) {
+            return begin == end || (end - begin == 1 && *begin == '\r');
+        }
+
+        /**
+         * Helper function computing the mask of the block starting at block.
+         */
+        void loadBlock() {
+            size_t length = static_cast<size_t>(end - block);
+            if (length < 64) {
+                mask = structuralMaskScalar(block, length);
+                return;
+            }
+
+            switch (level) {
+#ifdef CRYPTOPULSE_X86
+                case SimdLevel::AVX2:
+                    mask = structuralMaskAVX2(block);
+                    break;
+                case SimdLevel::SSE:
+                    mask = structuralMaskSSE(block);
+                    break;
+#endif
+                default:
+                    mask = structuralMaskScalar(block, 64);
+                    break;
+            }
+        }
+
+        const char* cursor;     /*< Start of the next row */
+        const char* end;        /*< End of the buffer */
+        const char* block;      /*< Start of the current 64 byte block */
+        uint64_t mask = 0;      /*< Delimiters and newlines of the current block not consumed yet */
+        SimdLevel level;        /*< Instruction set used for full blocks */
+};
+
+
+/**
+ * Powers of ten exactly representable as double.
+ */
+constexpr double EXACT_POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/**
+ * Helper function checking whether 8 bytes are all ASCII digits.
+ */
+inline bool isEightDigits(uint64_t chunk) {
+    return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+/**
+ * Helper function converting 8 ASCII digits (little endian load) to their value without a loop.
+ */
+inline uint32_t parseEightDigits(uint64_t chunk) {
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return static_cast<uint32_t>(chunk);
+}
+
+/**
+ * Parses a plain decimal number such as "16800.01" or "-0.5".
+ * Digits are accumulated into an integer, eight at a time where possible, and scaled by one exact power of ten.
+ * When the integer fits in 53 bits this single division is correctly rounded, so the result is bit-identical to
+ * strtod/from_chars; anything else (exponents, long mantissas) is handed to from_chars.
+ * @param field field to convert.
+ * @param value converted value.
+ * @return false if the field is not a number.
+ */
+inline bool parseDecimal(string_view field, double& value) {
+    const char* p = field.data();
+    const char* end = p + field.size();
+    bool negative = p < end && *p == '-';
+    p += negative;
+
+    uint64_t mantissa = 0;
+    int num_digits = 0;
+    int fraction_digits = -1;   // -1 until the decimal point is seen
+
+    while (p < end) {
+        uint64_t chunk;
+        if (end - p >= 8 && (memcpy(&chunk, p, 8), isEightDigits(chunk))) {
+            mantissa = mantissa * 100000000 + parseEightDigits(chunk);
+            num_digits += 8;
+            fraction_digits += (fraction_digits >= 0) * 8;
+            p += 8;
+            continue;
+        }
+
+        unsigned digit = static_cast<unsigned>(*p - '0');
+        if (digit <= 9) {
+            mantissa = mantissa * 10 + digit;
+            ++num_digits;
+            fraction_digits += fraction_digits >= 0;
+        } else if (*p == '.' && fraction_digits < 0) {
+            fraction_digits = 0;
+        } else {
+            num_digits = 0;     // Not a plain decimal
+            break;
+        }
+        ++p;
+    }
+
+    if (num_digits == 0 || num_digits > 19 || mantissa > (1ULL << 53) || fraction_digits > 22) {
+        auto result = from_chars(field.data(), field.data() + field.size(), value);
+        return result.ec == errc() && result.ptr == field.data() + field.size();
+    }
+
+    value = static_cast<double>(mantissa);
+    if (fraction_digits > 0) {
+        value /= EXACT_POWERS_OF_TEN[fraction_digits];
+    }
+    value = negative ? -value : value;
+    return true;
+}
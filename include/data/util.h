@@ -6,7 +6,7 @@
 
 using namespace std;
 
-double round(double num, int digits) {
+inline double round(double num, int digits) {
     double multiplier = std::pow(10.0, digits);
     return std::round(num * multiplier) / multiplier;
 }
@@ -27,7 +27,7 @@ enum class OrderState {
 /**
  * << operator overload for OrderState class.
  */
-ostream& operator<<(ostream& os, const OrderState& state) {
+inline ostream& operator<<(ostream& os, const OrderState& state) {
     switch (static_cast<int>(state)) {
         case static_cast<int>(OrderState::SentToExchange):
             os << "Sent to Exchange";
@@ -64,7 +64,7 @@ enum class MarketType {
 /**
  * << operator overload for MarketType class.
  */
-ostream& operator<<(ostream& os, const MarketType& market_type) {
+inline ostream& operator<<(ostream& os, const MarketType& market_type) {
     switch (static_cast<int>(market_type)) {
         case static_cast<int>(MarketType::Spot):
             os << "Spot";
@@ -109,7 +109,7 @@ enum class MarginType {
 /**
  * << operator overload for OrderState class.
  */
-ostream& operator<<(ostream& os, const MarginType& margin_type) {
+inline ostream& operator<<(ostream& os, const MarginType& margin_type) {
     switch (static_cast<int>(margin_type)) {
         case static_cast<int>(MarginType::NoMargin):
             os << "No Margin";
@@ -47,14 +47,14 @@ class TradeLog {
     /**
      * Getter for balance history
      */
-    vector<pair<std::shared_ptr<TimeType>, pair<double, double>>> getBalanceHistory() const {
+    vector<pair<long long, pair<double, double>>> getBalanceHistory() const {
         return balance_history;
     }
 
     /**
      * Add to balance history
      */
-    void addBalanceHistory(std::shared_ptr<TimeType> tt, double spot_bal, double futures_bal) {
+    void addBalanceHistory(long long tt, double spot_bal, double futures_bal) {
         balance_history.emplace_back(make_pair(tt, make_pair(spot_bal, futures_bal)));
     }
 
@@ -114,7 +114,7 @@ class TradeLog {
         if (outfile) {
             outfile << "TIMESTAMP,SPOT_BALANCE,FUTURES_BALANCE" << "\n";
             for (const auto& it : balance_history) {
-                outfile << it.first->toString() << "," << it.second.first << "," << it.second.second << "\n";
+                outfile << formatTimestamp(it.first) << "," << it.second.first << "," << it.second.second << "\n";
             }
             outfile.close();
             std::cout << "Data exported to " << filename << std::endl;
@@ -134,7 +134,7 @@ class TradeLog {
             outfile << "TIMESTAMP,SECURITY,MARKET_TYPE,EXCHANGE,SIDE,SIZE,FEE" << "\n";
             for (const auto& it : trades) {
                 string s = (it->getSide() == 1) ? "Buy" : "sell";
-                outfile << it->getTimestamp()->toString() << "," << *(it->getSecurity()) << "," << it->getParentOrder()->getMarketType() << "," << it->getExchange()->getName() 
+                outfile << formatTimestamp(it->getTimestamp()) << "," << *(it->getSecurity()) << "," << it->getParentOrder()->getMarketType() << "," << it->getExchange()->getName() 
                         << "," << s << "," << it->getBaseCurrencySize() << "," << it->getFee() << "\n";
             }
             outfile.close();
@@ -147,5 +147,5 @@ class TradeLog {
 
 private:
     vector<std::shared_ptr<Trade>> trades;      /*< Vector of pointers to trades */
-    vector<pair<std::shared_ptr<TimeType>, pair<double, double>>> balance_history;      /*< Vector recording real time balance */
+    vector<pair<long long, pair<double, double>>> balance_history;      /*< Vector recording real time balance; timestamps in nanoseconds since epoch */
 };
\ No newline at end of file
@@ -0,0 +1,16 @@
+#!/bin/bash
+
+if [ $# -ne 1 ]; then
+    echo "Usage: $0 <Market Data Path>"
+    exit 1
+fi
+
+arg1="$1"
+
+make benchmark
+
+if [ $? -eq 0 ]; then
+    ./build/benchmark "$arg1"
+else
+    echo "Compilation failed. Please check your code."
+fi
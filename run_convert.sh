@@ -0,0 +1,17 @@
+#!/bin/bash
+
+if [ $# -ne 2 ]; then
+    echo "Usage: $0 <Market Data Path> <Event Store Path>"
+    exit 1
+fi
+
+arg1="$1"
+arg2="$2"
+
+g++ -std=c++20 -O2 ./src/convert.cpp -o convert_executable -pthread -lz
+
+if [ $? -eq 0 ]; then
+    ./convert_executable "$arg1" "$arg2"
+else
+    echo "Compilation failed. Please check your code."
+fi
@@ -10,7 +10,7 @@ arg2="$2"
 arg3="$3"
 arg4="$4"
 
-g++ -std=c++20 -I./boost_1_84_0 ./src/latency_analysis.cpp -o latency_executable
+g++ -std=c++20 -I./boost_1_84_0 ./src/latency_analysis.cpp -o latency_executable -pthread -lz
 
 if [ $? -eq 0 ]; then
     ./latency_executable "$arg1" "$arg2" "$arg3" "$arg4"
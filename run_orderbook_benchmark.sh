@@ -0,0 +1,17 @@
+#!/bin/bash
+
+if [ $# -ne 2 ]; then
+    echo "Usage: $0 <Configuration Path> <Market Data Path>"
+    exit 1
+fi
+
+arg1="$1"
+arg2="$2"
+
+make orderbook_benchmark
+
+if [ $? -eq 0 ]; then
+    ./build/orderbook_benchmark "$arg1" "$arg2"
+else
+    echo "Compilation failed. Please check your code."
+fi
@@ -11,8 +11,8 @@
 using namespace std;
 
 int main(int argc, char* argv[]) {
-    if (argc != 5) {
-        cerr << "Usage: " << argv[0] << "<Initial Spot Balance> <Initial Futures Balance> <Configuration Path> <Market Data Path>\n";
+    if (argc != 5 && argc != 7) {
+        cerr << "Usage: " << argv[0] << "<Initial Spot Balance> <Initial Futures Balance> <Configuration Path> <Market Data Path> [<Start Time> <End Time>]\n";
     }
 
     User user(stod(argv[1]), stod(argv[2]), argv[3]);
@@ -20,7 +20,12 @@ int main(int argc, char* argv[]) {
     MovingAverageCross ma_cross(user, 180, 5, 20); /*< Your straetgy class constructor */
 
     Backtester backtester(user, &ma_cross); /*< Replace "&ma_cross" with your strategy instance*/
-    backtester.runBacktest(argv[4]);
+    backtester.setPipelined(true); /*< Read market data on a separate thread */
+    if (argc == 7) {
+        backtester.runBacktest(argv[4], parseTimestamp(argv[5]), parseTimestamp(argv[6])); /*< Times as 'yyyy-mm-dd HH:MM:SS' */
+    } else {
+        backtester.runBacktest(argv[4]);
+    }
     backtester.getTradeLog().exportBalanceHistoryToCSV("./sample_data/sample_result.csv");
     backtester.getTradeLog().exportTradeLogToCSV("./sample_data/sample_tradelog.csv");
 
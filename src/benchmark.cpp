@@ -0,0 +1,220 @@
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+
+#include "../include/data/eventstore.h"
+#include "../include/data/marketdata.h"
+#include "../include/data/tokenizer.h"
+
+using namespace std;
+
+
+/**
+ * Ingests the market data with the original path: getline, boost::split and stod on each column.
+ * @param data_path file path for market data input
+ * @param checksum sum of all parsed numbers, so the work cannot be optimized away
+ * @return number of rows read
+ */
+size_t ingestWithGetline(const string& data_path, double& checksum) {
+    ifstream file(data_path);
+    if (!file.is_open()) {
+        throw invalid_argument("Error opening the file");
+    }
+
+    size_t rows = 0;
+    string line;
+    getline(file, line);    // Skip first line
+    while (getline(file, line)) {
+        vector<string> tokens;
+        boost::split(tokens, line, boost::is_any_of(","));
+
+        for (size_t i = 6; i < tokens.size(); ++i) {
+            if (!tokens[i].empty()) {
+                checksum += stod(tokens[i]);
+            }
+        }
+        ++rows;
+    }
+
+    return rows;
+}
+
+/**
+ * Ingests the market data with the memory-mapped reader.
+ * @param data_path file path for market data input
+ * @param checksum sum of all parsed numbers, so the work cannot be optimized away
+ * @return number of rows read
+ */
+size_t ingestWithMappedReader(const string& data_path, double& checksum) {
+    MarketDataReader reader(data_path);
+    MarketDataReader::Row tokens;
+
+    while (reader.nextRow(tokens)) {
+        for (size_t i = 6; i < MARKET_DATA_NUM_COLUMNS; ++i) {
+            if (!tokens[i].empty()) {
+                checksum += parseDouble(tokens[i]);
+            }
+        }
+    }
+
+    return reader.getRowsRead();
+}
+
+/**
+ * Replays the market data from its cached event store, converting it first if needed.
+ * @param data_path file path for market data input
+ * @param checksum sum of all decoded numbers, so the work cannot be optimized away
+ * @return number of events read
+ */
+size_t ingestWithEventStore(const string& data_path, double& checksum) {
+    unique_ptr<EventSource> source = openMarketData(data_path);
+    MarketEvent event;
+    size_t rows = 0;
+
+    while (source->nextEvent(event)) {
+        checksum += event.price + event.size;
+        for (size_t level = 0; level < MARKET_EVENT_NUM_LEVELS; ++level) {
+            checksum += event.bid_price[level] + event.bid_size[level] + event.ask_price[level] + event.ask_size[level];
+        }
+        ++rows;
+    }
+
+    return rows;
+}
+
+/**
+ * Tokenizes and parses a buffer holding the market data with boost::split and stod, as the original reader did.
+ * @param buffer market data without header
+ * @param checksum sum of all parsed numbers, so the work cannot be optimized away
+ * @return number of rows read
+ */
+size_t tokenizeWithSplit(const string& buffer, double& checksum) {
+    size_t rows = 0;
+    vector<string> lines;
+    boost::split(lines, buffer, boost::is_any_of("\n"));
+
+    for (const string& line : lines) {
+        if (line.empty()) {
+            continue;
+        }
+        vector<string> tokens;
+        boost::split(tokens, line, boost::is_any_of(","));
+
+        for (size_t i = 6; i < tokens.size(); ++i) {
+            if (!tokens[i].empty()) {
+                checksum += stod(tokens[i]);
+            }
+        }
+        ++rows;
+    }
+
+    return rows;
+}
+
+/**
+ * Tokenizes and parses a buffer holding the market data with CsvTokenizer.
+ * @param buffer market data without header
+ * @param checksum sum of all parsed numbers, so the work cannot be optimized away
+ * @param level instruction set used by the tokenizer
+ * @param use_from_chars parse numbers with from_chars instead of parseDecimal
+ * @return number of rows read
+ */
+size_t tokenizeWithTokenizer(const string& buffer, double& checksum, SimdLevel level, bool use_from_chars) {
+    CsvTokenizer tokenizer(buffer.data(), buffer.data() + buffer.size(), level);
+    MarketDataReader::Row tokens;
+    size_t rows = 0;
+
+    while (tokenizer.nextRow(tokens)) {
+        for (size_t i = 6; i < MARKET_DATA_NUM_COLUMNS; ++i) {
+            if (tokens[i].empty()) {
+                continue;
+            }
+            double value = 0.0;
+            if (use_from_chars) {
+                from_chars(tokens[i].data(), tokens[i].data() + tokens[i].size(), value);
+            } else {
+                parseDecimal(tokens[i], value);
+            }
+            checksum += value;
+        }
+        ++rows;
+    }
+
+    return rows;
+}
+
+/**
+ * Times an ingest function and prints its throughput.
+ * @param input market data path or buffer handed to the ingest function
+ * @return rows per second
+ */
+template <typename IngestFunction>
+double reportIngestThroughput(const string& name, const string& input, IngestFunction ingest) {
+    double checksum = 0.0;
+    auto start = chrono::steady_clock::now();
+    size_t rows = ingest(input, checksum);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    double rows_per_second = rows / elapsed.count();
+    cout << left << setw(28) << name << right << setw(12) << rows << " rows" << setw(10) << fixed << setprecision(3) << elapsed.count() << " s"
+            << setw(16) << setprecision(0) << rows_per_second << " rows/s" << "   (checksum " << setprecision(2) << checksum << ")" << endl;
+
+    return rows_per_second;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " <Market Data Path>\n";
+        return 1;
+    }
+
+    cout << "========== Ingest Throughput ==========" << endl;
+    double old_rate = reportIngestThroughput("getline + split + stod", argv[1], ingestWithGetline);
+    double new_rate = reportIngestThroughput("mmap + string_view", argv[1], ingestWithMappedReader);
+    cout << "Speedup: " << setprecision(2) << new_rate / old_rate << "x" << endl;
+
+    // The whole file is loaded first, so this section only measures tokenizing and number parsing
+    ifstream file(argv[1], ios::binary);
+    string buffer((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    buffer.erase(0, buffer.find('\n') + 1);    // Skip first line
+
+    cout << "========== Tokenize + Parse (in memory) ==========" << endl;
+    double split_rate = reportIngestThroughput("boost::split + stod", buffer, tokenizeWithSplit);
+    double scalar_rate = reportIngestThroughput("scalar + from_chars", buffer, [](const string& data, double& checksum) {
+        return tokenizeWithTokenizer(data, checksum, SimdLevel::Scalar, true);
+    });
+    double simd_rate = reportIngestThroughput(detectSimdLevel() == SimdLevel::AVX2 ? "avx2 + parseDecimal" : "simd + parseDecimal", buffer, [](const string& data, double& checksum) {
+        return tokenizeWithTokenizer(data, checksum, detectSimdLevel(), false);
+    });
+    cout << "Speedup over split: " << setprecision(2) << simd_rate / split_rate << "x, over scalar: " << simd_rate / scalar_rate << "x" << endl;
+
+    cout << "========== Parallel Conversion ==========" << endl;
+    string converted_path = string(argv[1]) + ".benchmark" + EVENT_STORE_EXTENSION;
+    double single_rate = reportIngestThroughput("convert, 1 thread", argv[1], [&converted_path](const string& data_path, double& checksum) {
+        size_t events = static_cast<size_t>(convertMarketData(data_path, converted_path, 1));
+        checksum += events;
+        return events;
+    });
+    size_t num_threads = max(1u, thread::hardware_concurrency());
+    double parallel_rate = reportIngestThroughput("convert, " + to_string(num_threads) + " thread(s)", argv[1], [&converted_path](const string& data_path, double& checksum) {
+        size_t events = static_cast<size_t>(convertMarketData(data_path, converted_path));
+        checksum += events;
+        return events;
+    });
+    std::filesystem::remove(converted_path);
+    cout << "Speedup: " << setprecision(2) << parallel_rate / single_rate << "x" << endl;
+
+    cout << "========== Event Store Replay ==========" << endl;
+    reportIngestThroughput("first run (convert + replay)", argv[1], [](const string& data_path, double& checksum) {
+        std::filesystem::remove(getEventStoreCachePath(data_path, ""));
+        return ingestWithEventStore(data_path, checksum);
+    });
+    double cached_rate = reportIngestThroughput("cached event store", argv[1], ingestWithEventStore);
+    cout << "Speedup: " << setprecision(2) << cached_rate / old_rate << "x" << endl;
+}
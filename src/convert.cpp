@@ -0,0 +1,15 @@
+#include <iostream>
+
+#include "../include/data/eventstore.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cerr << "Usage: " << argv[0] << " <Market Data Path> <Event Store Path>\n";
+        return 1;
+    }
+
+    uint64_t num_events = convertMarketData(argv[1], argv[2]);
+    cout << "Converted " << num_events << " events to " << argv[2] << endl;
+}
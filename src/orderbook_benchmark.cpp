@@ -0,0 +1,425 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../include/backtesting/OrderBook.h"
+#include "../include/backtesting/user.h"
+#include "../include/data/eventmerge.h"
+
+using namespace std;
+
+
+/**
+ * Order books of the instruments of a market data file, updated the way the backtester updates them.
+ * @tparam Book order book type, BasicOrderBook of some depth policy.
+ */
+template <typename Book = OrderBook>
+class BookReplay {
+    public:
+        /**
+         * Constructor
+         * @param user_ user holding the exchanges of the configuration.
+         * @param data_path file path for market data input.
+         * @param per_level_quotes_ whether to apply quote rows as one side update per level instead of a snapshot.
+         */
+        BookReplay(User& user_, const string& data_path, bool per_level_quotes_ = false): user(user_), source(openMarketData(data_path, false)), per_level_quotes(per_level_quotes_) {}
+
+        /**
+         * Reads the next event and applies it to the book of its instrument.
+         * @return book the event was applied to, nullptr for events without book, or nullptr with false at the end.
+         */
+        bool next(std::shared_ptr<Book>& book) {
+            if (!source->nextEvent(event)) {
+                return false;
+            }
+
+            book = getBook(event.instrument_id);
+            if (book == nullptr) {
+                return true;
+            }
+
+            switch (event.message_type) {
+                case MessageType::Trade: book->tradeOccurred(event.price, event.size); break;
+                case MessageType::BidUpdate:
+                case MessageType::AskUpdate: applyQuote(*book); break;
+                case MessageType::BuySideUpdate: book->buySideUpdated(event.price, event.size); break;
+                case MessageType::SellSideUpdate: book->sellSideUpdated(event.price, event.size); break;
+                default: book = nullptr; break;
+            }
+            return true;
+        }
+
+        /**
+         * Getter for the message type of the last event read.
+         */
+        MessageType getLastMessageType() const {return event.message_type;}
+
+        /**
+         * Getter for the books created so far.
+         */
+        const vector<std::shared_ptr<Book>>& getBooks() const {return books;}
+
+    private:
+        /**
+         * Helper function applying the levels of a quote row to a book.
+         */
+        void applyQuote(Book& book) {
+            if (!per_level_quotes) {
+                book.applySnapshot(event.bid_price, event.bid_size, event.ask_price, event.ask_size, MARKET_EVENT_NUM_LEVELS);
+                return;
+            }
+            for (size_t level = 0; level < MARKET_EVENT_NUM_LEVELS; ++level) {
+                if (event.bid_price[level] > 0) {
+                    book.buySideUpdated(event.bid_price[level], event.bid_size[level]);
+                }
+                if (event.ask_price[level] > 0) {
+                    book.sellSideUpdated(event.ask_price[level], event.ask_size[level]);
+                }
+            }
+        }
+
+        /**
+         * Helper function finding the book of an instrument, creating it the first time.
+         */
+        std::shared_ptr<Book> getBook(uint16_t instrument_id) {
+            if (instrument_id >= books.size()) {
+                books.resize(source->getInstruments().size());
+                resolved.resize(books.size(), false);
+            }
+            if (!resolved[instrument_id]) {
+                const Instrument& instrument = source->getInstruments().at(instrument_id);
+                std::shared_ptr<Exchange> exchange = user.findExchange(instrument.exchange);
+                std::shared_ptr<Security> security = exchange ? exchange->findSecurity(MarketType::Spot, instrument.symbol) : nullptr;
+                if (security != nullptr) {
+                    books[instrument_id] = make_shared<Book>(exchange, instrument.market_type, security);
+                }
+                resolved[instrument_id] = true;
+            }
+            return books[instrument_id];
+        }
+
+        User& user;
+        unique_ptr<EventSource> source;
+        MarketEvent event;
+        bool per_level_quotes;                          /*< Whether quote rows are applied one level at a time */
+        vector<std::shared_ptr<Book>> books;           /*< Book of each instrument, nullptr if not configured */
+        vector<bool> resolved;                          /*< Whether the book of each instrument was looked up */
+};
+
+
+/**
+ * Replays the depth stream, querying the best bid and ask after every event as the backtester does for each live
+ * order, and counts the levels visited to answer the queries.
+ * A full scan (the map-based book) visits every level of the book per query; the incremental book only visits
+ * levels when the best level disappears and it searches for the next one.
+ * @param user user holding the exchanges of the configuration
+ * @param data_path file path for market data input
+ */
+void reportTopOfBookVisits(User& user, const string& data_path) {
+    BookReplay<> replay(user, data_path);
+    std::shared_ptr<OrderBook> book;
+    uint64_t num_events = 0;
+    uint64_t num_queries = 0;
+    uint64_t scan_visits = 0;
+    double checksum = 0.0;
+
+    auto start = chrono::steady_clock::now();
+    while (replay.next(book)) {
+        ++num_events;
+        if (book == nullptr) {
+            continue;
+        }
+
+        checksum += book->getBestBid() + book->getBestAsk();
+        num_queries += 2;
+        scan_visits += 2 * book->getNumLevels();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    uint64_t incremental_visits = 0;
+    for (const std::shared_ptr<OrderBook>& it : replay.getBooks()) {
+        incremental_visits += it ? it->getNumLevelVisits() : 0;
+    }
+
+    cout << left << setw(28) << "events" << right << setw(16) << num_events << endl;
+    cout << left << setw(28) << "best bid/ask queries" << right << setw(16) << num_queries << endl;
+    cout << left << setw(28) << "level visits, full scan" << right << setw(16) << scan_visits
+            << setw(12) << fixed << setprecision(2) << (num_queries ? static_cast<double>(scan_visits) / num_queries : 0.0) << " per query" << endl;
+    cout << left << setw(28) << "level visits, incremental" << right << setw(16) << incremental_visits
+            << setw(12) << fixed << setprecision(2) << (num_queries ? static_cast<double>(incremental_visits) / num_queries : 0.0) << " per query" << endl;
+    cout << left << setw(28) << "visits removed" << right << setw(15) << setprecision(2)
+            << (scan_visits ? 100.0 * (scan_visits - min(scan_visits, incremental_visits)) / scan_visits : 0.0) << "%" << endl;
+    cout << left << setw(28) << "replay + queries" << right << setw(16) << setprecision(3) << elapsed.count() << " s"
+            << setw(14) << setprecision(0) << num_events / elapsed.count() << " events/s" << "   (checksum " << setprecision(2) << checksum << ")" << endl;
+}
+
+
+/**
+ * Replays the depth stream and counts the levels visited by the crossing sweep of each side update.
+ * Before the book was split by side, every update walked all levels on one side of its price, bounded by the number
+ * of levels in the book; now it only visits the levels of the other side that it crosses.
+ * @param user user holding the exchanges of the configuration
+ * @param data_path file path for market data input
+ */
+void reportCrossingSweepVisits(User& user, const string& data_path) {
+    BookReplay<> replay(user, data_path);
+    std::shared_ptr<OrderBook> book;
+    uint64_t num_updates = 0;
+    uint64_t book_levels = 0;
+
+    auto start = chrono::steady_clock::now();
+    while (replay.next(book)) {
+        if (book != nullptr && replay.getLastMessageType() != MessageType::Trade) {
+            ++num_updates;
+            book_levels += book->getNumLevels();
+        }
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    uint64_t crossed_levels = 0;
+    for (const std::shared_ptr<OrderBook>& it : replay.getBooks()) {
+        crossed_levels += it ? it->getNumCrossedLevels() : 0;
+    }
+
+    cout << left << setw(28) << "side updates" << right << setw(16) << num_updates << endl;
+    cout << left << setw(28) << "book levels (full walk)" << right << setw(16) << book_levels
+            << setw(12) << fixed << setprecision(2) << (num_updates ? static_cast<double>(book_levels) / num_updates : 0.0) << " per update" << endl;
+    cout << left << setw(28) << "levels crossed" << right << setw(16) << crossed_levels
+            << setw(12) << fixed << setprecision(2) << (num_updates ? static_cast<double>(crossed_levels) / num_updates : 0.0) << " per update" << endl;
+    cout << left << setw(28) << "replay" << right << setw(16) << setprecision(3) << elapsed.count() << " s"
+            << setw(14) << setprecision(0) << num_updates / elapsed.count() << " updates/s" << endl;
+}
+
+
+/**
+ * Sweeps a deep synthetic book with market and limit orders and times the sweeps.
+ * Every level of each side holds the same small size, so an order of n times that size walks n levels; the levels
+ * taken are restored by side updates after each sweep, outside the timed section.
+ * @param user user holding the exchanges of the configuration
+ * @param depth number of levels on each side
+ * @param levels_swept number of levels each order walks
+ * @param rounds number of sweeps of each kind
+ */
+void reportDeepSweeps(User& user, int depth, int levels_swept, int rounds) {
+    std::shared_ptr<Exchange> exchange = user.getExchanges().front();
+    std::shared_ptr<Security> security = exchange->getListedSecurities(MarketType::Spot).front();
+    double tick_size = exchange->getTradingRules(MarketType::Spot, *security)[0];
+    double mid = 10000.0;
+    double level_size = 0.001;
+
+    OrderBook book(exchange, MarketType::Spot, security);
+    for (int level = 1; level <= depth; ++level) {
+        book.buySideUpdated(mid - level * tick_size, level_size);
+        book.sellSideUpdated(mid + level * tick_size, level_size);
+    }
+
+    OrderBook::OrderFills fills;
+    cout << left << setw(28) << "book depth" << right << setw(16) << depth << " levels per side" << endl;
+    for (int kind = 0; kind < 4; ++kind) {
+        int side = kind % 2 ? -1 : 1;
+        bool limit = kind >= 2;
+        double size = levels_swept * level_size;
+        double price = mid + side * levels_swept * tick_size;
+        std::shared_ptr<Order> order = limit
+            ? std::shared_ptr<Order>(make_shared<Limit>(security, MarketType::Spot, 0, side, size, 0, 1, MarginType::NoMargin, price, exchange))
+            : std::shared_ptr<Order>(make_shared<Market>(security, MarketType::Spot, 0, side, size, 0, 1, MarginType::NoMargin, price, exchange));
+        order->checkOrderReceived(1LL << 50);
+
+        chrono::duration<double> elapsed(0);
+        double checksum = 0.0;
+        for (int round = 0; round < rounds; ++round) {
+            fills.clear();
+            auto start = chrono::steady_clock::now();
+            if (limit) {
+                book.instantFillLimit(order, size, fills);
+            } else {
+                book.fillMarketOrder(order, fills);
+            }
+            elapsed += chrono::steady_clock::now() - start;
+
+            for (const auto& fill : fills) {
+                checksum += fill.first * fill.second;
+                if (side == 1) {
+                    book.sellSideUpdated(fill.first, level_size);
+                } else {
+                    book.buySideUpdated(fill.first, level_size);
+                }
+            }
+        }
+
+        string name = string(limit ? "limit " : "market ") + (side == 1 ? "buy" : "sell") + " sweeps";
+        cout << left << setw(28) << name << right << setw(16) << setprecision(0) << fixed << 1e9 * elapsed.count() / rounds << " ns"
+                << setw(12) << setprecision(2) << 1e9 * elapsed.count() / rounds / levels_swept << " ns per level"
+                << "   (checksum " << checksum << ")" << endl;
+    }
+}
+
+
+/**
+ * Replays the depth stream into books of one depth policy, querying the best bid and ask after every event, and
+ * reports the levels the books hold and drop.
+ * @tparam DepthPolicy depth policy of the books
+ * @param user user holding the exchanges of the configuration
+ * @param data_path file path for market data input
+ * @param name name of the policy in the report
+ */
+template <typename DepthPolicy>
+void reportDepthPolicy(User& user, const string& data_path, const string& name) {
+    BookReplay<BasicOrderBook<DepthPolicy>> replay(user, data_path);
+    std::shared_ptr<BasicOrderBook<DepthPolicy>> book;
+    uint64_t num_updates = 0;
+    uint64_t book_levels = 0;
+    double checksum = 0.0;
+
+    auto start = chrono::steady_clock::now();
+    while (replay.next(book)) {
+        if (book != nullptr) {
+            ++num_updates;
+            book_levels += book->getNumLevels();
+            checksum += book->getBestBid() + book->getBestAsk();
+        }
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    uint64_t dropped_levels = 0;
+    for (const auto& it : replay.getBooks()) {
+        dropped_levels += it ? it->getNumDroppedLevels() : 0;
+    }
+
+    cout << left << setw(28) << name << right << setw(12) << fixed << setprecision(2)
+            << (num_updates ? static_cast<double>(book_levels) / num_updates : 0.0) << " levels held"
+            << setw(12) << dropped_levels << " dropped"
+            << setw(14) << setprecision(0) << num_updates / elapsed.count() << " events/s"
+            << "   (checksum " << setprecision(2) << checksum << ")" << endl;
+}
+
+
+/**
+ * Replays the market data twice, applying the levels of each quote row as one snapshot and as one side update per
+ * level, and compares the time taken and the levels crossed.
+ * @param user user holding the exchanges of the configuration
+ * @param data_path file path for market data input
+ */
+void reportQuoteSnapshots(User& user, const string& data_path) {
+    for (bool per_level : {false, true}) {
+        BookReplay<> replay(user, data_path, per_level);
+        std::shared_ptr<OrderBook> book;
+        uint64_t num_quotes = 0;
+
+        auto start = chrono::steady_clock::now();
+        while (replay.next(book)) {
+            MessageType type = replay.getLastMessageType();
+            num_quotes += book != nullptr && (type == MessageType::BidUpdate || type == MessageType::AskUpdate);
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        uint64_t crossed_levels = 0;
+        for (const std::shared_ptr<OrderBook>& it : replay.getBooks()) {
+            crossed_levels += it ? it->getNumCrossedLevels() : 0;
+        }
+
+        cout << left << setw(28) << (per_level ? "side update per level" : "snapshot") << right << setw(16) << num_quotes << " quotes"
+                << setw(12) << crossed_levels << " crossed"
+                << setw(12) << fixed << setprecision(3) << elapsed.count() << " s replay" << endl;
+    }
+}
+
+
+/**
+ * Helper function computing the microprice and the depth of the best BOOK_FEATURE_LEVELS levels of each side the way a
+ * strategy does without the cached features: from the best bid and ask, looking the sizes up tick by tick.
+ * @return microprice plus the depth of both sides, or 0 unless both sides have levels.
+ */
+double walkFeatures(const OrderBook& book, double tick_size) {
+    double bid = book.getBestBid(), ask = book.getBestAsk();
+    if (bid == -1 || ask == -1) {
+        return 0.0;
+    }
+
+    double bid_size = book.getLevelTotalSize(bid), ask_size = book.getLevelTotalSize(ask);
+    double depth = 0.0;
+    for (int side : {1, -1}) {
+        size_t levels = 0;
+        double price = side == 1 ? bid : ask;
+        for (int step = 0; step < 1000 && levels < BOOK_FEATURE_LEVELS && price > 0; ++step, price -= side * tick_size) {
+            double size = book.getLevelTotalSize(price);
+            depth += size;
+            levels += size > 0;
+        }
+    }
+    return (bid * ask_size + ask * bid_size) / (bid_size + ask_size) + depth;
+}
+
+
+/**
+ * Replays the market data with a number of readers of the microprice and depth after every event, reading the
+ * features the book keeps and walking the book once per reader, and compares the time taken.
+ * @param user user holding the exchanges of the configuration
+ * @param data_path file path for market data input
+ * @param num_readers number of readers, e.g. strategies, per event
+ */
+void reportFeatures(User& user, const string& data_path, int num_readers) {
+    for (bool walk : {false, true}) {
+        BookReplay<> replay(user, data_path);
+        std::shared_ptr<OrderBook> book;
+        uint64_t num_events = 0;
+        double checksum = 0.0;
+
+        auto start = chrono::steady_clock::now();
+        while (replay.next(book)) {
+            ++num_events;
+            if (book == nullptr) {
+                continue;
+            }
+
+            double tick_size = walk ? book->getExchange()->getTradingRules(book->getMarketType(), *book->getSecurity())[0] : 0.0;
+            for (int reader = 0; reader < num_readers; ++reader) {
+                if (walk) {
+                    checksum += walkFeatures(*book, tick_size);
+                } else {
+                    const BookFeatures& features = book->getFeatures();
+                    checksum += features.spread != -1 ? features.microprice + features.bid_depth + features.ask_depth : 0.0;
+                }
+            }
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        cout << left << setw(28) << (walk ? "walk per reader" : "cached features") << right << setw(16) << num_readers << " readers"
+                << setw(11) << fixed << setprecision(3) << elapsed.count() << " s"
+                << setw(14) << setprecision(0) << num_events / elapsed.count() << " events/s"
+                << "   (checksum " << setprecision(2) << checksum << ")" << endl;
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cerr << "Usage: " << argv[0] << " <Configuration Path> <Market Data Path>\n";
+        return 1;
+    }
+
+    User user(0, 0, argv[1]);
+
+    cout << "========== Top of Book ==========" << endl;
+    reportTopOfBookVisits(user, argv[2]);
+
+    cout << "\n========== Crossing Sweep ==========" << endl;
+    reportCrossingSweepVisits(user, argv[2]);
+
+    cout << "\n========== Deep Book Sweeps ==========" << endl;
+    reportDeepSweeps(user, 5000, 500, 2000);
+
+    cout << "\n========== Quote Snapshots ==========" << endl;
+    reportQuoteSnapshots(user, argv[2]);
+
+    cout << "\n========== Depth Policy ==========" << endl;
+    reportDepthPolicy<FullDepth>(user, argv[2], "full depth");
+    reportDepthPolicy<TopLevels<10>>(user, argv[2], "top 10 levels");
+    reportDepthPolicy<TopOfBook>(user, argv[2], "top of book");
+
+    cout << "\n========== Book Features ==========" << endl;
+    reportFeatures(user, argv[2], 20);
+}
@@ -12,7 +12,7 @@ using namespace std;
  * Struct for storing candlestick data
  */
 struct Candlestick {
-    string timestamp_;
+    long long timestamp_;   /*< open time in nanoseconds since epoch */
     double open_;
     double high_;
     double low_;
@@ -22,7 +22,7 @@ struct Candlestick {
     /**
      * Constructor for candlestick struct
      */
-    Candlestick(const string& timestamp, double open, double high, double low, double close, unsigned volume): 
+    Candlestick(long long timestamp, double open, double high, double low, double close, unsigned volume): 
             timestamp_(timestamp), open_(open), high_(high), low_(low), close_(close), volume_(volume) {}
 
     /**
@@ -30,7 +30,7 @@ struct Candlestick {
      */
     friend ostream& operator<<(ostream& os, const Candlestick& cs) {
         os << "========== Candlestick ==========" << endl;
-        os << "Time: " << cs.timestamp_ << endl;
+        os << "Time: " << formatTimestamp(cs.timestamp_) << endl;
         os << "Open: " << cs.open_ << endl;
         os << "High: " << cs.high_ << endl;
         os << "Low: " << cs.low_<< endl;
@@ -71,16 +71,16 @@ class MovingAverageCross: public Strategy {
         virtual vector<std::shared_ptr<Order>> onTrade(TradeEventMsg& event_msg) {
             vector<std::shared_ptr<Order>> orders;
 
-            string trade_timestamp = event_msg.timestamp->toString();
+            long long trade_timestamp = event_msg.timestamp;
             double trade_price = event_msg.price;
             double trade_size = event_msg.size;
 
             if (candlestick_vector.empty()) {
-                string rounded_timestamp = roundDownTimestamp(trade_timestamp, candlestick_second);
+                long long rounded_timestamp = roundDownTimestamp(trade_timestamp, candlestick_second);
                 candlestick_vector.push_back(Candlestick(rounded_timestamp, trade_price, trade_price, trade_price, trade_price, trade_size));
                 next_candlestick_open = addSecondsToTimestamp(rounded_timestamp, candlestick_second);
             } 
-            else if (trade_timestamp.compare(next_candlestick_open) < 0) {
+            else if (trade_timestamp < next_candlestick_open) {
                 Candlestick cd = candlestick_vector.back();
                 cd.close_ = trade_price;
 
@@ -90,7 +90,7 @@ class MovingAverageCross: public Strategy {
                 cd.volume_ += trade_size;
             } 
             else {
-                string rounded_timestamp = roundDownTimestamp(trade_timestamp, candlestick_second);
+                long long rounded_timestamp = roundDownTimestamp(trade_timestamp, candlestick_second);
                 next_candlestick_open = addSecondsToTimestamp(rounded_timestamp, candlestick_second);
                 candlestick_vector.push_back(Candlestick(rounded_timestamp, trade_price, trade_price, trade_price, trade_price, trade_size));
 
@@ -171,7 +171,7 @@ class MovingAverageCross: public Strategy {
         virtual vector<std::shared_ptr<Order>> onDepth(DepthEventMsg& event_msg) {return vector<std::shared_ptr<Order>>();}
 
     protected:
-        string next_candlestick_open;           /*< String timestamp for next candlestick open */
+        long long next_candlestick_open = 0;    /*< Timestamp for next candlestick open in nanoseconds since epoch */
         const int candlestick_second;           /*< Candlestick timeframe in seconds */
         const int short_length;                 /*< Short moving average length */
         const int long_length;                  /*< Long moving average length */
@@ -179,56 +179,24 @@ class MovingAverageCross: public Strategy {
 
     private:
     /**
-     * Helper function that rounds down a timestamp to the nearest second increment
-     * @param inputTimestamp timestamp specified in format 'yyyy-MM-dd HH:mm:ss.fffffffff'
+     * Helper function that rounds down a timestamp to the nearest second increment within its day
+     * @param input_timestamp timestamp in nanoseconds since epoch
      * @param second_increment second resolution to round down to
-     * @return rounded down timestamp in the same format
+     * @return rounded down timestamp in nanoseconds since epoch
     */
-    string roundDownTimestamp(const string& input_timestamp, int second_increment) {
-        // Parse the input timestamp
-        tm tmStruct = {};
-        istringstream ss(input_timestamp);
-        ss >> get_time(&tmStruct, "%Y-%m-%d %H:%M:%S");
-
-        // Calculate the rounded down timestamp
-        int total_seconds = tmStruct.tm_hour * 3600 + tmStruct.tm_min * 60 + tmStruct.tm_sec;
-        int roundedSeconds = total_seconds - (total_seconds % second_increment);
-        tmStruct.tm_hour = roundedSeconds / 3600;
-        tmStruct.tm_min = (roundedSeconds % 3600) / 60;
-        tmStruct.tm_sec = roundedSeconds % 60;
-
-        // Convert back to string
-        ostringstream result;
-        result << put_time(&tmStruct, "%Y-%m-%d %H:%M:%S");
-        result << ".000000000"; // Append fractional seconds
-
-        return result.str();
+    long long roundDownTimestamp(long long input_timestamp, int second_increment) {
+        long long total_seconds = input_timestamp / 1'000'000'000;
+        long long seconds_of_day = total_seconds % 86400;
+        return (total_seconds - seconds_of_day % second_increment) * 1'000'000'000;
     }
 
     /**
      * Helper function that adds given seconds to the timestamp
-     * @param inputTimestamp timestamp specified in format 'yyyy-MM-dd HH:mm:ss.fffffffff'
-     * @param second_increment second resolution to round down to
-     * @return timestamp after adding time in the same format
+     * @param input_timestamp timestamp in nanoseconds since epoch
+     * @param seconds_to_add number of seconds to add
+     * @return timestamp after adding time in nanoseconds since epoch
     */
-    string addSecondsToTimestamp(const string& input_timestamp, int seconds_to_add) {
-        // Parse the input timestamp
-        tm tmStruct = {};
-        istringstream ss(input_timestamp);
-        ss >> get_time(&tmStruct, "%Y-%m-%d %H:%M:%S");
-
-        // Calculate the new timestamp
-        time_t timestampInSeconds = mktime(&tmStruct);
-        timestampInSeconds += seconds_to_add; //
-
-        // Convert back to struct tm
-        tm newTmStruct = *localtime(&timestampInSeconds);
-
-        // Convert back to string
-        ostringstream result;
-        result << put_time(&newTmStruct, "%Y-%m-%d %H:%M:%S");
-        result << ".000000000"; // Append fractional seconds
-
-        return result.str();
+    long long addSecondsToTimestamp(long long input_timestamp, int seconds_to_add) {
+        return input_timestamp + seconds_to_add * 1'000'000'000LL;
     }
 };
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "gtest/gtest.h"
+#include "backtesting/OrderBook.h"
+#include <memory>
+
+
+TEST(BookHistoryTest, AsOfTest) {
+BookHistory history(3);
+EXPECT_EQ(history.getCapacity(), 4);     // Rounded up to a power of two
+
+BookHistoryEntry entry;
+EXPECT_FALSE(history.asOf(100, entry));
+
+history.record(100, 10.0, 11.0, -1.0);
+history.record(200, 10.0, 11.0, -1.0);     // Repeats the last entry
+history.record(300, 10.5, 11.0, 10.5);
+history.record(300, 10.5, 11.5, 10.5);     // Same time, replaces it
+EXPECT_EQ(history.size(), 2);
+
+EXPECT_FALSE(history.asOf(99, entry));
+ASSERT_TRUE(history.asOf(100, entry));
+EXPECT_EQ(entry.timestamp, 100);
+EXPECT_EQ(entry.bid_price, 10.0);
+ASSERT_TRUE(history.asOf(299, entry));
+EXPECT_EQ(entry.ask_price, 11.0);
+ASSERT_TRUE(history.asOf(1000, entry));
+EXPECT_EQ(entry.ask_price, 11.5);
+EXPECT_EQ(entry.last_trade_price, 10.5);
+
+// A full ring drops the oldest entries
+for (long long timestamp = 400; timestamp <= 700; timestamp += 100) {
+    history.record(timestamp, timestamp / 10.0, timestamp / 10.0 + 1, -1.0);
+}
+EXPECT_EQ(history.size(), 4);
+EXPECT_EQ(history.at(0).timestamp, 400);
+EXPECT_EQ(history.at(3).timestamp, 700);
+EXPECT_THROW(history.at(4), out_of_range);
+EXPECT_FALSE(history.asOf(399, entry));
+ASSERT_TRUE(history.asOf(650, entry));
+EXPECT_EQ(entry.bid_price, 60.0);
+
+// An entry before the last one is taken at the last one's time
+history.record(500, 1.0, 2.0, -1.0);
+EXPECT_EQ(history.at(3).timestamp, 700);
+EXPECT_EQ(history.at(3).bid_price, 1.0);
+
+history.clear();
+EXPECT_EQ(history.size(), 0);
+EXPECT_FALSE(history.asOf(1000, entry));
+}
+
+
+TEST(BookHistoryTest, OrderBookHistoryTest) {
+std::shared_ptr<Exchange> exchange = make_shared<Exchange>("Binance");
+exchange->loadJson("./configuration/exchange.json");
+OrderBook book(exchange, MarketType::Spot, exchange->findSecurity(MarketType::Spot, "BTC/USDT"), 16);
+EXPECT_EQ(book.getHistory().getCapacity(), 16);
+EXPECT_EQ(book.getLastTradePrice(), -1);
+
+book.buySideUpdated(100, 1.0);
+book.sellSideUpdated(101, 1.0);
+book.recordHistory(1000);
+book.tradeOccurred(101, 1.0);
+book.recordHistory(2000);
+
+BookHistoryEntry entry;
+ASSERT_TRUE(book.getHistory().asOf(1500, entry));
+EXPECT_EQ(entry.bid_price, 100);
+EXPECT_EQ(entry.ask_price, 101);
+EXPECT_EQ(entry.last_trade_price, -1);
+ASSERT_TRUE(book.getHistory().asOf(2000, entry));
+EXPECT_EQ(entry.ask_price, -1);     // The trade took the ask
+EXPECT_EQ(entry.last_trade_price, 101);
+EXPECT_EQ(book.getLastTradePrice(), 101);
+}
@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+#include "data/compression.h"
+#include "data/eventstore.h"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+
+/**
+ * Helper that builds market data with trades of two instruments.
+ */
+string makeCompressionData(int num_rows) {
+    ostringstream data;
+    data << "COLLECTION_TIME,MESSAGE_ID,MESSAGE_TYPE,SYMBOL,MARKET_CENTER,MARKET_TYPE,PRICE,SIZE\n";
+    for (int i = 0; i < num_rows; ++i) {
+        data << "2023-01-03 09:00:00." << setw(9) << setfill('0') << i << "," << i << ",T," << (i % 3 ? "BTC/USDT" : "ETH/USDT") << ",Binance,S,"
+                << 16800 + i << ".25,0.5\n";
+    }
+    return data.str();
+}
+
+/**
+ * Helper that writes data to the temporary directory, gzip compressed in the given number of members.
+ */
+string writeGzip(const string& name, const string& data, int num_members) {
+    string path = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove(path);
+
+    size_t member_size = data.size() / num_members + 1;
+    for (size_t offset = 0; offset < data.size(); offset += member_size) {
+        gzFile file = gzopen(path.c_str(), "ab");
+        gzwrite(file, data.data() + offset, static_cast<unsigned>(min(member_size, data.size() - offset)));
+        gzclose(file);
+    }
+    return path;
+}
+
+
+TEST(CompressedCsvEventSourceTest, SameEventsTest) {
+string data = makeCompressionData(3000);
+string plain_path = (std::filesystem::temp_directory_path() / "compressed_plain.csv").string();
+ofstream(plain_path, ios::binary) << data;
+string gzip_path = writeGzip("compressed_events.csv.gz", data, 3);
+
+EXPECT_EQ(detectCompression(plain_path), Compression::None);
+EXPECT_EQ(detectCompression(gzip_path), Compression::Gzip);
+
+// Small blocks so lines are carried over block boundaries; 16 bytes is shorter than a line
+for (size_t block_size : {16, 1000, 1 << 20}) {
+    CsvEventSource direct(plain_path);
+    CompressedCsvEventSource compressed(gzip_path, block_size);
+
+    MarketEvent expected, event;
+    while (direct.nextEvent(expected)) {
+        ASSERT_TRUE(compressed.nextEvent(event));
+        ASSERT_EQ(memcmp(&event, &expected, sizeof(MarketEvent)), 0);
+    }
+    EXPECT_FALSE(compressed.nextEvent(event));
+    EXPECT_EQ(compressed.getInstruments().size(), 2);
+}
+
+// Opening and converting detect the compression
+unique_ptr<EventSource> source = openMarketData(gzip_path);
+MarketEvent event;
+EXPECT_TRUE(source->nextEvent(event));
+EXPECT_FALSE(std::filesystem::exists(gzip_path + EVENT_STORE_EXTENSION));
+EXPECT_EQ(convertMarketData(gzip_path, gzip_path + ".converted" + EVENT_STORE_EXTENSION), 3000);
+}
+
+TEST(CompressedCsvEventSourceTest, InvalidInputTest) {
+// Truncated archive: rows before the damage are decoded, then the error surfaces
+string data = makeCompressionData(20000);
+string gzip_path = writeGzip("compressed_truncated.csv.gz", data, 1);
+std::filesystem::resize_file(gzip_path, std::filesystem::file_size(gzip_path) / 2);
+
+CompressedCsvEventSource truncated(gzip_path, 4096);
+MarketEvent event;
+int num_events = 0;
+EXPECT_THROW(while (truncated.nextEvent(event)) {++num_events;}, runtime_error);
+EXPECT_GT(num_events, 0);
+
+// Formats not compiled in are reported
+string zstd_path = (std::filesystem::temp_directory_path() / "compressed.csv.zst").string();
+ofstream(zstd_path, ios::binary) << "\x28\xb5\x2f\xfd";
+EXPECT_EQ(detectCompression(zstd_path), Compression::Zstd);
+#ifndef CRYPTOPULSE_WITH_ZSTD
+EXPECT_THROW(CompressedCsvEventSource source(zstd_path), runtime_error);
+#endif
+}
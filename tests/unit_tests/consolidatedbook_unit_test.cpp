@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include "backtesting/consolidatedbook.h"
+#include <memory>
+#include <random>
+
+
+/**
+ * Helper that creates an empty BTC/USDT spot orderbook of an exchange.
+ */
+std::shared_ptr<OrderBook> makeConsolidatedTestBook(const string& exchange_name) {
+    std::shared_ptr<Exchange> exchange = make_shared<Exchange>(exchange_name);
+    exchange->loadJson("./configuration/exchange.json");
+    return make_shared<OrderBook>(exchange, MarketType::Spot, exchange->findSecurity(MarketType::Spot, "BTC/USDT"));
+}
+
+
+TEST(ConsolidatedBookTest, BestAcrossVenuesTest) {
+std::shared_ptr<OrderBook> binance = makeConsolidatedTestBook("Binance");
+std::shared_ptr<OrderBook> bybit = makeConsolidatedTestBook("Bybit");
+std::shared_ptr<OrderBook> okx = makeConsolidatedTestBook("Okx");
+binance->buySideUpdated(100, 1.0);
+binance->sellSideUpdated(103, 1.0);
+
+ConsolidatedBook consolidated;
+EXPECT_EQ(consolidated.getBestBid(), -1);
+EXPECT_EQ(consolidated.getBestAskExchange(), nullptr);
+EXPECT_EQ(consolidated.addVenue(binance), 0);
+EXPECT_EQ(consolidated.addVenue(bybit), 1);
+EXPECT_EQ(consolidated.addVenue(okx), 2);
+EXPECT_EQ(consolidated.getNumVenues(), 3);
+EXPECT_EQ(consolidated.findVenue(okx.get()), 2);
+EXPECT_EQ(consolidated.findVenue(nullptr), -1);
+
+// A venue's top is taken when it is added
+EXPECT_EQ(consolidated.getBestBid(), 100);
+EXPECT_EQ(consolidated.getBestBidSize(), 1.0);
+EXPECT_EQ(consolidated.getBestAsk(), 103);
+EXPECT_EQ(consolidated.getBestBidExchange(), binance->getExchange());
+
+// Other venues win once they are refreshed
+bybit->buySideUpdated(101, 2.0);
+okx->sellSideUpdated(102, 3.0);
+EXPECT_EQ(consolidated.getBestBid(), 100);
+consolidated.update(1);
+consolidated.update(2);
+EXPECT_EQ(consolidated.getBestBid(), 101);
+EXPECT_EQ(consolidated.getBestBidSize(), 2.0);
+EXPECT_EQ(consolidated.getBestBidVenue(), 1);
+EXPECT_EQ(consolidated.getBestAsk(), 102);
+EXPECT_EQ(consolidated.getBestAskSize(), 3.0);
+EXPECT_EQ(consolidated.getBestAskExchange(), okx->getExchange());
+
+// Ties go to the venue added first; size changes at the best are picked up
+binance->buySideUpdated(101, 4.0);
+consolidated.update(0);
+EXPECT_EQ(consolidated.getBestBidVenue(), 0);
+EXPECT_EQ(consolidated.getBestBidSize(), 4.0);
+binance->buySideUpdated(101, 5.0);
+consolidated.update(0);
+EXPECT_EQ(consolidated.getBestBidSize(), 5.0);
+
+// An emptied venue drops out
+okx->sellSideUpdated(102, 0.0);
+consolidated.update(2);
+EXPECT_EQ(consolidated.getBestAsk(), 103);
+EXPECT_EQ(consolidated.getVenueQuote(2).ask_price, -1);
+EXPECT_THROW(consolidated.update(3), out_of_range);
+}
+
+
+TEST(ConsolidatedBookTest, RandomVenuesTest) {
+const char* names[] = {"Binance", "Bybit", "Okx", "Coinbase", "Binance"};
+vector<std::shared_ptr<OrderBook>> books;
+ConsolidatedBook consolidated;
+mt19937 rng(23);
+
+for (const char* name : names) {
+    books.push_back(makeConsolidatedTestBook(name));
+    consolidated.addVenue(books.back());
+}
+
+for (int step = 0; step < 2000; ++step) {
+    size_t venue = rng() % books.size();
+    double price = 100 + static_cast<int>(rng() % 10);
+    double size = (rng() % 4) * 0.5;
+    if (price < 105) {
+        books[venue]->buySideUpdated(price, size);
+    } else {
+        books[venue]->sellSideUpdated(price, size);
+    }
+    consolidated.update(venue);
+
+    // Brute force over the books, the first venue winning ties
+    int best_bid = -1, best_ask = -1;
+    for (size_t i = 0; i < books.size(); ++i) {
+        double bid = books[i]->getBestBid(), ask = books[i]->getBestAsk();
+        if (bid != -1 && (best_bid == -1 || bid > books[best_bid]->getBestBid())) {
+            best_bid = i;
+        }
+        if (ask != -1 && (best_ask == -1 || ask < books[best_ask]->getBestAsk())) {
+            best_ask = i;
+        }
+    }
+    ASSERT_EQ(consolidated.getBestBidVenue(), best_bid);
+    ASSERT_EQ(consolidated.getBestAskVenue(), best_ask);
+    if (best_bid != -1) {
+        ASSERT_EQ(consolidated.getBestBid(), books[best_bid]->getBestBid());
+        ASSERT_EQ(consolidated.getBestBidSize(), books[best_bid]->getLevelTotalSize(books[best_bid]->getBestBid()));
+    }
+    if (best_ask != -1) {
+        ASSERT_EQ(consolidated.getBestAsk(), books[best_ask]->getBestAsk());
+        ASSERT_EQ(consolidated.getBestAskSize(), books[best_ask]->getLevelTotalSize(books[best_ask]->getBestAsk()));
+    }
+}
+}
@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+#include "backtesting/depthtree.h"
+#include <map>
+#include <random>
+
+
+TEST(DepthTreeTest, PrefixReachTest) {
+DepthTree depth;
+EXPECT_EQ(depth.prefix(100), 0.0);
+EXPECT_EQ(depth.reach(1.0), PRICE_LADDER_NO_TICK);
+
+depth.set(100, 1.0);
+depth.set(102, 2.0);
+depth.set(1000000, 4.0);     // Far away, outside the window
+EXPECT_EQ(depth.get(102), 2.0);
+EXPECT_EQ(depth.getTotal(), 7.0);
+EXPECT_EQ(depth.getNumOverflowTicks(), 1);     // The window stays on the near ticks
+
+EXPECT_EQ(depth.prefix(99), 0.0);
+EXPECT_EQ(depth.prefix(101), 1.0);
+EXPECT_EQ(depth.prefix(102), 3.0);
+EXPECT_EQ(depth.prefix(2000000), 7.0);
+
+EXPECT_EQ(depth.reach(0.5), 100);
+EXPECT_EQ(depth.reach(1.0), 100);
+EXPECT_EQ(depth.reach(1.5), 102);
+EXPECT_EQ(depth.reach(3.5), 1000000);
+EXPECT_EQ(depth.reach(7.5), PRICE_LADDER_NO_TICK);
+
+// Clearing a size leaves nothing behind in the range
+depth.set(100, 0.1);
+depth.set(100, 0.0);
+EXPECT_EQ(depth.prefix(101), 0.0);
+EXPECT_EQ(depth.reach(1.0), 102);
+}
+
+TEST(DepthTreeTest, RandomDriftTest) {
+// Small window so that growing, following the market and the overflow map are all exercised
+DepthTree depth(256);
+map<long long, double> expected;
+mt19937 rng(11);
+long long center = 100000;
+
+for (int step = 0; step < 20000; ++step) {
+    center += static_cast<int>(rng() % 7) - 3;
+    depth.follow(center);
+    long long tick = rng() % 50 == 0 ? center + static_cast<int>(rng() % 20001) - 10000 : center + static_cast<int>(rng() % 41) - 20;
+    double size = rng() % 4 == 0 ? 0.0 : (rng() % 1000 + 1) / 100.0;
+    depth.set(tick, size);
+    if (size == 0.0) {
+        expected.erase(tick);
+    } else {
+        expected[tick] = size;
+    }
+
+    long long probe = center + static_cast<int>(rng() % 601) - 300;
+    double expected_prefix = 0.0;
+    for (auto it = expected.begin(); it != expected.end() && it->first <= probe; ++it) {
+        expected_prefix += it->second;
+    }
+    ASSERT_NEAR(depth.prefix(probe), expected_prefix, 1e-9);
+    if (expected_prefix == 0.0) {
+        ASSERT_EQ(depth.prefix(probe), 0.0);
+    }
+
+    // Reaching a size just below the total at a level lands on that level
+    if (!expected.empty()) {
+        auto level = next(expected.begin(), rng() % expected.size());
+        double reached = 0.0;
+        for (auto it = expected.begin(); it != next(level); ++it) {
+            reached += it->second;
+        }
+        ASSERT_EQ(depth.reach(reached - 0.001), level->first);
+        ASSERT_NEAR(depth.prefix(level->first), reached, 1e-9);
+    }
+}
+
+EXPECT_LE(depth.getNumOverflowTicks(), expected.size());
+EXPECT_GT(depth.getNumOverflowTicks(), 0);
+EXPECT_NEAR(depth.getTotal(), depth.prefix(expected.rbegin()->first), 1e-9);
+}
+
+TEST(DepthTreeTest, WindowHysteresisTest) {
+DepthTree depth(256);
+for (long long tick = 99990; tick <= 100010; ++tick) {
+    depth.set(tick, 1.0);
+}
+long long base = depth.getBase();
+
+// Sizes far from the touch, on either side, go to the overflow map and leave the window where it is
+for (int i = 1; i <= 100; ++i) {
+    depth.set(100000 + (i % 2 == 0 ? i : -i) * 1000, i);
+    depth.set(99990 + i % 21, 2.0);
+    depth.follow(100000 + i % 21 - 10);
+    ASSERT_EQ(depth.getBase(), base);
+}
+EXPECT_EQ(depth.getNumOverflowTicks(), 100);
+
+// Queries past the window use the running totals of the overflow map, and see changes to it
+EXPECT_EQ(depth.prefix(0), 0.0);
+EXPECT_EQ(depth.prefix(1000), 99.0);
+EXPECT_EQ(depth.prefix(102000), 2500.0 + 42.0 + 2.0);
+EXPECT_EQ(depth.reach(2500.0 + 42.0 + 1.0), 102000);
+depth.set(1000, 0.0);
+depth.set(2000, 5.0);
+EXPECT_EQ(depth.prefix(1000), 0.0);
+EXPECT_EQ(depth.prefix(2000), 5.0);
+EXPECT_EQ(depth.prefix(102000), 2500.0 - 99.0 + 5.0 + 42.0 + 2.0);
+EXPECT_EQ(depth.reach(5.0), 2000);
+EXPECT_EQ(depth.reach(6.0), 3000);
+
+// Past the middle half of the window, it recenters on the touch
+depth.follow(base + 191);
+EXPECT_EQ(depth.getBase(), base);
+depth.follow(base + 192);
+EXPECT_EQ(depth.getBase(), base + 64);
+depth.follow(102000);
+EXPECT_EQ(depth.getBase(), 102000 - 128);
+EXPECT_EQ(depth.getNumOverflowTicks(), 120);
+EXPECT_EQ(depth.prefix(102000), 2500.0 - 99.0 + 5.0 + 42.0 + 2.0);
+EXPECT_EQ(depth.reach(2500.0 - 99.0 + 5.0 + 42.0 + 2.0), 102000);
+}
@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "data/eventmerge.h"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+
+/**
+ * Helper that writes a market data file with one trade per given millisecond to a temporary directory.
+ */
+string writeMergeData(const string& name, const string& exchange, const vector<int>& milliseconds) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "merge_test";
+    std::filesystem::create_directories(directory);
+    string path = (directory / name).string();
+    ofstream file(path, ios::binary);
+
+    file << "HEADER\n";
+    for (int millisecond : milliseconds) {
+        file << "2023-01-03 09:00:00." << setw(3) << setfill('0') << millisecond << ",0,T,BTC/USDT," << exchange << ",S," << millisecond << ",1\n";
+    }
+    return path;
+}
+
+
+TEST(MergedEventSourceTest, MergeByTimestampTest) {
+vector<unique_ptr<EventSource>> sources;
+sources.push_back(make_unique<CsvEventSource>(writeMergeData("binance.csv", "Binance", {1, 4, 4, 9})));
+sources.push_back(make_unique<CsvEventSource>(writeMergeData("bybit.csv", "Bybit", {2, 4, 5})));
+sources.push_back(make_unique<CsvEventSource>(writeMergeData("empty.csv", "Okx", {})));
+sources.push_back(make_unique<CsvEventSource>(writeMergeData("coinbase.csv", "Coinbase", {0, 10})));
+MergedEventSource merged(std::move(sources));
+
+// Equal timestamps keep the order of the sources
+vector<pair<int, string>> expected = {{0, "Coinbase"}, {1, "Binance"}, {2, "Bybit"}, {4, "Binance"}, {4, "Binance"}, {4, "Bybit"}, {5, "Bybit"},
+        {9, "Binance"}, {10, "Coinbase"}};
+MarketEvent event;
+for (const auto& [millisecond, exchange] : expected) {
+    ASSERT_TRUE(merged.nextEvent(event));
+    EXPECT_EQ(event.price, millisecond);
+    EXPECT_EQ(merged.getInstruments().at(event.instrument_id).exchange, exchange);
+}
+EXPECT_FALSE(merged.nextEvent(event));
+
+// Instrument ids of all sources map to one table in order of first appearance
+EXPECT_EQ(merged.getInstruments().size(), 3);
+EXPECT_EQ(merged.getInstruments().at(0).exchange, "Coinbase");
+}
+
+TEST(MergedEventSourceTest, ExpandPathsTest) {
+string binance = writeMergeData("day1.csv", "Binance", {1});
+string bybit = writeMergeData("day2.csv", "Bybit", {2});
+writeMergeData("day1.csv.events", "Binance", {1});    // Stands in for a cached store
+
+string directory = std::filesystem::path(binance).parent_path().string();
+EXPECT_EQ(expandMarketDataPaths(directory + "/day*"), (vector<string>{binance, bybit}));
+EXPECT_EQ(expandMarketDataPaths(binance), vector<string>{binance});
+EXPECT_THROW(expandMarketDataPaths(directory + "/nothing*.csv"), invalid_argument);
+
+unique_ptr<EventSource> source = openMarketData(expandMarketDataPaths(directory + "/day?.csv"), false);
+MarketEvent event;
+ASSERT_TRUE(source->nextEvent(event));
+ASSERT_TRUE(source->nextEvent(event));
+EXPECT_EQ(source->getInstruments().at(event.instrument_id).exchange, "Bybit");
+EXPECT_FALSE(source->nextEvent(event));
+}
@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+#include "data/eventstore.h"
+#include "data/marketdata.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+
+/**
+ * Helper that writes a market data file to the temporary directory.
+ */
+string writeMarketData(const string& name, const string& contents) {
+    string path = (std::filesystem::temp_directory_path() / name).string();
+    ofstream file(path, ios::binary);
+    file << contents;
+    return path;
+}
+
+
+TEST(MarketDataReaderTest, SplitRowTest) {
+string path = writeMarketData("reader_split.csv",
+        "COLLECTION_TIME,MESSAGE_ID,MESSAGE_TYPE,SYMBOL,MARKET_CENTER,MARKET_TYPE,PRICE,SIZE\n"
+        "2023-01-03 09:00:00.000000001,1,T,BTC/USDT,Binance,S,16800.01,0.5,,,,,,,,,,,,\n"
+        "2023-01-03 09:00:00.000000002,2,T,BTC/USDT,Binance,S,16800.02,0.25\r\n"
+        "\n"
+        "2023-01-03 09:00:00.000000003,3,T,BTC/USDT,Binance,S,16800.03,1");
+
+MarketDataReader reader(path);
+MarketDataReader::Row row;
+
+// Full row with empty trailing fields
+ASSERT_TRUE(reader.nextRow(row));
+EXPECT_EQ(row[0], "2023-01-03 09:00:00.000000001");
+EXPECT_EQ(row[2], "T");
+EXPECT_EQ(row[4], "Binance");
+EXPECT_EQ(parseDouble(row[6]), 16800.01);
+EXPECT_TRUE(row[19].empty());
+
+// Short row with windows line ending
+ASSERT_TRUE(reader.nextRow(row));
+EXPECT_EQ(row[7], "0.25");
+EXPECT_TRUE(row[8].empty());
+
+// Last row without line ending, empty line skipped
+ASSERT_TRUE(reader.nextRow(row));
+EXPECT_EQ(row[1], "3");
+EXPECT_EQ(row[7], "1");
+
+EXPECT_FALSE(reader.nextRow(row));
+EXPECT_EQ(reader.getRowsRead(), 3);
+}
+
+TEST(MarketDataReaderTest, InvalidInputTest) {
+EXPECT_THROW(MarketDataReader("./does/not/exist.csv"), invalid_argument);
+EXPECT_THROW(parseDouble("abc"), invalid_argument);
+EXPECT_THROW(parseDouble(""), invalid_argument);
+
+// Empty file has no rows
+MarketDataReader reader(writeMarketData("reader_empty.csv", ""));
+MarketDataReader::Row row;
+EXPECT_FALSE(reader.nextRow(row));
+}
+
+TEST(EventStoreTest, ConvertAndReplayTest) {
+string csv_path = writeMarketData("store_convert.csv",
+        "COLLECTION_TIME,MESSAGE_ID,MESSAGE_TYPE,SYMBOL,MARKET_CENTER,MARKET_TYPE,PRICE,SIZE,BID_PRICE_1,BID_SIZE_1,BID_PRICE_2,BID_SIZE_2,BID_PRICE_3,BID_SIZE_3,ASK_PRICE_1,ASK_SIZE_1,ASK_PRICE_2,ASK_SIZE_2,ASK_PRICE_3,ASK_SIZE_3\n"
+        "2023-01-03 09:00:00.000000001,1,T,BTC/USDT,Binance,S,16800.01,0.5,,,,,,,,,,,,\n"
+        "2023-01-03 09:00:00.000000002,2,BID_UPDATE,ETH/USDT,Bybit,S,,,1200.5,2,1200.4,3,1200.3,4,1200.6,5,1200.7,6,1200.8,7\n"
+        "2023-01-03 09:00:00.000000003,3,SELL_SIDE_UPDATE,BTC/USDT,Binance,S,16800.05,1.25,,,,,,,,,,,,\n");
+string store_path = csv_path + ".converted.events";
+
+EXPECT_EQ(convertMarketData(csv_path, store_path), 3);
+
+EventStoreReader store(store_path);
+EXPECT_EQ(store.getNumEvents(), 3);
+EXPECT_EQ(store.getInstruments().size(), 2);
+EXPECT_EQ(store.getInstruments().at(1).exchange, "Bybit");
+EXPECT_EQ(store.getInstruments().at(1).symbol, "ETH/USDT");
+
+MarketEvent event;
+ASSERT_TRUE(store.nextEvent(event));
+EXPECT_EQ(event.message_type, MessageType::Trade);
+EXPECT_EQ(event.timestamp, TimeType("2023-01-03 09:00:00.000000001").toNanosecondsSinceEpoch());
+EXPECT_EQ(event.price, 16800.01);
+EXPECT_EQ(event.instrument_id, 0);
+
+ASSERT_TRUE(store.nextEvent(event));
+EXPECT_EQ(event.message_type, MessageType::BidUpdate);
+EXPECT_EQ(event.instrument_id, 1);
+EXPECT_EQ(event.bid_price[2], 1200.3);
+EXPECT_EQ(event.ask_size[2], 7);
+
+ASSERT_TRUE(store.nextEvent(event));
+EXPECT_EQ(event.message_type, MessageType::SellSideUpdate);
+EXPECT_EQ(event.size, 1.25);
+EXPECT_FALSE(store.nextEvent(event));
+}
+
+TEST(EventStoreTest, CacheInvalidationTest) {
+string csv_path = writeMarketData("store_cache.csv",
+        "HEADER\n"
+        "2023-01-03 09:00:00.000000001,1,T,BTC/USDT,Binance,S,16800.01,0.5\n");
+string store_path = getEventStoreCachePath(csv_path, "");
+std::filesystem::remove(store_path);
+
+// First open converts, second open reuses the store
+EXPECT_FALSE(isEventStoreCacheValid(store_path, csv_path));
+openMarketData(csv_path);
+EXPECT_TRUE(isEventStoreCacheValid(store_path, csv_path));
+
+// Changing the CSV file invalidates the store
+writeMarketData("store_cache.csv",
+        "HEADER\n"
+        "2023-01-03 09:00:00.000000001,1,T,BTC/USDT,Binance,S,16800.01,0.5\n"
+        "2023-01-03 09:00:00.000000002,2,T,BTC/USDT,Binance,S,16800.02,0.5\n");
+EXPECT_FALSE(isEventStoreCacheValid(store_path, csv_path));
+
+unique_ptr<EventSource> source = openMarketData(csv_path);
+MarketEvent event;
+int num_events = 0;
+while (source->nextEvent(event)) {
+    ++num_events;
+}
+EXPECT_EQ(num_events, 2);
+EXPECT_TRUE(isEventStoreCacheValid(store_path, csv_path));
+}
@@ -1,114 +1,136 @@
 #include "gtest/gtest.h"
 #include "backtesting/order.h"
+#include <memory>
 #include <string>
 
-int Order::next_id=0;
 
-
-// Create securities
-Security btcusdt("BTC", "USDT");
-
-// Create exchanges
-Exchange binance("Binance");
-Exchange bybit("Bybit");
-Exchange coinbase("Coinbase");
-Exchange okx("Okx");
+// 2023-12-31 23:59:59.999999999 in nanoseconds since epoch
+const long long ORDER_TEST_TIMESTAMP = 1704067199999999999LL;
+
+/**
+ * Helper that loads an exchange from the sample configuration once.
+ */
+std::shared_ptr<Exchange> getOrderTestExchange(const string& name) {
+    static unordered_map<string, std::shared_ptr<Exchange>> exchanges;
+    std::shared_ptr<Exchange>& exchange = exchanges[name];
+    if (exchange == nullptr) {
+        exchange = make_shared<Exchange>(name);
+        exchange->loadJson("./configuration/exchange.json");
+    }
+    return exchange;
+}
 
 
 TEST(OrderTest, SanityCheckTest) {
-// Load configuration Json files
-binance.loadJson("./tests/exchange_json_test/exchange.json");
-bybit.loadJson("./tests/exchange_json_test/exchange.json");
-coinbase.loadJson("./tests/exchange_json_test/exchange.json");
-okx.loadJson("./tests/exchange_json_test/exchange.json");
+std::shared_ptr<Exchange> binance = getOrderTestExchange("Binance");
+std::shared_ptr<Exchange> bybit = getOrderTestExchange("Bybit");
+std::shared_ptr<Security> btcusdt = binance->findSecurity(MarketType::Spot, "BTC/USDT");
 
 // Testing invalid order side
-Order wrong_order_side(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 0, 1.5, 0, 1, MarginType::NoMargin, 70000.5, binance);
-EXPECT_EQ(wrong_order_side.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 0, 1.5, 0, 1, MarginType::NoMargin, 70000.5, binance), invalid_argument);
 
 // Testing zero order size
-Order zero_size_order(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 0, 0, 1, MarginType::NoMargin, 70000.5, binance);
-EXPECT_EQ(zero_size_order.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 0, 0, 1, MarginType::NoMargin, 70000.5, binance), invalid_argument);
 
 // Testing negative base order size
-Order negative_base_size(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, -1, 0, 1, MarginType::NoMargin, 70000.5, binance);
-EXPECT_EQ(negative_base_size.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, -1, 0, 1, MarginType::NoMargin, 70000.5, binance), invalid_argument);
 
 // Testing negative quote order size
-Order negative_quote_size(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 0, -1000, 1, MarginType::NoMargin, 70000.5, binance);
-EXPECT_EQ(negative_quote_size.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 0, -1000, 1, MarginType::NoMargin, 70000.5, binance), invalid_argument);
 
 // Testing both base and quote order size
-Order both_order_size_provided(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 1.5, 1000, 1, MarginType::NoMargin, 70000.5, binance);
-EXPECT_EQ(both_order_size_provided.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 1.5, 1000, 1, MarginType::NoMargin, 70000.5, binance), invalid_argument);
 
-// Testing invalid minimum tick size
-Order invalid_minimum_tick(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 1.5, 0, 1, MarginType::NoMargin, 70000.512, binance);
-EXPECT_EQ(invalid_minimum_tick.getOrderState(), OrderState::Rejected);
+// Testing non-positive price
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 1.5, 0, 1, MarginType::NoMargin, 0, binance), invalid_argument);
 
 // Testing sub 1 leverage
-Order sub_one_leverage(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 1.5, 0, 0.9, MarginType::Cross, 70000.51, binance);
-EXPECT_EQ(sub_one_leverage.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 1.5, 0, 0, MarginType::Cross, 70000.51, binance), invalid_argument);
 
 // Testing no margin
-Order no_margin(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 1.5, 0, 1, MarginType::Cross, 70000.51, binance);
-Order leveraged_no_margin(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 1.5, 0, 2, MarginType::NoMargin, 70000.51, binance);
-EXPECT_EQ(no_margin.getOrderState(), OrderState::Rejected);
-EXPECT_EQ(leveraged_no_margin.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 1.5, 0, 1, MarginType::Cross, 70000.51, binance), invalid_argument);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 1.5, 0, 2, MarginType::NoMargin, 70000.51, binance), invalid_argument);
 
 // Testing maximum leverage
-Order isolated_leverage(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 1.5, 0, 11, MarginType::Isolated, 70000.51, binance);
-Order cross_leverage(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 1.5, 0, 6, MarginType::Cross, 70000.51, binance);
-EXPECT_EQ(isolated_leverage.getOrderState(), OrderState::Rejected);
-EXPECT_EQ(cross_leverage.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 1.5, 0, 11, MarginType::Isolated, 70000.51, binance), invalid_argument);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 1.5, 0, 6, MarginType::Cross, 70000.51, binance), invalid_argument);
+EXPECT_NO_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 1.5, 0, 10, MarginType::Isolated, 70000.51, binance));
 
 // Testing minimum order size
-Order base_min_order(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 0.000001, 0, 5, MarginType::Isolated, 70000.51, binance);
-Order quote_min_order(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 0, 0.9, 5, MarginType::Isolated, 70000.51, binance);
-EXPECT_EQ(base_min_order.getOrderState(), OrderState::Rejected);
-EXPECT_EQ(quote_min_order.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 0.000001, 0, 5, MarginType::Isolated, 70000.51, binance), invalid_argument);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 0, 0.9, 5, MarginType::Isolated, 70000.51, binance), invalid_argument);
 
 // Testing maximum limit order size
-Order limit_base_max(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 2000, 0, 5, MarginType::Isolated, 70000.51, binance);
-Order limit_quote_max(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 0, 500000, 5, MarginType::Isolated, 70000.51, bybit);
-EXPECT_EQ(limit_base_max.getOrderState(), OrderState::Rejected);
-EXPECT_EQ(quote_min_order.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 2000, 0, 5, MarginType::Isolated, 70000.51, binance), invalid_argument);
+EXPECT_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 0, 500000, 5, MarginType::Isolated, 70000.51, bybit), invalid_argument);
 
 // Testing maximum market order size
-Order market_base_max(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "MARKET", 1, 15, 0, 5, MarginType::Isolated, 70000.51, binance);
-Order market_quote_max(btcusdt, MarketType::Spot, "2023-12-31 23:59:59.999999999", "MARKET", 1, 0, 500000, 5, MarginType::Isolated, 70000.51, bybit);
-EXPECT_EQ(market_base_max.getOrderState(), OrderState::Rejected);
-EXPECT_EQ(market_quote_max.getOrderState(), OrderState::Rejected);
+EXPECT_THROW(Market(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 15, 0, 5, MarginType::Isolated, 70000.51, binance), invalid_argument);
+EXPECT_NO_THROW(Limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 15, 0, 5, MarginType::Isolated, 70000.51, binance));
+}
+
+TEST(OrderTest, OrderReceivedTest) {
+std::shared_ptr<Exchange> binance = getOrderTestExchange("Binance");
+Limit limit(binance->findSecurity(MarketType::Spot, "BTC/USDT"), MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 10, 0, 1, MarginType::NoMargin, 10.0, binance);
+EXPECT_EQ(limit.getOrderState(), OrderState::SentToExchange);
+EXPECT_FALSE(limit.isLiveOrder());
+
+// The order starts working once the sending latency has passed
+limit.checkOrderReceived(ORDER_TEST_TIMESTAMP + binance->getSendingLatency() - 1);
+EXPECT_EQ(limit.getOrderState(), OrderState::SentToExchange);
+limit.checkOrderReceived(ORDER_TEST_TIMESTAMP + binance->getSendingLatency());
+EXPECT_EQ(limit.getOrderState(), OrderState::Working);
+
+limit.cancelOrder();
+EXPECT_EQ(limit.getOrderState(), OrderState::Cancelled);
+EXPECT_FALSE(limit.isLiveOrder());
 }
 
 TEST(LimitOrderTest, ConstructorTest) {
+std::shared_ptr<Exchange> binance = getOrderTestExchange("Binance");
+std::shared_ptr<Security> btcusdt = binance->findSecurity(MarketType::Spot, "BTC/USDT");
+
 // Create a Limit Order object
-Limit limit(btcusdt, MarketType::Spot,"2023-12-31 23:59:59.999999999", 1, 10, 0, 1, MarginType::NoMargin, 10.0, binance);
+Limit limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 10, 0, 1, MarginType::NoMargin, 10.0, binance);
 
 // Check that the Order object was created correctly
-EXPECT_EQ(limit.getSecurity(), btcusdt);
+EXPECT_TRUE(*limit.getSecurity() == *btcusdt);
 EXPECT_EQ(limit.getMarketType(), MarketType::Spot);
-EXPECT_EQ(limit.getTimestamp(), "2023-12-31 23:59:59.999999999");
+EXPECT_EQ(limit.getTimestamp(), ORDER_TEST_TIMESTAMP);
 EXPECT_EQ(limit.getOrderType(), "LIMIT");
 EXPECT_EQ(limit.getSide(), 1);
 EXPECT_EQ(limit.getBaseCurrencySize(), 10.0);
 EXPECT_EQ(limit.getQuoteCurrencySize(), 100);
 EXPECT_EQ(limit.getLeverage(), 1);
 EXPECT_EQ(limit.getMarginType(), MarginType::NoMargin);
-EXPECT_EQ(limit.getPrice(), 60850.0);
-EXPECT_EQ(limit.getExchange().getName(), binance.getName());
+EXPECT_EQ(limit.getPrice(), 10.0);
+EXPECT_EQ(limit.getExchange()->getName(), binance->getName());
+EXPECT_EQ(limit.getBookNode(), NO_BOOK_NODE);
+
+// Orders given in quote currency are rounded down to the minimum base size
+Limit quote_limit(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 0, 100, 1, MarginType::NoMargin, 60850.25, binance);
+EXPECT_NEAR(quote_limit.getBaseCurrencySize(), 0.00164, 1e-12);
+EXPECT_GT(quote_limit.getID(), limit.getID());
 }
 
 TEST(LimitOrderTest, FillabilityTest) {
+std::shared_ptr<Exchange> binance = getOrderTestExchange("Binance");
+std::shared_ptr<Security> btcusdt = binance->findSecurity(MarketType::Spot, "BTC/USDT");
+
 // Create a Limit Buy Order object
-Limit limit_buy(btcusdt, MarketType::Spot,"2023-12-31 23:59:59.999999999", 1, 10, 0, 1, MarginType::NoMargin, 60850.25, binance);
+Limit limit_buy(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 10, 0, 1, MarginType::NoMargin, 60850.25, binance);
+
+// Orders that have not reached the exchange can not fill
+EXPECT_FALSE(limit_buy.checkFillability(60849.75, 60850.25));
+limit_buy.checkOrderReceived(ORDER_TEST_TIMESTAMP + binance->getSendingLatency());
 
 // Check filability (Only should be fillable if best ask is same or lower than the buy price)
 EXPECT_FALSE(limit_buy.checkFillability(60850.25, 60850.75));
 EXPECT_TRUE(limit_buy.checkFillability(60849.75, 60850.25));
 
 // Create a Limit Sell Order object
-Limit limit_sell(btcusdt, MarketType::Spot,"2023-12-31 23:59:59.999999999", -1, 10, 0, 1, MarginType::NoMargin, 60850.25, binance);
+Limit limit_sell(btcusdt, MarketType::Spot, ORDER_TEST_TIMESTAMP, -1, 10, 0, 1, MarginType::NoMargin, 60850.25, binance);
+limit_sell.checkOrderReceived(ORDER_TEST_TIMESTAMP + binance->getSendingLatency());
 
 // Check filability (Only should be fillable if best bid is same or higher than the buy price)
 EXPECT_FALSE(limit_sell.checkFillability(60850.00, 60850.25));
@@ -116,57 +138,42 @@ EXPECT_TRUE(limit_sell.checkFillability(60850.25, 60850.75));
 }
 
 TEST(LimitOrderTest, FillOrderTest) {
+std::shared_ptr<Exchange> binance = getOrderTestExchange("Binance");
+
 // Create a Limit Buy Order object
-Limit limit(btcusdt, MarketType::Spot,"2023-12-31 23:59:59.999999999", 1, 100, 0, 1, MarginType::NoMargin, 10, binance);
+Limit limit(binance->findSecurity(MarketType::Spot, "BTC/USDT"), MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 10, 0, 1, MarginType::NoMargin, 10, binance);
+limit.checkOrderReceived(ORDER_TEST_TIMESTAMP + binance->getSendingLatency());
 
-limit.fillOrder(1, 11); // Should not fill
-EXPECT_TRUE(limit.getBaseCurrencySize() == 10 && limit.getOrderState() == OrderState::Working);
+EXPECT_THROW(limit.fillOrder(11, 10), invalid_argument);    // Should not fill
+EXPECT_THROW(limit.fillOrder(0, 10), invalid_argument);
+EXPECT_TRUE(limit.getLeverageAdjustedBaseCurrencySize() == 10 && limit.getOrderState() == OrderState::Working);
 
-limit.fillOrder(1, 4.5);
-EXPECT_TRUE(limit.getBaseCurrencySize() == 10 && limit.getOrderState() == OrderState::PartiallyFilled && limit.getFilledSize() == 4.5 && limit.isLiveOrder());
+limit.fillOrder(4.5, 10);
+EXPECT_TRUE(limit.getLeverageAdjustedBaseCurrencySize() == 5.5 && limit.getOrderState() == OrderState::PartiallyFilled && limit.getFilledSize() == 4.5 && limit.isLiveOrder());
 
-limit.fillOrder(1, 6);
-EXPECT_TRUE(limit.getBaseCurrencySize() == 10 && limit.getFilledSize() == 4.5);
+EXPECT_THROW(limit.fillOrder(6, 10), invalid_argument);
+EXPECT_TRUE(limit.getLeverageAdjustedBaseCurrencySize() == 5.5 && limit.getFilledSize() == 4.5);
 
-limit.fillOrder(1, 5.5);
-EXPECT_TRUE(limit.getBaseCurrencySize() == 10 && limit.getFilledSize() == 10 && limit.getOrderState() == OrderState::Filled && !limit.isLiveOrder());
+limit.fillOrder(5.5, 10);
+EXPECT_TRUE(limit.getLeverageAdjustedBaseCurrencySize() == 0 && limit.getOrderState() == OrderState::Filled && !limit.isLiveOrder());
 }
 
 TEST(LimitOrderTest, ModifyOrderTest) {
-// Create a Limit Buy Order object
-Limit limit(btcusdt, MarketType::Spot,"2023-12-31 23:59:59.999999999", 1, 10, 0, 1, MarginType::NoMargin, 10, binance);
+std::shared_ptr<Exchange> binance = getOrderTestExchange("Binance");
 
-limit.modifyOrder(12, 10, 10);  // Should output cerr
-EXPECT_TRUE(limit.getBaseCurrencySize() == 10 && limit.getQuoteCurrencySize() == 100);
-
-limit.modifyOrder(0, 400, 20);  // Should change base currency size to 20
-EXPECT_TRUE(limit.getBaseCurrencySize() == 20 && limit.getQuoteCurrencySize() == 400 && limit.getPrice() == 20);
-
-limit.fillOrder(1, 10);
-limit.modifyOrder(5, 0, 12);    // Should fail
-EXPECT_TRUE(limit.getBaseCurrencySize() == 20 && limit.getQuoteCurrencySize() == 400 && limit.getPrice() == 20 && limit.getFilledSize() == 10);
-limit.modifyOrder(0, 190, 12);  // Should fail
-EXPECT_TRUE(limit.getBaseCurrencySize() == 20 && limit.getQuoteCurrencySize() == 400 && limit.getPrice() == 20 && limit.getFilledSize() == 10);
-
-limit.modifyOrder(15, 0, 12);
-EXPECT_TRUE(limit.getBaseCurrencySize() == 15 && limit.getQuoteCurrencySize() == 180 && limit.getPrice() == 12 && limit.getFilledSize() == 10);
-// limit.modifyOrder(0, )
+// Create a Limit Buy Order object
+Limit limit(binance->findSecurity(MarketType::Spot, "BTC/USDT"), MarketType::Spot, ORDER_TEST_TIMESTAMP, 1, 10, 0, 1, MarginType::NoMargin, 10, binance);
+limit.checkOrderReceived(ORDER_TEST_TIMESTAMP + binance->getSendingLatency());
+
+// Invalid modifications throw and leave the order alone
+EXPECT_THROW(limit.modifyOrder(12, 0, 0), invalid_argument);
+EXPECT_THROW(limit.modifyOrder(0, 0, 10), invalid_argument);
+EXPECT_THROW(limit.modifyOrder(-1, 0, 10), invalid_argument);
+EXPECT_THROW(limit.modifyOrder(0, -1, 10), invalid_argument);
+EXPECT_TRUE(limit.getBaseCurrencySize() == 10 && limit.getQuoteCurrencySize() == 100 && limit.getPrice() == 10);
+
+// Orders that are no longer live are not modified
+limit.cancelOrder();
+limit.modifyOrder(0, 0, 0);
+EXPECT_TRUE(limit.getBaseCurrencySize() == 10 && limit.getQuoteCurrencySize() == 100 && limit.getPrice() == 10);
 }
-
-// TEST(OrderTest, FillOrderTest) {
-// // Create a Security object
-// Security security("USD", "AAPL");
-
-// // Create an Exchange object
-// Exchange exchange("NYSE", 3, 5);
-
-// // Create an Order object
-// Order order(security, "2023-12-31 23:59:59.999999999", "LIMIT", 1, 100.0, 50.0, exchange);
-
-// // Fill the order
-// order.fillOrder(50.0);
-
-// // Check that the order was filled correctly
-// EXPECT_EQ(order.getFilledSize(), 50.0);
-// EXPECT_EQ(order.getOrderState(), OrderState::PartiallyFilled);
-// }
\ No newline at end of file
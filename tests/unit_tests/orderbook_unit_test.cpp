@@ -0,0 +1,536 @@
+#include "gtest/gtest.h"
+#include "backtesting/OrderBook.h"
+#include <memory>
+
+
+/**
+ * Helper that creates a working BTC/USDT limit order on Binance.
+ */
+std::shared_ptr<Order> makeOrderBookTestOrder(int side, double size, double price) {
+    static std::shared_ptr<Exchange> exchange;
+    if (exchange == nullptr) {
+        exchange = make_shared<Exchange>("Binance");
+        exchange->loadJson("./configuration/exchange.json");
+    }
+    std::shared_ptr<Order> order = make_shared<Limit>(exchange->findSecurity(MarketType::Spot, "BTC/USDT"), MarketType::Spot, 0, side, size, 0, 1, MarginType::NoMargin, price, exchange);
+    order->checkOrderReceived(1LL << 50);
+    return order;
+}
+
+
+TEST(OrderBookTest, FillBufferTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 0.5, 100);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+OrderBook::RestingFills filled_orders;
+OrderBook::OrderFills fills{{1.0, 2.0}};
+
+// Events that fill nothing leave the buffers alone
+book.buySideUpdated(100, 2.0, filled_orders);
+book.sellSideUpdated(101, 1.0, filled_orders);
+book.sellSideUpdated(102, 3.0, filled_orders);
+book.tradeOccurred(100, 0.5, filled_orders);
+EXPECT_TRUE(filled_orders.empty());
+
+// Fills are appended after what the buffer holds
+book.fillMarketOrder(order, fills);
+ASSERT_EQ(fills.size(), 2);
+EXPECT_EQ(fills[0], make_pair(1.0, 2.0));
+EXPECT_EQ(fills[1], make_pair(101.0, 0.5));
+
+fills.clear();
+std::shared_ptr<Order> large = makeOrderBookTestOrder(1, 4.0, 102);
+book.instantFillLimit(large, 4.0, fills);
+ASSERT_EQ(fills.size(), 2);
+EXPECT_EQ(fills[0], make_pair(101.0, 0.5));
+EXPECT_EQ(fills[1], make_pair(102.0, 3.5));     // The remainder past the last level fills there
+
+// Our resting order fills when an ask update crosses it
+std::shared_ptr<Order> resting = makeOrderBookTestOrder(1, 0.5, 100);
+fills.clear();
+EXPECT_FALSE(book.addOrder(100, 1, 0.5, resting, fills));
+EXPECT_TRUE(fills.empty());
+book.sellSideUpdated(100, 1.0, filled_orders);
+ASSERT_EQ(filled_orders.size(), 1);
+EXPECT_EQ(std::get<0>(filled_orders[0]), resting);
+EXPECT_EQ(std::get<1>(filled_orders[0]), 100);
+}
+
+TEST(OrderBookTest, SweepLimitTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(-1, 5.0, 99);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+OrderBook::OrderFills fills;
+
+book.buySideUpdated(98, 1.0);
+book.buySideUpdated(99, 1.0);
+book.buySideUpdated(100, 1.0);
+book.sellSideUpdated(101, 1.0);
+
+// A limit order never fills past its price; what is left of qty fills at the last level within it
+book.instantFillLimit(order, 5.0, fills);
+ASSERT_EQ(fills.size(), 2);
+EXPECT_EQ(fills[0], make_pair(100.0, 1.0));
+EXPECT_EQ(fills[1], make_pair(99.0, 4.0));
+EXPECT_EQ(book.getLevelTotalSize(98), 1.0);
+
+// A market order walks the whole side, past the emptied levels
+fills.clear();
+std::shared_ptr<Order> market = make_shared<Market>(order->getSecurity(), MarketType::Spot, 0, -1, 2.0, 0, 1, MarginType::NoMargin, 98, order->getExchange());
+market->checkOrderReceived(1LL << 50);
+book.fillMarketOrder(market, fills);
+ASSERT_EQ(fills.size(), 1);
+EXPECT_EQ(fills[0], make_pair(98.0, 2.0));
+}
+
+TEST(OrderBookTest, SweepToLimitTickTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 2.0, 102);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+OrderBook::OrderFills fills;
+
+book.buySideUpdated(100, 1.0);
+book.sellSideUpdated(101, 1.0);
+book.sellSideUpdated(102, 2.0);
+book.sellSideUpdated(103, 1.0);
+
+// The sweep takes part of the level at the limit tick and leaves the rest as the new touch
+book.instantFillLimit(order, 2.0, fills);
+ASSERT_EQ(fills.size(), 2);
+EXPECT_EQ(fills[0], make_pair(101.0, 1.0));
+EXPECT_EQ(fills[1], make_pair(102.0, 1.0));
+EXPECT_EQ(book.getBestAsk(), 102);
+EXPECT_EQ(book.getLevelTotalSize(102), 1.0);
+EXPECT_EQ(book.getLevelTotalSize(103), 1.0);
+EXPECT_EQ(book.getNumReclaimedLevels(), 1);
+EXPECT_EQ(book.getLimitInstantFillQuantity(102, 1), 1.0);
+}
+
+TEST(OrderBookTest, MarketSweepTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 0.5, 100);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+OrderBook::OrderFills fills;
+
+book.sellSideUpdated(101, 1.0);
+book.sellSideUpdated(102, 2.0);
+book.sellSideUpdated(103, 1.0);
+book.addOrder(100, 1, 0.5, order);
+
+// A market buy walks the asks from the touch and leaves the bids alone
+std::shared_ptr<Order> market = make_shared<Market>(order->getSecurity(), MarketType::Spot, 0, 1, 3.5, 0, 1, MarginType::NoMargin, 101, order->getExchange());
+market->checkOrderReceived(1LL << 50);
+book.fillMarketOrder(market, fills);
+ASSERT_EQ(fills.size(), 3);
+EXPECT_EQ(fills[0], make_pair(101.0, 1.0));
+EXPECT_EQ(fills[1], make_pair(102.0, 2.0));
+EXPECT_EQ(fills[2], make_pair(103.0, 0.5));
+EXPECT_EQ(book.getBestAsk(), 103);
+EXPECT_EQ(book.getLevelTotalSize(103), 0.5);
+EXPECT_EQ(book.getBestBid(), 100);
+EXPECT_EQ(book.getQueueAhead(order), 0.0);
+
+// Past the last level, the rest of the order fills there and the side is left empty
+fills.clear();
+std::shared_ptr<Order> large = make_shared<Market>(order->getSecurity(), MarketType::Spot, 0, 1, 2.0, 0, 1, MarginType::NoMargin, 103, order->getExchange());
+large->checkOrderReceived(1LL << 50);
+book.fillMarketOrder(large, fills);
+ASSERT_EQ(fills.size(), 1);
+EXPECT_EQ(fills[0], make_pair(103.0, 2.0));
+EXPECT_EQ(book.getBestAsk(), -1);
+EXPECT_EQ(book.getNumLevels(), 1);
+
+// With nothing left to fill against the sweep throws, for market and limit orders alike
+EXPECT_THROW(book.fillMarketOrder(large), invalid_argument);
+EXPECT_THROW(book.instantFillLimit(makeOrderBookTestOrder(1, 1.0, 103), 1.0), invalid_argument);
+}
+
+TEST(OrderBookTest, DepthPolicyTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 0.5, 97);
+BasicOrderBook<TopLevels<2>> book(order->getExchange(), MarketType::Spot, order->getSecurity());
+
+book.buySideUpdated(100, 1.0);
+book.buySideUpdated(99, 1.0);
+book.buySideUpdated(98, 1.0);        // Past the depth kept: ignored
+EXPECT_EQ(book.getNumLevels(), 2);
+EXPECT_EQ(book.getLevelTotalSize(98), 0.0);
+EXPECT_EQ(book.getNumDroppedLevels(), 0);
+
+// A better level pushes the worst one out
+book.buySideUpdated(101, 1.0);
+EXPECT_EQ(book.getNumLevels(), 2);
+EXPECT_EQ(book.getLevelTotalSize(99), 0.0);
+EXPECT_EQ(book.getNumDroppedLevels(), 1);
+EXPECT_EQ(book.getLimitInstantFillQuantity(99, -1), 2.0);
+
+// A level holding our order is kept whatever its rank
+book.addOrder(97, 1, 0.5, order);
+book.buySideUpdated(102, 1.0);
+EXPECT_EQ(book.getNumLevels(), 3);
+EXPECT_EQ(book.getLevelTotalSize(97), 0.5);
+EXPECT_EQ(book.getLevelTotalSize(100), 0.0);
+EXPECT_EQ(book.getQueueAhead(order), 0.0);
+
+// An ask crossing the bids leaves the remaining bids within the depth
+book.sellSideUpdated(101, 1.0);
+EXPECT_EQ(book.getBestBid(), 97);
+EXPECT_EQ(book.getBestAsk(), 101);
+
+BasicOrderBook<TopOfBook> top(order->getExchange(), MarketType::Spot, order->getSecurity());
+for (int level = 0; level < 10; ++level) {
+    top.buySideUpdated(100 - level, 1.0);
+    top.sellSideUpdated(110 - level, 1.0);
+}
+EXPECT_EQ(top.getNumLevels(), 2);
+EXPECT_EQ(top.getBestBid(), 100);
+EXPECT_EQ(top.getBestAsk(), 101);
+EXPECT_EQ(top.getNumDroppedLevels(), 9);
+}
+
+TEST(OrderBookTest, ReclaimTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 0.5, 98);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+
+book.buySideUpdated(100, 1.0);
+book.buySideUpdated(99, 1.0);
+book.sellSideUpdated(101, 1.0);
+book.sellSideUpdated(102, 1.0);
+book.addOrder(98, 1, 0.5, order);
+
+// A zero size update erases the level and the touch moves past it
+book.buySideUpdated(100, 0.0);
+EXPECT_EQ(book.getNumLevels(), 4);
+EXPECT_EQ(book.getBestBid(), 99);
+EXPECT_EQ(book.getNumReclaimedLevels(), 1);
+
+// A trade taking the whole level erases it
+book.tradeOccurred(99, 1.0);
+EXPECT_EQ(book.getBestBid(), 98);
+EXPECT_EQ(book.getLevelTotalSize(98), 0.5);     // Our order keeps its level
+
+// Crossed levels are removed, not left empty on the other side
+book.buySideUpdated(102, 2.0);
+EXPECT_EQ(book.getNumLevels(), 2);
+EXPECT_EQ(book.getBestBid(), 102);
+EXPECT_EQ(book.getBestAsk(), -1);
+EXPECT_EQ(book.getNumCrossedLevels(), 2);
+
+// A sweep erases the levels it empties
+std::shared_ptr<Order> market = make_shared<Market>(order->getSecurity(), MarketType::Spot, 0, -1, 2.0, 0, 1, MarginType::NoMargin, 102, order->getExchange());
+market->checkOrderReceived(1LL << 50);
+book.fillMarketOrder(market);
+EXPECT_EQ(book.getBestBid(), 98);
+EXPECT_EQ(book.getNumLevels(), 1);
+
+book.removeOrder(order);
+EXPECT_EQ(book.getNumLevels(), 0);
+EXPECT_EQ(book.getBestBid(), -1);
+EXPECT_EQ(book.getNumReclaimedLevels(), 4);
+}
+
+TEST(OrderBookTest, SnapshotTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(-1, 0.5, 102);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+
+book.buySideUpdated(100, 1.0);
+book.buySideUpdated(99, 1.0);
+book.buySideUpdated(98, 1.0);
+book.buySideUpdated(96, 1.0);
+book.sellSideUpdated(102, 1.0);
+book.sellSideUpdated(103, 1.0);
+book.sellSideUpdated(105, 1.0);
+book.addOrder(102, -1, 0.5, order);
+
+// The best bid of the snapshot takes the ask holding our order
+double bid_prices[3] = {102, 100, 98}, bid_sizes[3] = {2.0, 3.0, 0.0};
+double ask_prices[3] = {103, 104, 106}, ask_sizes[3] = {1.0, 1.5, 1.0};
+auto fills = book.applySnapshot(bid_prices, bid_sizes, ask_prices, ask_sizes, 3);
+ASSERT_EQ(fills.size(), 1);
+EXPECT_EQ(std::get<0>(fills[0]), order);
+EXPECT_EQ(std::get<1>(fills[0]), 102);
+
+// Levels up to the last one listed are replaced; the bid at 96 lies past it and is kept
+EXPECT_EQ(book.getBestBid(), 102);
+EXPECT_EQ(book.getBestAsk(), 103);
+EXPECT_EQ(book.getLevelTotalSize(102), 2.0);
+EXPECT_EQ(book.getLevelTotalSize(100), 3.0);
+EXPECT_EQ(book.getLevelTotalSize(99), 0.0);
+EXPECT_EQ(book.getLevelTotalSize(98), 0.0);
+EXPECT_EQ(book.getLevelTotalSize(96), 1.0);
+EXPECT_EQ(book.getLevelTotalSize(104), 1.5);
+EXPECT_EQ(book.getLevelTotalSize(105), 0.0);
+EXPECT_EQ(book.getNumLevels(), 6);
+EXPECT_EQ(book.getLimitInstantFillQuantity(104, 1), 2.5);
+
+// A side with no positive price is left alone
+double no_prices[3] = {0, 0, 0};
+book.applySnapshot(no_prices, bid_sizes, ask_prices, ask_sizes, 3);
+EXPECT_EQ(book.getBestBid(), 102);
+
+// Locked, crossed or unordered snapshots are dropped and counted before the book changes
+double locked_asks[3] = {102, 103, 104};
+EXPECT_TRUE(book.applySnapshot(bid_prices, bid_sizes, locked_asks, ask_sizes, 3).empty());
+double crossed_asks[3] = {101, 103, 104};
+EXPECT_NO_THROW(book.applySnapshot(bid_prices, bid_sizes, crossed_asks, ask_sizes, 3));
+double snapped_bids[3] = {103.004, 100, 0}, snapped_asks[3] = {102.996, 104, 0};
+EXPECT_NO_THROW(book.applySnapshot(snapped_bids, bid_sizes, snapped_asks, ask_sizes, 3));
+double unordered_bids[3] = {101, 102, 0};
+EXPECT_NO_THROW(book.applySnapshot(unordered_bids, bid_sizes, ask_prices, ask_sizes, 3));
+EXPECT_EQ(book.getNumRejectedSnapshots(), 4);
+EXPECT_EQ(book.getNumLevels(), 6);
+EXPECT_EQ(book.getBestBid(), 102);
+EXPECT_EQ(book.getBestAsk(), 103);
+EXPECT_EQ(book.getLevelTotalSize(102), 2.0);
+EXPECT_EQ(book.getLevelTotalSize(103), 1.0);
+}
+
+TEST(OrderBookTest, FeaturesTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(-1, 0.5, 101);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+EXPECT_EQ(book.getFeatures().mid, -1);
+
+book.buySideUpdated(100, 1.0);
+EXPECT_EQ(book.getFeatures().bid_price, 100);
+EXPECT_EQ(book.getFeatures().spread, -1);     // One side only
+book.buySideUpdated(99, 3.0);
+book.sellSideUpdated(101, 3.0);
+book.sellSideUpdated(102, 1.0);
+
+const BookFeatures& features = book.getFeatures();
+EXPECT_EQ(features.spread, 1.0);
+EXPECT_EQ(features.mid, 100.5);
+EXPECT_EQ(features.microprice, 100.25);
+EXPECT_EQ(features.imbalance, -0.5);
+EXPECT_EQ(features.bid_depth, 4.0);
+EXPECT_EQ(features.depth_imbalance, 0.0);
+EXPECT_EQ(features.weighted_mid, 100.25);
+
+// Depth past the best BOOK_FEATURE_LEVELS levels is not covered
+for (double price : {98, 97, 96, 95}) {
+    book.buySideUpdated(price, 1.0);
+}
+EXPECT_EQ(features.bid_depth, 7.0);
+book.buySideUpdated(95, 2.0);
+EXPECT_EQ(features.bid_depth, 7.0);
+
+// A trade taking the best bid moves the levels covered; our orders count
+book.tradeOccurred(100, 1.0);
+EXPECT_EQ(features.bid_price, 99);
+EXPECT_EQ(features.bid_depth, 8.0);
+book.addOrder(101, -1, 0.5, order);
+EXPECT_EQ(features.ask_size, 3.5);
+EXPECT_EQ(features.ask_depth, 4.5);
+book.removeOrder(order);
+EXPECT_EQ(features.ask_size, 3.0);
+
+// An update crossing the other side refreshes both
+book.sellSideUpdated(99, 1.0);
+EXPECT_EQ(features.bid_price, 98);
+EXPECT_EQ(features.ask_price, 99);
+EXPECT_EQ(features.ask_depth, 5.0);
+}
+
+TEST(OrderBookTest, FeaturesTopLevelsTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 0.5, 100);
+BasicOrderBook<TopLevels<8>> book(order->getExchange(), MarketType::Spot, order->getSecurity());
+book.sellSideUpdated(101, 1.0);
+book.buySideUpdated(100, 1.0);
+double size = 2.0;
+for (double price : {98, 97, 96, 95, 94, 93, 92}) {
+    book.buySideUpdated(price, size++);
+}
+const BookFeatures& features = book.getFeatures();
+EXPECT_EQ(book.getNumLevels(), 9);
+EXPECT_EQ(features.bid_depth, 15.0);
+
+// A new level inside the feature depth pushes the worst bid out, so the number of levels and the best bid stay the
+// same; the levels covered are taken again
+book.buySideUpdated(99, 10.0);
+EXPECT_EQ(book.getNumLevels(), 9);
+EXPECT_EQ(book.getNumDroppedLevels(), 1);
+EXPECT_EQ(book.getLevelTotalSize(92), 0.0);
+EXPECT_EQ(features.bid_price, 100);
+EXPECT_EQ(features.bid_depth, 20.0);
+
+// The same past the feature depth leaves the features alone
+book.buySideUpdated(93.5, 1.0);
+EXPECT_EQ(book.getNumDroppedLevels(), 2);
+EXPECT_EQ(features.bid_depth, 20.0);
+EXPECT_EQ(book.getLevelTotalSize(96), 4.0);
+EXPECT_EQ(book.getLevelTotalSize(94), 6.0);
+EXPECT_EQ(book.getLevelTotalSize(93), 0.0);
+}
+
+TEST(OrderBookTest, LevelAggregatesTest) {
+std::shared_ptr<Order> first = makeOrderBookTestOrder(1, 0.5, 100);
+std::shared_ptr<Order> second = makeOrderBookTestOrder(1, 0.25, 100);
+OrderBook book(first->getExchange(), MarketType::Spot, first->getSecurity());
+
+book.buySideUpdated(100, 2.0);
+book.addOrder(100, 1, 0.5, first);
+book.buySideUpdated(100, 3.5);
+book.addOrder(100, 1, 0.25, second);
+EXPECT_EQ(book.getLevelTotalSize(100), 3.75);
+EXPECT_EQ(book.getLevelNotOurOrderTotalSize(100), 3.0);
+EXPECT_EQ(book.getLevelOurOrderTotalSize(100), 0.75);
+EXPECT_EQ(book.getNumOurOrders(100), 2);
+EXPECT_EQ(book.getQueueAhead(first), 2.0);
+EXPECT_EQ(book.getQueueAhead(second), 3.0);
+
+// Reducing takes the market size between our orders to zero, then some of the size ahead of both; our orders stay
+book.buySideUpdated(100, 1.75);
+EXPECT_EQ(book.getLevelTotalSize(100), 1.75);
+EXPECT_EQ(book.getLevelNotOurOrderTotalSize(100), 1.0);
+EXPECT_EQ(book.getLevelOurOrderTotalSize(100), 0.75);
+EXPECT_EQ(book.getNumOurOrders(100), 2);
+EXPECT_EQ(book.getQueueAhead(first), 1.0);
+EXPECT_EQ(book.getQueueAhead(second), 1.0);
+
+// Reducing all market size leaves our orders at the front
+book.buySideUpdated(100, 0.75);
+EXPECT_EQ(book.getLevelNotOurOrderTotalSize(100), 0.0);
+EXPECT_EQ(book.getLevelOurOrderTotalSize(100), 0.75);
+EXPECT_EQ(book.getQueueAhead(second), 0.0);
+
+// Erasing our orders takes them off the totals; the last one takes the level with it
+EXPECT_TRUE(book.removeOrder(first));
+EXPECT_EQ(book.getLevelTotalSize(100), 0.25);
+EXPECT_EQ(book.getLevelOurOrderTotalSize(100), 0.25);
+EXPECT_EQ(book.getNumOurOrders(100), 1);
+EXPECT_TRUE(book.removeOrder(second));
+EXPECT_EQ(book.getLevelTotalSize(100), 0.0);
+EXPECT_EQ(book.getNumOurOrders(100), 0);
+EXPECT_EQ(book.getNumLevels(), 0);
+}
+
+TEST(OrderBookTest, BestBidAskTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 0.5, 101);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+EXPECT_EQ(book.getBestBid(), -1);
+EXPECT_EQ(book.getBestAsk(), -1);
+
+book.buySideUpdated(100, 1.0);
+book.buySideUpdated(99, 1.0);
+book.buySideUpdated(98, 1.0);
+book.sellSideUpdated(103, 1.0);
+book.sellSideUpdated(104, 1.0);
+book.sellSideUpdated(105, 1.0);
+EXPECT_EQ(book.getBestBid(), 100);
+EXPECT_EQ(book.getBestAsk(), 103);
+
+// A trade taking the whole best level
+book.tradeOccurred(103, 1.0);
+EXPECT_EQ(book.getBestAsk(), 104);
+
+// A depth update to 0 at the best level
+book.buySideUpdated(100, 0.0);
+EXPECT_EQ(book.getBestBid(), 99);
+
+// A bid crossing the best ask takes it over
+book.buySideUpdated(104, 2.0);
+EXPECT_EQ(book.getBestBid(), 104);
+EXPECT_EQ(book.getBestAsk(), 105);
+
+// An ask crossing the bids leaves the next bid below it as the best bid
+book.sellSideUpdated(99, 1.0);
+EXPECT_EQ(book.getBestBid(), 98);
+EXPECT_EQ(book.getBestAsk(), 99);
+
+// Cancelling our only order at the best bid
+book.sellSideUpdated(99, 0.0);
+book.addOrder(101, 1, 0.5, order);
+EXPECT_EQ(book.getBestBid(), 101);
+EXPECT_EQ(book.getBestAsk(), 105);
+book.cancelOrder(order);
+EXPECT_EQ(book.getBestBid(), 98);
+EXPECT_EQ(book.getBestAsk(), 105);
+}
+
+TEST(OrderBookTest, OverflowLevelsTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(-1, 4.0, 100);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+OrderBook::OrderFills fills;
+
+// 1000 and 100 lie 90000 ticks apart, more than a ladder window covers, so one of them sits in the overflow map
+book.buySideUpdated(1000, 1.0);
+book.buySideUpdated(999, 1.0);
+book.buySideUpdated(100, 2.0);
+book.sellSideUpdated(1001, 1.0);
+book.sellSideUpdated(2000, 3.0);
+EXPECT_EQ(book.getNumLevels(), 5);
+EXPECT_EQ(book.getBestBid(), 1000);
+EXPECT_EQ(book.getBestAsk(), 1001);
+EXPECT_EQ(book.getLevelTotalSize(100), 2.0);
+EXPECT_EQ(book.getLevelTotalSize(2000), 3.0);
+EXPECT_EQ(book.getLimitInstantFillQuantity(2000, 1), 4.0);
+EXPECT_EQ(book.getSweepPrice(1, 2.0), 2000);
+EXPECT_EQ(book.getSweepPrice(-1, 4.0), 100);
+
+// The touch moves between the window and the overflow map
+book.sellSideUpdated(1001, 0.0);
+EXPECT_EQ(book.getBestAsk(), 2000);
+book.buySideUpdated(1000, 0.0);
+book.buySideUpdated(999, 0.0);
+EXPECT_EQ(book.getBestBid(), 100);
+book.buySideUpdated(999, 1.0);
+EXPECT_EQ(book.getBestBid(), 999);
+
+// A sweep walks from one into the other
+book.instantFillLimit(order, 3.0, fills);
+ASSERT_EQ(fills.size(), 2);
+EXPECT_EQ(fills[0], make_pair(999.0, 1.0));
+EXPECT_EQ(fills[1], make_pair(100.0, 2.0));
+EXPECT_EQ(book.getBestBid(), -1);
+EXPECT_EQ(book.getNumLevels(), 1);
+}
+
+TEST(OrderBookTest, TickRoundingTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 0.5, 100);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+
+// Prices that are not tick multiples go to the nearest tick of 0.01
+book.buySideUpdated(100.004, 1.0);
+book.buySideUpdated(99.996, 2.0);
+EXPECT_EQ(book.getNumLevels(), 1);
+EXPECT_EQ(book.getLevelTotalSize(100), 2.0);
+EXPECT_EQ(book.getBestBid(), 100);
+
+book.sellSideUpdated(100.006, 1.0);
+EXPECT_EQ(book.getBestAsk(), 100.01);
+EXPECT_EQ(book.getLevelTotalSize(100.01), 1.0);
+EXPECT_EQ(book.getLevelTotalSize(100.0149), 1.0);
+
+// Prices carrying floating point error land on their tick
+book.tradeOccurred(100.0 + 0.01, 1.0);
+EXPECT_EQ(book.getBestAsk(), -1);
+book.addOrder(99.99 + 0.01, 1, 0.5, order);
+EXPECT_EQ(book.getLevelTotalSize(100), 2.5);
+EXPECT_EQ(book.getQueueAhead(order), 2.0);
+}
+
+TEST(OrderBookTest, ReAddOrderTest) {
+std::shared_ptr<Order> order = makeOrderBookTestOrder(1, 0.5, 100);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+book.sellSideUpdated(101, 1.0);
+
+// Adding the same order twice at an otherwise empty level leaves one entry of its size
+book.addOrder(100, 1, 0.5, order);
+book.addOrder(100, 1, 0.5, order);
+EXPECT_EQ(book.getLevelTotalSize(100), 0.5);
+EXPECT_EQ(book.getLevelOurOrderTotalSize(100), 0.5);
+EXPECT_EQ(book.getNumOurOrders(100), 1);
+
+// A trade through the level fills it once
+auto fills = book.tradeOccurred(100, 2.0);
+ASSERT_EQ(fills.size(), 1);
+EXPECT_EQ(std::get<0>(fills[0]), order);
+EXPECT_EQ(std::get<2>(fills[0]), 0.5);
+EXPECT_EQ(book.getLevelTotalSize(100), 0.0);
+
+// Re-adding with a new size replaces the size, in the last position and elsewhere
+std::shared_ptr<Order> other = makeOrderBookTestOrder(1, 0.5, 99);
+book.addOrder(99, 1, 0.5, other);
+book.addOrder(99, 1, 0.3, other);
+EXPECT_DOUBLE_EQ(book.getLevelOurOrderTotalSize(99), 0.3);
+book.buySideUpdated(99, 1.3);
+book.addOrder(99, 1, 0.2, other);
+EXPECT_DOUBLE_EQ(book.getLevelOurOrderTotalSize(99), 0.2);
+EXPECT_EQ(book.getQueueAhead(other), 1.0);
+EXPECT_EQ(book.getNumOurOrders(99), 1);
+}
@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+#include "backtesting/OrderBook.h"
+#include <memory>
+
+
+/**
+ * Helper that creates a working BTC/USDT limit order on Binance.
+ */
+std::shared_ptr<Order> makeOrderQueueTestOrder(int side, double size, double price) {
+    static std::shared_ptr<Exchange> exchange;
+    if (exchange == nullptr) {
+        exchange = make_shared<Exchange>("Binance");
+        exchange->loadJson("./configuration/exchange.json");
+    }
+    std::shared_ptr<Order> order = make_shared<Limit>(exchange->findSecurity(MarketType::Spot, "BTC/USDT"), MarketType::Spot, 0, side, size, 0, 1, MarginType::NoMargin, price, exchange);
+    order->checkOrderReceived(1LL << 50);
+    return order;
+}
+
+
+TEST(OrderQueueTest, QueueAheadTest) {
+OrderNodePool pool;
+OrderQueue queue;
+std::shared_ptr<Order> first = makeOrderQueueTestOrder(1, 0.5, 100);
+std::shared_ptr<Order> second = makeOrderQueueTestOrder(1, 0.25, 100);
+
+queue.addMarket(1.0);
+queue.addMarket(2.0);
+queue.push(pool, 0.5, first, 10000);
+queue.addMarket(3.0);
+queue.push(pool, 0.25, second, 10000);
+queue.addMarket(4.0);
+EXPECT_EQ(pool.size(), 2);
+EXPECT_EQ(queue.num_our_orders, 2);
+EXPECT_EQ(queue.market_size, 10.0);
+EXPECT_EQ(queue.our_size, 0.75);
+
+// Our orders know their node and the market size ahead of them
+uint32_t node = first->getBookNode();
+ASSERT_NE(node, NO_BOOK_NODE);
+EXPECT_EQ(pool[node].order, first);
+EXPECT_EQ(pool[node].ahead, 3.0);
+EXPECT_EQ(pool[second->getBookNode()].ahead, 6.0);
+EXPECT_FALSE(queue.endsWith(pool, second));
+
+// Cancels come off the back: the size behind our orders first, then the size between them
+queue.reduceMarket(pool, 5.0);
+EXPECT_EQ(queue.market_size, 5.0);
+EXPECT_EQ(pool[node].ahead, 3.0);
+EXPECT_EQ(pool[second->getBookNode()].ahead, 5.0);
+EXPECT_TRUE(queue.endsWith(pool, second));
+
+// Trades come off the front and move every order up
+queue.fillMarket(pool, 2.0);
+EXPECT_EQ(queue.market_size, 3.0);
+EXPECT_EQ(pool[node].ahead, 1.0);
+EXPECT_EQ(pool[second->getBookNode()].ahead, 3.0);
+
+queue.resize(pool, node, 0.2);
+EXPECT_DOUBLE_EQ(queue.our_size, 0.45);
+queue.reduce(pool, node, 0.2);      // Reducing to zero removes the entry
+EXPECT_EQ(first->getBookNode(), NO_BOOK_NODE);
+EXPECT_EQ(queue.head, queue.tail);
+EXPECT_EQ(queue.our_size, 0.25);
+
+queue.erase(pool, second->getBookNode());
+EXPECT_EQ(second->getBookNode(), NO_BOOK_NODE);
+EXPECT_EQ(queue.num_our_orders, 0);
+EXPECT_EQ(queue.our_size, 0.0);
+EXPECT_FALSE(queue.empty());
+
+queue.clear(pool);
+EXPECT_TRUE(queue.empty());
+EXPECT_EQ(pool.size(), 0);
+}
+
+TEST(OrderQueueTest, PoolReuseTest) {
+OrderNodePool pool;
+OrderQueue queue;
+
+for (int i = 0; i < 100; ++i) {
+    queue.addMarket(1.0);
+    queue.push(pool, 1.0, makeOrderQueueTestOrder(1, 0.1, 100), 10000);
+}
+size_t capacity = pool.getCapacity();
+EXPECT_EQ(capacity, 100);
+
+// Nodes are handed out again once released, so the pool stops growing
+for (int round = 0; round < 10; ++round) {
+    queue.clear(pool);
+    for (int i = 0; i < 200; ++i) {
+        if (i % 2) {
+            queue.addMarket(1.0);
+        } else {
+            queue.push(pool, 1.0, makeOrderQueueTestOrder(1, 0.1, 100), 10000);
+        }
+    }
+}
+EXPECT_EQ(pool.size(), 100);
+EXPECT_EQ(pool.getCapacity(), capacity);
+}
+
+TEST(OrderQueueTest, OrderBookCancelTest) {
+std::shared_ptr<Order> order = makeOrderQueueTestOrder(1, 0.5, 100);
+OrderBook book(order->getExchange(), MarketType::Spot, order->getSecurity());
+
+book.buySideUpdated(100, 2.0);
+book.addOrder(100, 1, 0.5, order);
+EXPECT_EQ(book.getLevelTotalSize(100), 2.5);
+EXPECT_EQ(book.getQueueAhead(order), 2.0);
+
+// Depth added behind our order leaves its position alone
+book.buySideUpdated(100, 3.5);
+EXPECT_EQ(book.getQueueAhead(order), 2.0);
+book.buySideUpdated(100, 2.5);
+EXPECT_EQ(book.getQueueAhead(order), 2.0);
+
+// A trade fills the market order ahead of ours first
+auto fills = book.tradeOccurred(100, 2.1);
+ASSERT_EQ(fills.size(), 1);
+EXPECT_EQ(std::get<0>(fills[0]), order);
+EXPECT_NEAR(std::get<2>(fills[0]), 0.1, 1e-12);
+
+EXPECT_TRUE(book.modifyOrder(order, 0.3));
+EXPECT_DOUBLE_EQ(book.getLevelTotalSize(100), 0.3);
+
+book.cancelOrder(order);
+EXPECT_EQ(order->getOrderState(), OrderState::Cancelled);
+EXPECT_EQ(book.getLevelTotalSize(100), 0.0);
+EXPECT_FALSE(book.removeOrder(order));
+EXPECT_EQ(book.getQueueAhead(order), -1.0);
+EXPECT_FALSE(book.modifyOrder(order, 0.1));
+
+// Nothing rests at the level any more, so it is reclaimed
+EXPECT_EQ(book.getBestBid(), -1);
+EXPECT_EQ(book.getNumLevels(), 0);
+}
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "data/marketdata.h"
+#include "data/parallelcsv.h"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+
+/**
+ * Helper that writes a market data file with trades of instruments appearing at different points of the file.
+ */
+string writeParallelData(const string& name, int num_rows, const string& last_row) {
+    string path = (std::filesystem::temp_directory_path() / name).string();
+    const char* symbols[] = {"BTC/USDT", "ETH/USDT", "SOL/USDT", "XRP/USDT"};
+    ofstream file(path, ios::binary);
+
+    file << "HEADER\n";
+    for (int i = 0; i < num_rows; ++i) {
+        file << "2023-01-03 09:00:00." << setw(9) << setfill('0') << i << "," << i << ",T," << symbols[i * i % (1 + i / 500) % 4] << ",Binance,S,"
+                << 16800 + i << ".5,0.25\n";
+    }
+    file << last_row;
+    return path;
+}
+
+
+TEST(ParallelCsvEventSourceTest, SameEventsTest) {
+string path = writeParallelData("parallel_events.csv", 3000, "2023-01-03 09:00:01.000000000,0,T,XRP/USDT,Binance,S,1,1");
+
+for (size_t num_threads : {1, 3}) {
+    CsvEventSource direct(path);
+    ParallelCsvEventSource parallel(path, num_threads, 1000);
+    EXPECT_GT(parallel.getNumRanges(), 100);
+
+    MarketEvent expected, event;
+    while (direct.nextEvent(expected)) {
+        ASSERT_TRUE(parallel.nextEvent(event));
+        ASSERT_EQ(memcmp(&event, &expected, sizeof(MarketEvent)), 0);
+    }
+    EXPECT_FALSE(parallel.nextEvent(event));
+
+    // Instrument ids are assigned in order of first appearance, as in the sequential reader
+    ASSERT_EQ(parallel.getInstruments().size(), direct.getInstruments().size());
+    for (uint16_t id = 0; id < direct.getInstruments().size(); ++id) {
+        EXPECT_EQ(parallel.getInstruments().at(id).symbol, direct.getInstruments().at(id).symbol);
+    }
+}
+}
+
+TEST(ParallelCsvEventSourceTest, ErrorAndEarlyStopTest) {
+// Errors surface after the events of the rows before them
+ParallelCsvEventSource failing(writeParallelData("parallel_error.csv", 2000, "2023-01-03 09:00:01.000000000,0,T,BTC/USDT,Binance,S,abc,1\n"), 2, 1000);
+MarketEvent event;
+for (int i = 0; i < 2000; ++i) {
+    ASSERT_TRUE(failing.nextEvent(event));
+}
+EXPECT_THROW(failing.nextEvent(event), invalid_argument);
+
+// Destroying the source while workers wait for free slots must not hang
+{
+    ParallelCsvEventSource abandoned(writeParallelData("parallel_stop.csv", 2000, ""), 2, 100);
+    ASSERT_TRUE(abandoned.nextEvent(event));
+}
+
+// Empty file
+ParallelCsvEventSource empty(writeParallelData("parallel_empty.csv", 0, ""));
+EXPECT_FALSE(empty.nextEvent(event));
+}
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "data/marketdata.h"
+#include "data/pipeline.h"
+#include "data/spscring.h"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <thread>
+
+
+/**
+ * Helper that writes a market data file with trades of several instruments to the temporary directory.
+ */
+string writePipelineData(const string& name, int num_rows, bool bad_last_row) {
+    string path = (std::filesystem::temp_directory_path() / name).string();
+    const char* symbols[] = {"BTC/USDT", "ETH/USDT", "SOL/USDT"};
+    ofstream file(path, ios::binary);
+
+    file << "HEADER\n";
+    for (int i = 0; i < num_rows; ++i) {
+        file << "2023-01-03 09:00:00." << setw(9) << setfill('0') << i << "," << i << ",T," << symbols[i * 7 % 3] << ",Binance,S," << 16800 + i << ",0.5\n";
+    }
+    if (bad_last_row) {
+        file << "2023-01-03 09:00:01.000000000,0,T,BTC/USDT,Binance,S,abc,0.5\n";
+    }
+    return path;
+}
+
+
+TEST(SpscRingTest, TransferInOrderTest) {
+SpscRing<int> ring(5);
+EXPECT_EQ(ring.getCapacity(), 8);
+
+const int num_items = 200000;
+thread producer([&ring]() {
+    for (int i = 0; i < num_items; ++i) {
+        while (!ring.tryPush(i)) {
+            this_thread::yield();
+        }
+    }
+});
+
+int item = -1;
+for (int expected = 0; expected < num_items; ++expected) {
+    while (!ring.tryPop(item)) {
+        this_thread::yield();
+    }
+    ASSERT_EQ(item, expected);
+}
+producer.join();
+EXPECT_FALSE(ring.tryPop(item));
+}
+
+TEST(PipelinedEventSourceTest, SameEventsTest) {
+string path = writePipelineData("pipeline_events.csv", 5000, false);
+CsvEventSource direct(path);
+PipelinedEventSource pipelined(make_unique<CsvEventSource>(path), 16);
+
+MarketEvent expected, event;
+while (direct.nextEvent(expected)) {
+    ASSERT_TRUE(pipelined.nextEvent(event));
+    ASSERT_EQ(memcmp(&event, &expected, sizeof(MarketEvent)), 0);
+    const Instrument& instrument = pipelined.getInstruments().at(event.instrument_id);
+    EXPECT_EQ(instrument.symbol, direct.getInstruments().at(expected.instrument_id).symbol);
+}
+EXPECT_FALSE(pipelined.nextEvent(event));
+EXPECT_EQ(pipelined.getInstruments().size(), 3);
+}
+
+TEST(PipelinedEventSourceTest, ErrorAndEarlyStopTest) {
+// Errors surface on the consuming thread after the events before them
+PipelinedEventSource failing(make_unique<CsvEventSource>(writePipelineData("pipeline_error.csv", 100, true)));
+MarketEvent event;
+for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(failing.nextEvent(event));
+}
+EXPECT_THROW(failing.nextEvent(event), invalid_argument);
+
+// Destroying the source while the parser thread waits on a full ring must not hang
+{
+    PipelinedEventSource abandoned(make_unique<CsvEventSource>(writePipelineData("pipeline_stop.csv", 1000, false)), 4);
+    ASSERT_TRUE(abandoned.nextEvent(event));
+}
+}
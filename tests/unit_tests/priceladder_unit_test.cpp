@@ -0,0 +1,167 @@
+#include "gtest/gtest.h"
+#include "backtesting/priceladder.h"
+#include <map>
+#include <random>
+
+
+TEST(PriceLadderTest, TickConversionTest) {
+PriceLadder<int> cents(0.01);
+EXPECT_EQ(cents.toTick(16800.01), 1680001);
+EXPECT_EQ(cents.toPrice(1680001), 16800.01);
+EXPECT_EQ(cents.toTick(16800.014), 1680001);     // Snapped to the tick grid
+
+PriceLadder<int> satoshis(0.00000001);
+EXPECT_EQ(satoshis.toTick(0.00001234), 1234);
+EXPECT_EQ(satoshis.toPrice(1234), 0.00001234);
+
+PriceLadder<int> fives(5);
+EXPECT_EQ(fives.toTick(16805), 3361);
+EXPECT_EQ(fives.toPrice(3361), 16805);
+
+EXPECT_THROW(PriceLadder<int>(0), invalid_argument);
+EXPECT_THROW(PriceLadder<int>(-0.01), invalid_argument);
+}
+
+TEST(PriceLadderTest, NeighbourTest) {
+PriceLadder<int> ladder(0.01);
+EXPECT_EQ(ladder.lowest(), PRICE_LADDER_NO_TICK);
+EXPECT_EQ(ladder.highest(), PRICE_LADDER_NO_TICK);
+EXPECT_EQ(ladder.find(100), nullptr);
+
+bool created;
+ladder.insert(100, created) = 1;
+EXPECT_TRUE(created);
+ladder.insert(100, created) = 2;
+EXPECT_FALSE(created);
+ladder.insert(105) = 3;
+ladder.insert(1000000) = 4;     // Far away, outside the window
+
+EXPECT_EQ(ladder.size(), 3);
+EXPECT_EQ(*ladder.find(100), 2);
+EXPECT_EQ(*ladder.find(1000000), 4);
+EXPECT_EQ(ladder.lowest(), 100);
+EXPECT_EQ(ladder.highest(), 1000000);
+EXPECT_EQ(ladder.nextAbove(100), 105);
+EXPECT_EQ(ladder.nextAbove(105), 1000000);
+EXPECT_EQ(ladder.nextAbove(1000000), PRICE_LADDER_NO_TICK);
+EXPECT_EQ(ladder.nextBelow(1000000), 105);
+EXPECT_EQ(ladder.nextBelow(101), 100);
+EXPECT_EQ(ladder.nextBelow(100), PRICE_LADDER_NO_TICK);
+
+EXPECT_TRUE(ladder.erase(105));
+EXPECT_FALSE(ladder.erase(105));
+EXPECT_TRUE(ladder.erase(1000000));
+EXPECT_EQ(ladder.size(), 1);
+EXPECT_EQ(ladder.nextAbove(100), PRICE_LADDER_NO_TICK);
+EXPECT_EQ(ladder.highest(), 100);
+}
+
+TEST(PriceLadderTest, RandomDriftTest) {
+// Small window so that growing, following the market and the overflow map are all exercised
+PriceLadder<long long> ladder(0.01, 256);
+map<long long, long long> expected;
+mt19937 rng(7);
+long long center = 100000;
+
+for (int step = 0; step < 20000; ++step) {
+    center += static_cast<int>(rng() % 7) - 3;
+    ladder.follow(center);
+    long long tick = rng() % 50 == 0 ? center + static_cast<int>(rng() % 20001) - 10000 : center + static_cast<int>(rng() % 41) - 20;
+    ladder.insert(tick) += step;
+    expected[tick] += step;
+
+    // Remove a level near the market every few steps
+    if (step % 3 == 0) {
+        long long erased = center + static_cast<int>(rng() % 41) - 20;
+        ASSERT_EQ(ladder.erase(erased), expected.erase(erased) == 1);
+        ASSERT_EQ(ladder.find(erased), nullptr);
+    }
+
+    long long probe = center + static_cast<int>(rng() % 601) - 300;
+    auto above = expected.upper_bound(probe);
+    auto below = expected.lower_bound(probe);
+    ASSERT_EQ(ladder.nextAbove(probe), above == expected.end() ? PRICE_LADDER_NO_TICK : above->first);
+    ASSERT_EQ(ladder.nextBelow(probe), below == expected.begin() ? PRICE_LADDER_NO_TICK : prev(below)->first);
+}
+
+ASSERT_EQ(ladder.size(), expected.size());
+EXPECT_LE(ladder.getCapacity(), 256);
+EXPECT_GT(ladder.getNumOverflowLevels(), 0);
+
+// Walking the ladder visits every level in order
+long long tick = ladder.lowest();
+for (const auto& [expected_tick, value] : expected) {
+    ASSERT_EQ(tick, expected_tick);
+    EXPECT_EQ(*ladder.find(tick), value);
+    tick = ladder.nextAbove(tick);
+}
+EXPECT_EQ(tick, PRICE_LADDER_NO_TICK);
+EXPECT_EQ(ladder.highest(), expected.rbegin()->first);
+}
+
+TEST(PriceLadderTest, OverflowNodeReuseTest) {
+PriceLadder<int> ladder(0.01, 64);
+for (int i = 0; i <= 10; ++i) {
+    ladder.insert(i * 1000) = i;     // Far levels go to the overflow map without moving the window
+}
+size_t overflow_levels = ladder.getNumOverflowLevels();
+EXPECT_EQ(overflow_levels, 10);
+EXPECT_EQ(ladder.getNumSpareNodes(), 0);
+
+// Erased levels leave their nodes for the next levels outside the window
+for (int i = 0; i <= 10; ++i) {
+    EXPECT_TRUE(ladder.erase(i * 1000));
+}
+EXPECT_EQ(ladder.getNumSpareNodes(), overflow_levels);
+for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(ladder.insert(-i * 1000), 0);     // A reused node holds an empty level
+}
+EXPECT_EQ(ladder.getNumOverflowLevels(), 3);
+EXPECT_EQ(ladder.getNumSpareNodes(), overflow_levels - 3);
+EXPECT_EQ(ladder.lowest(), -4000);
+EXPECT_EQ(ladder.nextAbove(-4000), -3000);
+EXPECT_EQ(ladder.highest(), -1000);
+}
+
+TEST(PriceLadderTest, WindowHysteresisTest) {
+PriceLadder<int> ladder(0.01, 256);
+for (long long tick = 99990; tick <= 100010; ++tick) {
+    ladder.insert(tick) = 1;
+}
+ASSERT_EQ(ladder.getCapacity(), 256);
+long long base = ladder.getBase();
+
+// Levels far from the touch, on either side, go to the overflow map and leave the window where it is
+for (int i = 1; i <= 100; ++i) {
+    ladder.insert(100000 + (i % 2 == 0 ? i : -i) * 1000) = i;
+    ladder.insert(99990 + i % 21) += 1;
+    ladder.follow(100000 + i % 21 - 10);
+    ASSERT_EQ(ladder.getBase(), base);
+}
+EXPECT_EQ(ladder.getNumOverflowLevels(), 100);
+EXPECT_EQ(ladder.size(), 121);
+
+// A touch drifting within the middle half of the window does not move it either
+ladder.follow(base + 64);
+ladder.follow(base + 191);
+EXPECT_EQ(ladder.getBase(), base);
+
+// Past the band the window recenters on the touch; only the levels crossing its edges move
+ladder.insert(base + 250) = 7;
+ladder.follow(base + 192);
+EXPECT_EQ(ladder.getBase(), base + 64);
+EXPECT_EQ(*ladder.find(base + 250), 7);
+EXPECT_EQ(*ladder.find(102000), 2);
+EXPECT_EQ(ladder.getNumOverflowLevels(), 100);
+
+// Moving to the far levels takes them into the window and leaves the old ones in the overflow map
+ladder.follow(102000);
+EXPECT_EQ(ladder.getBase(), 102000 - 128);
+EXPECT_EQ(*ladder.find(102000), 2);
+EXPECT_NE(ladder.find(99995), nullptr);
+EXPECT_EQ(ladder.getNumOverflowLevels(), 121);
+EXPECT_EQ(ladder.nextAbove(100010), base + 250);
+EXPECT_EQ(ladder.nextAbove(base + 250), 102000);
+EXPECT_EQ(ladder.nextBelow(102000), base + 250);
+EXPECT_EQ(ladder.size(), 122);
+}
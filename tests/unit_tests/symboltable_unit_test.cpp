@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "data/eventstore.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ * Helper that builds a symbol table with every pair of the given bases and quotes on the given exchanges.
+ */
+vector<Instrument> makeSymbolTableInstruments(const vector<string>& exchanges, const vector<string>& bases, const vector<string>& quotes) {
+    vector<Instrument> instruments;
+    for (const string& exchange : exchanges) {
+        for (const string& base : bases) {
+            for (const string& quote : quotes) {
+                instruments.push_back({exchange, base + "/" + quote, MarketType::Spot});
+                instruments.push_back({exchange, base + "/" + quote, MarketType::Futures});
+            }
+        }
+    }
+    return instruments;
+}
+
+
+TEST(SymbolTableTest, FindTest) {
+SymbolTable symbols({{"Binance", "BTC/USDT", MarketType::Spot}, {"Binance", "BTC/USDT", MarketType::Futures}, {"Bybit", "ETH/USDT", MarketType::Spot}});
+ASSERT_EQ(symbols.size(), 3);
+
+EXPECT_EQ(symbols.find("Binance", "BTC/USDT", MarketType::Spot), 0);
+EXPECT_EQ(symbols.find("Binance", "BTC/USDT", MarketType::Futures), 1);
+EXPECT_EQ(symbols.find("Bybit", "ETH/USDT", MarketType::Spot), 2);
+
+// Exchange names match case-insensitively, symbols exactly
+EXPECT_EQ(symbols.find("BINANCE", "BTC/USDT", MarketType::Spot), 0);
+EXPECT_EQ(symbols.find("binance", "btc/usdt", MarketType::Spot), SYMBOL_NOT_FOUND);
+
+EXPECT_EQ(symbols.find("Bybit", "ETH/USDT", MarketType::Futures), SYMBOL_NOT_FOUND);
+EXPECT_EQ(symbols.find("Okx", "BTC/USDT", MarketType::Spot), SYMBOL_NOT_FOUND);
+EXPECT_EQ(symbols.find("", "", MarketType::Spot), SYMBOL_NOT_FOUND);
+EXPECT_EQ(SymbolTable().find("Binance", "BTC/USDT", MarketType::Spot), SYMBOL_NOT_FOUND);
+}
+
+TEST(SymbolTableTest, DuplicateTest) {
+SymbolTable symbols({{"Binance", "BTC/USDT", MarketType::Spot}, {"binance", "BTC/USDT", MarketType::Spot}, {"Bybit", "BTC/USDT", MarketType::Spot}});
+EXPECT_EQ(symbols.size(), 2);
+EXPECT_EQ(symbols.at(0).exchange, "Binance");
+EXPECT_EQ(symbols.find("Bybit", "BTC/USDT", MarketType::Spot), 1);
+}
+
+TEST(SymbolTableTest, ManyInstrumentsTest) {
+vector<Instrument> instruments = makeSymbolTableInstruments({"Binance", "Bybit", "Okx", "Coinbase", "Kraken"},
+        {"BTC", "ETH", "SOL", "XRP", "ADA", "DOGE", "DOT", "LTC", "BNB", "AVAX"}, {"USDT", "USDC", "BTC", "EUR"});
+SymbolTable symbols(instruments);
+ASSERT_EQ(symbols.size(), instruments.size());
+
+// Every instrument has its own id
+for (size_t id = 0; id < instruments.size(); ++id) {
+    EXPECT_EQ(symbols.find(instruments[id].exchange, instruments[id].symbol, instruments[id].market_type), static_cast<int>(id));
+}
+EXPECT_EQ(symbols.find("Binance", "BTC/JPY", MarketType::Spot), SYMBOL_NOT_FOUND);
+EXPECT_EQ(symbols.find("Kraken", "USDT/BTC", MarketType::Futures), SYMBOL_NOT_FOUND);
+}
+
+TEST(SymbolTableTest, InstrumentTableTest) {
+auto symbols = make_shared<const SymbolTable>(vector<Instrument>{{"Binance", "BTC/USDT", MarketType::Spot}, {"Binance", "ETH/USDT", MarketType::Spot}});
+InstrumentTable instruments(symbols);
+
+// Ids follow the order of first appearance, whether or not the instrument is in the symbol table
+EXPECT_EQ(instruments.intern("Binance", "ETH/USDT", MarketType::Spot), 0);
+EXPECT_EQ(instruments.intern("Okx", "BTC/USDT", MarketType::Spot), 1);
+EXPECT_EQ(instruments.intern("Binance", "BTC/USDT", MarketType::Spot), 2);
+EXPECT_EQ(instruments.intern("Binance", "ETH/USDT", MarketType::Spot), 0);
+EXPECT_EQ(instruments.intern("Okx", "BTC/USDT", MarketType::Spot), 1);
+EXPECT_EQ(instruments.intern("BINANCE", "BTC/USDT", MarketType::Spot), 2);
+ASSERT_EQ(instruments.size(), 3);
+EXPECT_EQ(instruments.at(1).exchange, "Okx");
+}
+
+TEST(SymbolTableTest, CsvEventSourceTest) {
+std::filesystem::path path = std::filesystem::temp_directory_path() / "symboltable_test.csv";
+{
+    ofstream file(path, ios::binary);
+    file << "HEADER\n";
+    file << "2023-01-03 09:00:00.000,0,T,BTC/USDT,Binance,S,100,1\n";
+    file << "2023-01-03 09:00:00.001,0,T,ETH/USDT,Okx,S,10,1\n";
+    file << "2023-01-03 09:00:00.002,0,T,BTC/USDT,Binance,S,101,1\n";
+}
+
+auto symbols = make_shared<const SymbolTable>(vector<Instrument>{{"Binance", "BTC/USDT", MarketType::Spot}});
+CsvEventSource with_symbols(path.string(), symbols);
+CsvEventSource without_symbols(path.string());
+
+// Decoding gives the same events and ids with or without the symbol table
+MarketEvent expected, event;
+while (without_symbols.nextEvent(expected)) {
+    ASSERT_TRUE(with_symbols.nextEvent(event));
+    EXPECT_EQ(event.timestamp, expected.timestamp);
+    EXPECT_EQ(event.instrument_id, expected.instrument_id);
+    EXPECT_EQ(event.price, expected.price);
+}
+EXPECT_FALSE(with_symbols.nextEvent(event));
+EXPECT_EQ(with_symbols.getInstruments().size(), 2);
+EXPECT_EQ(with_symbols.getInstruments().at(1).symbol, "ETH/USDT");
+}
@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+#include "data/eventmerge.h"
+#include "data/eventstore.h"
+#include "data/marketdata.h"
+#include "data/timestampindex.h"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+
+/**
+ * Helper that writes a market data file with one trade per millisecond, starting at 09:00:00.
+ */
+string writeIndexData(const string& name, int num_rows) {
+    string path = (std::filesystem::temp_directory_path() / name).string();
+    ofstream file(path, ios::binary);
+
+    file << "COLLECTION_TIME,MESSAGE_ID,MESSAGE_TYPE,SYMBOL,MARKET_CENTER,MARKET_TYPE,PRICE,SIZE\n";
+    for (int i = 0; i < num_rows; ++i) {
+        file << "2023-01-03 09:00:" << setw(2) << setfill('0') << i / 1000 << "." << setw(3) << i % 1000 << "," << i << ",T,BTC/USDT,Binance,S," << i << ",1\n";
+    }
+    return path;
+}
+
+/**
+ * Helper returning the timestamp of the i-th row written by writeIndexData.
+ */
+long long indexRowTime(int i) {
+    return parseTimestamp("2023-01-03 09:00:00") + i * 1'000'000LL;
+}
+
+
+TEST(TimestampIndexTest, BuildAndFindTest) {
+string path = writeIndexData("index_build.csv", 10000);
+MarketDataReader reader(path);
+TimestampIndex index = TimestampIndex::build(reader.getFile(), reader.getRowsOffset(), 100, 1'000'000'000);
+ASSERT_EQ(index.getEntries().size(), 100);
+EXPECT_EQ(index.getEntries()[0].offset, reader.getRowsOffset());
+
+// Time interval adds entries in sparse stretches
+EXPECT_EQ(TimestampIndex::build(reader.getFile(), reader.getRowsOffset(), 100000, 500'000'000).getEntries().size(), 20);
+
+// Reading from the offset found reaches the requested row within one interval
+for (int row : {0, 1, 99, 100, 5050, 9999}) {
+    reader.seek(index.findOffset(indexRowTime(row), reader.getRowsOffset()));
+    MarketDataReader::Row tokens;
+    ASSERT_TRUE(reader.nextRow(tokens));
+    long long first = parseTimestamp(tokens[0]);
+    EXPECT_LE(first, indexRowTime(row));
+    EXPECT_GE(first, indexRowTime(row) - 100 * 1'000'000LL);
+}
+}
+
+TEST(TimestampIndexTest, CsvSeekTest) {
+string path = writeIndexData("index_seek.csv", 10000);
+string index_path = path + TIMESTAMP_INDEX_EXTENSION;
+std::filesystem::remove(index_path);
+
+CsvEventSource source(path);
+ASSERT_TRUE(source.seek(indexRowTime(7000)));
+EXPECT_TRUE(std::filesystem::exists(index_path));
+
+MarketEvent event;
+ASSERT_TRUE(source.nextEvent(event));
+EXPECT_LE(event.timestamp, indexRowTime(7000));
+EXPECT_GT(event.timestamp, indexRowTime(7000 - TIMESTAMP_INDEX_ROW_INTERVAL));
+
+// Saved index is reused, and rebuilt once the CSV file changes
+TimestampIndex loaded;
+EXPECT_TRUE(TimestampIndex::load(index_path, FileStamp::of(path), loaded));
+writeIndexData("index_seek.csv", 5000);
+EXPECT_FALSE(TimestampIndex::load(index_path, FileStamp::of(path), loaded));
+
+CsvEventSource changed(path);
+ASSERT_TRUE(changed.seek(indexRowTime(9000)));
+EXPECT_TRUE(changed.nextEvent(event));
+EXPECT_EQ(event.price, 4000);   // Last entry of the shorter file, one per second of data
+}
+
+TEST(TimestampIndexTest, EventStoreAndMergedSeekTest) {
+string path = writeIndexData("index_store.csv", 3000);
+string store_path = path + ".seek" + EVENT_STORE_EXTENSION;
+convertMarketData(path, store_path);
+
+// Event stores seek exactly
+EventStoreReader store(store_path);
+ASSERT_TRUE(store.seek(indexRowTime(1234)));
+MarketEvent event;
+ASSERT_TRUE(store.nextEvent(event));
+EXPECT_EQ(event.timestamp, indexRowTime(1234));
+ASSERT_TRUE(store.seek(indexRowTime(5000)));
+EXPECT_FALSE(store.nextEvent(event));
+
+// Merged sources seek every input
+vector<unique_ptr<EventSource>> sources;
+sources.push_back(make_unique<EventStoreReader>(store_path));
+sources.push_back(make_unique<EventStoreReader>(store_path));
+MergedEventSource merged(std::move(sources));
+ASSERT_TRUE(merged.seek(indexRowTime(2998)));
+for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(merged.nextEvent(event));
+    EXPECT_EQ(event.timestamp, indexRowTime(2998 + i / 2));
+}
+EXPECT_FALSE(merged.nextEvent(event));
+}
+
+TEST(TimestampIndexTest, CacheDirectoryTest) {
+string path = writeIndexData("index_cached.csv", 2000);
+string cache_directory = (std::filesystem::temp_directory_path() / "index_cache_test").string();
+std::filesystem::remove_all(cache_directory);
+std::filesystem::remove(path + TIMESTAMP_INDEX_EXTENSION);
+
+// With a cache directory the index is written there, not next to the CSV file
+CsvEventSource source(path, nullptr, cache_directory);
+ASSERT_TRUE(source.seek(indexRowTime(1500)));
+string index_path = getTimestampIndexPath(path, cache_directory);
+EXPECT_EQ(std::filesystem::path(index_path).parent_path(), std::filesystem::path(cache_directory));
+EXPECT_TRUE(std::filesystem::exists(index_path));
+EXPECT_FALSE(std::filesystem::exists(path + TIMESTAMP_INDEX_EXTENSION));
+
+MarketEvent event;
+ASSERT_TRUE(source.nextEvent(event));
+EXPECT_LE(event.timestamp, indexRowTime(1500));
+std::filesystem::remove_all(cache_directory);
+}
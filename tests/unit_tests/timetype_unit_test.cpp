@@ -0,0 +1,34 @@
+#include "gtest/gtest.h"
+#include "data/timetype.h"
+#include <string>
+
+
+TEST(TimeTypeTest, ParseTimestampTest) {
+// Epoch and a timestamp from the sample trade log
+EXPECT_EQ(parseTimestamp("1970-01-01 00:00:00.000000000"), 0);
+EXPECT_EQ(parseTimestamp("2023-01-03 15:57:01.165806080"), 1672761421165806080LL);
+
+// Month lengths and leap days must be exact, not 30-day months
+EXPECT_EQ(parseTimestamp("2023-03-01 00:00:00.000000000") - parseTimestamp("2023-02-28 00:00:00.000000000"), 86400LL * 1'000'000'000);
+EXPECT_EQ(parseTimestamp("2024-03-01 00:00:00.000000000") - parseTimestamp("2024-02-28 00:00:00.000000000"), 2 * 86400LL * 1'000'000'000);
+EXPECT_EQ(parseTimestamp("2024-01-01 00:00:00.000000000") - parseTimestamp("2023-12-31 23:59:59.999999999"), 1);
+
+// Shorter or missing fractional part
+EXPECT_EQ(parseTimestamp("2023-01-03 15:57:01.5"), parseTimestamp("2023-01-03 15:57:01.500000000"));
+EXPECT_EQ(parseTimestamp("2023-01-03 15:57:01"), parseTimestamp("2023-01-03 15:57:01.000000000"));
+
+// Malformed timestamps
+EXPECT_THROW(parseTimestamp("2023-01-03"), std::invalid_argument);
+EXPECT_THROW(parseTimestamp("2023/01/03 15:57:01.165806080"), std::invalid_argument);
+EXPECT_THROW(parseTimestamp("2023-01-03 15:57:0a.165806080"), std::invalid_argument);
+EXPECT_THROW(parseTimestamp("2023-01-03 15:57:01.1658060801"), std::invalid_argument);
+}
+
+TEST(TimeTypeTest, FormatTimestampTest) {
+const char* timestamps[] = {"1970-01-01 00:00:00.000000000", "2000-02-29 12:34:56.000000001", "2023-01-03 15:57:01.165806080", "2024-12-31 23:59:59.999999999"};
+
+for (const char* timestamp : timestamps) {
+    EXPECT_EQ(formatTimestamp(parseTimestamp(timestamp)), timestamp);
+    EXPECT_EQ(TimeType(timestamp).toNanosecondsSinceEpoch(), parseTimestamp(timestamp));
+}
+}
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include "data/tokenizer.h"
+#include <charconv>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/**
+ * Helper that splits a buffer with the given instruction set and joins the rows back with '|' between fields.
+ */
+vector<string> tokenize(const string& buffer, SimdLevel level) {
+    CsvTokenizer tokenizer(buffer.data(), buffer.data() + buffer.size(), level);
+    array<string_view, 4> row;
+    vector<string> rows;
+
+    while (tokenizer.nextRow(row)) {
+        string joined;
+        for (string_view field : row) {
+            joined += string(field) + "|";
+        }
+        rows.push_back(joined);
+    }
+    return rows;
+}
+
+
+TEST(TokenizerTest, SplitRowTest) {
+// Empty lines, windows line endings, short and long rows, no final line ending
+string buffer = "a,b,c,d\n\n1,22\r\n\r\n333,4444,55555,666666,7777777\nx";
+vector<string> expected = {"a|b|c|d|", "1|22|||", "333|4444|55555|666666|", "x||||"};
+
+EXPECT_EQ(tokenize(buffer, SimdLevel::Scalar), expected);
+EXPECT_EQ(tokenize(buffer, detectSimdLevel()), expected);
+EXPECT_TRUE(tokenize("", SimdLevel::Scalar).empty());
+EXPECT_TRUE(tokenize("\n\r\n", detectSimdLevel()).empty());
+}
+
+TEST(TokenizerTest, SimdMatchesScalarTest) {
+// Random rows so delimiters land on every position of the 64 byte blocks
+mt19937 rng(42);
+string buffer;
+for (int i = 0; i < 2000; ++i) {
+    int num_fields = rng() % 6;
+    for (int j = 0; j < num_fields; ++j) {
+        buffer += string(rng() % 40, 'a' + j) + (j + 1 < num_fields ? "," : "");
+    }
+    buffer += (rng() % 4 == 0) ? "\r\n" : "\n";
+}
+
+vector<string> expected = tokenize(buffer, SimdLevel::Scalar);
+EXPECT_EQ(tokenize(buffer, SimdLevel::SSE), expected);
+EXPECT_EQ(tokenize(buffer, SimdLevel::AVX2), expected);
+}
+
+TEST(TokenizerTest, ParseDecimalTest) {
+const char* fields[] = {"0", "1", "-1", "16800.01", "0.00012345", "1.", ".5", "-0.0", "123456789.123456789", "1e3", "2.5E-4",
+        "99999999999999999999", "0.1234567890123456789012345", "9007199254740993"};
+
+// Results must be bit-identical to from_chars
+for (const char* field : fields) {
+    double expected = 0.0, value = 0.0;
+    from_chars(field, field + strlen(field), expected);
+    ASSERT_TRUE(parseDecimal(field, value)) << field;
+    EXPECT_EQ(memcmp(&value, &expected, sizeof(double)), 0) << field;
+}
+
+mt19937_64 rng(7);
+for (int i = 0; i < 100000; ++i) {
+    string field = to_string(rng() % 100000000) + "." + to_string(rng() % 100000000).substr(0, rng() % 9);
+    double expected = 0.0, value = 0.0;
+    from_chars(field.data(), field.data() + field.size(), expected);
+    ASSERT_TRUE(parseDecimal(field, value)) << field;
+    ASSERT_EQ(value, expected) << field;
+}
+
+double value = 0.0;
+EXPECT_FALSE(parseDecimal("", value));
+EXPECT_FALSE(parseDecimal("-", value));
+EXPECT_FALSE(parseDecimal("abc", value));
+EXPECT_FALSE(parseDecimal("1.2.3", value));
+EXPECT_FALSE(parseDecimal("12abc", value));
+}